@@ -0,0 +1,415 @@
+#include "ai.hpp"
+#include "pico/time.h"
+#include <cstdint>
+#include <cstring>
+
+// Bound types stored in the upper 2 bits of TTEntry::flag_move
+// An all-zero flag_move marks an empty slot
+static const uint8_t TT_LOWER = 0x40;
+static const uint8_t TT_UPPER = 0x80;
+static const uint8_t TT_EXACT = 0xC0;
+static const uint8_t TT_FLAG_MASK = 0xC0;
+static const uint8_t TT_MOVE_MASK = 0x3F;
+static const uint8_t TT_NO_MOVE = 0x3F;      // No best move stored (boards have at most 63 cells)
+
+// Scores beyond this bound are wins or losses, shifted by the ply they occur at
+static const int MATE_BOUND = 9000;
+
+// SplitMix64 step, used to fill the Zobrist table at compile time
+static constexpr uint64_t splitmix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+// Struct for storing the Zobrist keys of X and O on each of up to 64 cells
+struct ZobristKeys {
+    uint64_t keys[2][64];
+
+    constexpr ZobristKeys() : keys() {
+        for (uint i = 0; i < 2; i++) {
+            for (uint cell = 0; cell < 64; cell++) {
+                keys[i][cell] = splitmix64(i * 64 + cell + 1);
+            }
+        }
+    }
+};
+
+// Zobrist keys, generated at compile time and kept in flash
+static constexpr ZobristKeys ZOBRIST;
+
+// Returns the 4 bytes of the entry after the key, which the key is XORed with
+static inline uint32_t get_data_word(const TTEntry &entry) {
+    return static_cast<uint32_t>(static_cast<uint16_t>(entry.score)) |
+           (static_cast<uint32_t>(entry.depth) << 16) |
+           (static_cast<uint32_t>(entry.flag_move) << 24);
+}
+
+template <uint Rows, uint Cols, uint K>
+Engine<Rows, Cols, K>::Engine() : depth_limit(0), opened(0), closed(0), joined(0), finished(0) {
+    memset(workers, 0, sizeof(workers));
+    clear_table();
+}
+
+template <uint Rows, uint Cols, uint K>
+void Engine<Rows, Cols, K>::clear_table() {
+    memset(table, 0, sizeof(table));
+    for (Worker &worker : workers) {
+        memset(worker.history, 0, sizeof(worker.history));
+    }
+}
+
+template <uint Rows, uint Cols, uint K>
+void Engine<Rows, Cols, K>::set_depth_limit(const uint depth) {
+    depth_limit = depth;
+}
+
+template <uint Rows, uint Cols, uint K>
+const SearchStats &Engine<Rows, Cols, K>::get_stats() {
+    return workers[0].stats;
+}
+
+template <uint Rows, uint Cols, uint K>
+uint32_t Engine<Rows, Cols, K>::get_nodes_per_sec() {
+    const SearchStats &stats = workers[0].stats;
+    if (stats.elapsed_us == 0) {
+        return 0;
+    }
+    return static_cast<uint32_t>((stats.nodes * 1000000ull) / stats.elapsed_us);
+}
+
+template <uint Rows, uint Cols, uint K>
+uint Engine<Rows, Cols, K>::get_tt_hit_rate() {
+    const SearchStats &stats = workers[0].stats;
+    if (stats.tt_probes == 0) {
+        return 0;
+    }
+    return static_cast<uint>((100ull * stats.tt_hits) / stats.tt_probes);
+}
+
+template <uint Rows, uint Cols, uint K>
+bool Engine<Rows, Cols, K>::is_win_at(const Mask mask, const uint cell) {
+    // Only the lines through the cell can have been completed by the move
+    const Mask *lines = Geometry::CELL_LINES[cell].data();
+    for (uint i = 0; i < Geometry::CELL_LINE_COUNT[cell]; i++) {
+        if ((mask & lines[i]) == lines[i]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+template <uint Rows, uint Cols, uint K>
+int Engine<Rows, Cols, K>::evaluate(const Mask me, const Mask opp) {
+    int score = 0;
+    for (uint i = 0; i < Geometry::NUMBER_OF_WIN_MASKS; i++) {
+        Mask line = Geometry::WIN_MASKS[i];
+        int mine = __builtin_popcountll(me & line);
+        int theirs = __builtin_popcountll(opp & line);
+        // A line still open for only one side counts quadratically in its marks
+        if (theirs == 0) {
+            score += mine * mine;
+        } else if (mine == 0) {
+            score -= theirs * theirs;
+        }
+    }
+    return score;
+}
+
+template <uint Rows, uint Cols, uint K>
+uint Engine<Rows, Cols, K>::order_moves(const Worker &worker, const Mask occupied,
+                                        const int tt_move, uint8_t *moves) {
+    uint32_t scores[CELLS];
+    uint n = 0;
+
+    for (uint cell = 0; cell < CELLS; cell++) {
+        if ((occupied >> cell) & 1) {
+            continue;
+        }
+        // Best move from the table first, then by history, then by the
+        // number of winning lines through the cell (center before edges)
+        uint32_t score = (static_cast<int>(cell) == tt_move) ? UINT32_MAX
+                         : (worker.history[cell] << 5) + Geometry::CELL_LINE_COUNT[cell];
+
+        // Insertion sort, boards have at most 64 cells
+        uint i = n++;
+        while (i > 0 && scores[i - 1] < score) {
+            scores[i] = scores[i - 1];
+            moves[i] = moves[i - 1];
+            i--;
+        }
+        scores[i] = score;
+        moves[i] = static_cast<uint8_t>(cell);
+    }
+    return n;
+}
+
+template <uint Rows, uint Cols, uint K>
+int Engine<Rows, Cols, K>::negamax(Worker &worker, const Mask me, const Mask opp,
+                                   const uint side, const uint64_t key, const int depth,
+                                   int alpha, int beta, const int ply, const int last_cell) {
+    SearchStats &stats = worker.stats;
+    stats.nodes++;
+
+    // Check the clock every few hundred nodes and unwind once the budget is
+    // spent, or for the helper, once the search it helps has ended
+    if ((stats.nodes % NODES_PER_TIME_CHECK) == 0 &&
+        (time_us_64() >= worker.deadline ||
+         (worker.is_helper && closed.load(std::memory_order_relaxed) == worker.ticket))) {
+        worker.is_aborted = true;
+    }
+    if (worker.is_aborted) {
+        return 0;
+    }
+
+    // The opponent's last move may have ended the game
+    if (last_cell >= 0 && is_win_at(opp, static_cast<uint>(last_cell))) {
+        return -(WIN_SCORE - ply);
+    }
+    const Mask occupied = me | opp;
+    if (occupied == Geometry::FULL_BOARD) {
+        return 0;
+    }
+    if (depth == 0) {
+        return evaluate(me, opp);
+    }
+
+    // Probe the transposition table
+    const int alpha_orig = alpha;
+    const int beta_orig = beta;
+    TTEntry &entry = table[key & (TT_SIZE - 1)];
+    const uint32_t check = static_cast<uint32_t>(key >> 32);
+    int tt_move = -1;
+    stats.tt_probes++;
+    // Work on a copy, the other core may be writing the slot
+    const TTEntry probe = entry;
+    if ((probe.key ^ get_data_word(probe)) == check && probe.flag_move != 0) {
+        stats.tt_hits++;
+        if ((probe.flag_move & TT_MOVE_MASK) != TT_NO_MOVE) {
+            tt_move = probe.flag_move & TT_MOVE_MASK;
+        }
+        if (probe.depth >= depth) {
+            // Scores of won or lost positions are stored relative to the node
+            int score = probe.score;
+            if (score > MATE_BOUND) {
+                score -= ply;
+            } else if (score < -MATE_BOUND) {
+                score += ply;
+            }
+
+            uint8_t flag = probe.flag_move & TT_FLAG_MASK;
+            if (flag == TT_EXACT) {
+                return score;
+            } else if (flag == TT_LOWER && score > alpha) {
+                alpha = score;
+            } else if (flag == TT_UPPER && score < beta) {
+                beta = score;
+            }
+            if (alpha >= beta) {
+                return score;
+            }
+        }
+    }
+
+    uint8_t moves[CELLS];
+    const uint n = order_moves(worker, occupied, tt_move, moves);
+    int best = -WIN_SCORE - 1;
+    uint8_t best_move = TT_NO_MOVE;
+
+    for (uint i = 0; i < n; i++) {
+        const uint cell = moves[i];
+        const Mask bit = static_cast<Mask>(static_cast<Mask>(1) << cell);
+        int score = -negamax(worker, opp, me | bit, side ^ 1, key ^ ZOBRIST.keys[side][cell],
+                             depth - 1, -beta, -alpha, ply + 1, static_cast<int>(cell));
+        if (worker.is_aborted) {
+            return 0;
+        }
+        if (score > best) {
+            best = score;
+            best_move = static_cast<uint8_t>(cell);
+        }
+        if (best > alpha) {
+            alpha = best;
+        }
+        if (alpha >= beta) {
+            // Reward moves that cause cutoffs so they are tried early elsewhere
+            worker.history[cell] += static_cast<uint32_t>(depth * depth);
+            break;
+        }
+    }
+
+    // Store the result, always replacing the previous entry
+    int stored = best;
+    if (stored > MATE_BOUND) {
+        stored += ply;
+    } else if (stored < -MATE_BOUND) {
+        stored -= ply;
+    }
+    uint8_t flag = (best <= alpha_orig) ? TT_UPPER : (best >= beta_orig) ? TT_LOWER : TT_EXACT;
+    TTEntry update;
+    update.score = static_cast<int16_t>(stored);
+    update.depth = static_cast<uint8_t>(depth);
+    update.flag_move = static_cast<uint8_t>(flag | best_move);
+    update.key = check ^ get_data_word(update);
+    entry = update;
+
+    return best;
+}
+
+template <uint Rows, uint Cols, uint K>
+void Engine<Rows, Cols, K>::search_root(Worker &worker, const Board &board, const char player,
+                                        const uint first_depth) {
+    SearchStats &stats = worker.stats;
+    worker.is_aborted = false;
+    worker.best_move = -1;
+    memset(&stats, 0, sizeof(stats));
+
+    // Age the history scores so earlier games don't dominate move ordering
+    for (uint cell = 0; cell < CELLS; cell++) {
+        worker.history[cell] >>= 1;
+    }
+
+    // Orient the board so the engine is the side to move
+    const uint side = (player == 'X') ? 0 : 1;
+    const Mask me = (side == 0) ? board.x : board.o;
+    const Mask opp = (side == 0) ? board.o : board.x;
+    const Mask occupied = me | opp;
+
+    uint64_t key = 0;
+    for (uint cell = 0; cell < CELLS; cell++) {
+        if ((board.x >> cell) & 1) {
+            key ^= ZOBRIST.keys[0][cell];
+        } else if ((board.o >> cell) & 1) {
+            key ^= ZOBRIST.keys[1][cell];
+        }
+    }
+
+    uint8_t moves[CELLS];
+    const uint n = order_moves(worker, occupied, -1, moves);
+    if (n == 0) {
+        return;
+    }
+    const uint max_depth = (depth_limit > 0 && depth_limit < n) ? depth_limit : n;
+
+    // Fall back to the best-ordered move if not even the first depth completes
+    int best_move = moves[0];
+
+    // Iterative deepening: each completed depth refines the best move, and
+    // its best move is searched first at the next depth
+    for (uint depth = first_depth; depth <= max_depth; depth++) {
+        const uint count = order_moves(worker, occupied, best_move, moves);
+        int alpha = -WIN_SCORE - 1;
+        int iteration_move = moves[0];
+
+        for (uint i = 0; i < count; i++) {
+            const uint cell = moves[i];
+            const Mask bit = static_cast<Mask>(static_cast<Mask>(1) << cell);
+            int score = -negamax(worker, opp, me | bit, side ^ 1, key ^ ZOBRIST.keys[side][cell],
+                                 depth - 1, -WIN_SCORE - 1, -alpha, 1, static_cast<int>(cell));
+            if (worker.is_aborted) {
+                break;
+            }
+            if (score > alpha) {
+                alpha = score;
+                iteration_move = static_cast<int>(cell);
+            }
+        }
+
+        if (worker.is_aborted) {
+            // Keep the result of the last completed depth
+            break;
+        }
+
+        best_move = iteration_move;
+        stats.depth = depth;
+        stats.score = alpha;
+
+        // Stop early once the game-theoretic result is known
+        if (alpha > MATE_BOUND || alpha < -MATE_BOUND) {
+            break;
+        }
+    }
+
+    worker.best_move = best_move;
+}
+
+template <uint Rows, uint Cols, uint K>
+int Engine<Rows, Cols, K>::find_best_move(const Board &board, const char player,
+                                          const uint64_t budget_us) {
+    const uint64_t start = time_us_64();
+    Worker &worker = workers[0];
+    worker.deadline = start + budget_us;
+    worker.is_helper = false;
+
+    // Without open_search() the ticket is already closed and no helper joins
+    const uint16_t ticket = opened.load();
+    const bool is_open = closed.load() != ticket;
+    search_root(worker, board, player, 1);
+
+    // End the search, then wait for a helper that joined it to unwind, at
+    // most a few hundred nodes. Storing closed before loading joined, while
+    // help() stores joined before loading closed, means that a helper this
+    // misses has seen the search end and did not start
+    closed.store(ticket);
+    if (is_open && joined.load() == ticket) {
+        const uint64_t stop_deadline = time_us_64() + HELPER_STOP_TIMEOUT_US;
+        while (finished.load() != ticket && time_us_64() < stop_deadline) {
+            tight_loop_contents();
+        }
+
+        // The helper's statistics are complete once it has finished
+        if (finished.load() == ticket) {
+            const Worker &helper = workers[1];
+            SearchStats &stats = worker.stats;
+            stats.helper_nodes = helper.stats.nodes;
+            stats.nodes += helper.stats.nodes;
+            stats.tt_probes += helper.stats.tt_probes;
+            stats.tt_hits += helper.stats.tt_hits;
+            // The helper searches a ply ahead and may have completed a deeper iteration
+            if (helper.best_move >= 0 && helper.stats.depth > stats.depth) {
+                worker.best_move = helper.best_move;
+                stats.depth = helper.stats.depth;
+                stats.score = helper.stats.score;
+            }
+        }
+    }
+
+    worker.stats.elapsed_us = time_us_64() - start;
+    return worker.best_move;
+}
+
+template <uint Rows, uint Cols, uint K>
+uint16_t Engine<Rows, Cols, K>::open_search() {
+    const uint16_t ticket = static_cast<uint16_t>(opened.load() + 1);
+    opened.store(ticket);
+    return ticket;
+}
+
+template <uint Rows, uint Cols, uint K>
+void Engine<Rows, Cols, K>::help(const Board &board, const char player, const uint64_t budget_us,
+                                 const uint16_t ticket) {
+    Worker &worker = workers[1];
+    joined.store(ticket);
+    if (opened.load() != ticket || closed.load() == ticket) {
+        // Too late, or a request for an older search
+        memset(&worker.stats, 0, sizeof(worker.stats));
+        worker.best_move = -1;
+        finished.store(ticket);
+        return;
+    }
+
+    worker.deadline = time_us_64() + budget_us;
+    worker.ticket = ticket;
+    worker.is_helper = true;
+    // One ply ahead of find_best_move, so the two cores mostly fill the
+    // table with different depths instead of searching the same nodes
+    search_root(worker, board, player, 2);
+    finished.store(ticket);
+}
+
+// Board variants built into the firmware
+template class Engine<3, 3, 3>;
+template class Engine<4, 4, 4>;
+template class Engine<5, 5, 4>;
+template class Engine<7, 7, 5>;
@@ -0,0 +1,172 @@
+#ifndef __AI_HPP__
+#define __AI_HPP__
+
+#include "bitboard.hpp"
+#include "pico/stdlib.h"
+#include <atomic>
+#include <stdint.h>
+
+// Number of transposition table entries as a power of two
+// Each entry takes 8 bytes, so the default of 12 bits uses 32 KB of SRAM
+#ifndef AI_TT_BITS
+#define AI_TT_BITS 12
+#endif
+
+// Default time budget of one engine reply in microseconds
+#ifndef AI_BUDGET_US
+#define AI_BUDGET_US 200000
+#endif
+
+// Struct for storing the statistics of the last search
+// @field nodes Number of positions visited, by both cores in a parallel search
+// @field helper_nodes Number of them visited by the helper
+// @field elapsed_us Wall time of the search in microseconds
+// @field tt_probes Number of transposition table lookups
+// @field tt_hits Number of lookups that found the position
+// @field depth Deepest fully completed iteration
+// @field score Score of the best move from the engine's point of view
+typedef struct {
+    uint64_t nodes;
+    uint64_t helper_nodes;
+    uint64_t elapsed_us;
+    uint32_t tt_probes;
+    uint32_t tt_hits;
+    uint depth;
+    int score;
+} SearchStats;
+
+// Struct for storing one transposition table entry (8 bytes)
+// Both cores write the table without a lock during a parallel search, so the
+// key is stored XORed with the other 4 bytes: an entry torn by two writers
+// fails the key check instead of pairing one position with another's score
+// @field key Upper 32 bits of the position's Zobrist hash, XOR the data word
+// @field score Score relative to the side to move
+// @field depth Remaining depth the score was searched to
+// @field flag_move Bound type in the upper 2 bits, best move in the lower 6 bits
+typedef struct {
+    uint32_t key;
+    int16_t score;
+    uint8_t depth;
+    uint8_t flag_move;
+} TTEntry;
+
+// Negamax alpha-beta engine for the Rows x Cols, K-in-a-row game
+// Searches with iterative deepening until the time budget runs out and keeps
+// its transposition table inside the object, so a static Engine lives in .bss
+// The search can use both cores (lazy SMP): the other core or thread runs
+// help() on the same position while find_best_move runs, with its own move
+// history and one ply ahead, and the two only share the table. Each finds
+// cutoffs and best moves the other then reads, so the pair reaches a depth
+// sooner than one core. The owner opens the search with open_search(),
+// passes the ticket to the helper, e.g. in a MSG_SEARCH_REQUEST, and calls
+// find_best_move, which stops the helper at its end and keeps the deeper of
+// the two results. Without a helper find_best_move searches alone
+template <uint Rows, uint Cols, uint K>
+class Engine {
+    public:
+        typedef BoardGeometry<Rows, Cols, K> Geometry;
+        typedef BasicBitboard<Rows * Cols> Board;
+        typedef typename Board::Mask Mask;
+
+        static const uint CELLS = Rows * Cols;
+        static const uint TT_SIZE = 1u << AI_TT_BITS;
+        static const int WIN_SCORE = 10000;          // Score of a won position
+        static const uint NODES_PER_TIME_CHECK = 256;
+        static const uint64_t HELPER_STOP_TIMEOUT_US = 10000;  // Wait for the helper to stop
+
+        // Constructor
+        Engine();
+
+        // Returns the best cell for the side to move, or -1 if the board is full
+        // @param board The current state of the board
+        // @param player The engine's character (X or O)
+        // @param budget_us Time budget of the search in microseconds
+        int find_best_move(const Board &board, const char player, const uint64_t budget_us);
+
+        // Opens a parallel search, to be run by the next find_best_move
+        // @return Ticket to pass to the helper
+        uint16_t open_search();
+
+        // Helps the search opened with the ticket, on the other core or thread:
+        // searches the same position until find_best_move ends or the budget
+        // runs out. Returns at once if that search has already ended
+        // @param board, player, budget_us As given to find_best_move
+        // @param ticket Returned by open_search
+        void help(const Board &board, const char player, const uint64_t budget_us,
+                  const uint16_t ticket);
+
+        // Limits the iterative deepening to the depth, e.g. to time a fixed
+        // depth; 0 searches until the budget runs out
+        void set_depth_limit(const uint depth);
+
+        // Returns the statistics of the last search
+        const SearchStats &get_stats();
+
+        // Returns the number of nodes searched per second in the last search
+        uint32_t get_nodes_per_sec();
+
+        // Returns the transposition table hit rate of the last search in percent
+        uint get_tt_hit_rate();
+
+        // Empties the transposition table
+        void clear_table();
+
+    private:
+        // Struct for storing the state of the search on one core
+        // @field history Cutoff rewards of each cell, for move ordering
+        // @field stats Statistics of the core's last search
+        // @field deadline Time at which the search is aborted
+        // @field ticket Search helped, checked for its end (helper only)
+        // @field best_move Best move of the deepest completed iteration, -1 if none
+        // @field is_helper Whether the core helps find_best_move
+        // @field is_aborted Whether the search is unwinding
+        typedef struct {
+            uint32_t history[CELLS];
+            SearchStats stats;
+            uint64_t deadline;
+            uint16_t ticket;
+            int best_move;
+            bool is_helper;
+            bool is_aborted;
+        } Worker;
+
+        // Shared by the cores
+        TTEntry table[TT_SIZE];
+
+        // find_best_move's core, then help()'s
+        Worker workers[2];
+        uint depth_limit;
+
+        // Tickets of the last search opened and ended by find_best_move, of
+        // the search the helper joined and of the one it finished. Only
+        // loads and stores, which are lock-free on the Cortex-M0+
+        std::atomic<uint16_t> opened;
+        std::atomic<uint16_t> closed;
+        std::atomic<uint16_t> joined;
+        std::atomic<uint16_t> finished;
+
+        // Iterative deepening from the root, the core's result in worker.best_move
+        // @param first_depth Depth of the first iteration
+        void search_root(Worker &worker, const Board &board, const char player,
+                         const uint first_depth);
+
+        // Negamax search of the position with the side to move owning "me"
+        // @param side Side to move, 0 for X and 1 for O (selects the Zobrist keys)
+        // @param last_cell Cell of the opponent's last move, checked for a win
+        int negamax(Worker &worker, const Mask me, const Mask opp, const uint side,
+                    const uint64_t key, const int depth, int alpha, int beta, const int ply,
+                    const int last_cell);
+
+        // Static evaluation from the side to move's point of view
+        int evaluate(const Mask me, const Mask opp);
+
+        // Fills moves with the empty cells, best candidates first
+        // @return Number of moves
+        uint order_moves(const Worker &worker, const Mask occupied, const int tt_move,
+                         uint8_t *moves);
+
+        // Returns true if the player owning mask completed a line through cell
+        bool is_win_at(const Mask mask, const uint cell);
+};
+
+#endif  // __AI_HPP__
@@ -0,0 +1,798 @@
+#include "classifier.hpp"
+#include "game.hpp"
+#include "gesture.hpp"
+#include "output.hpp"
+#include "session_pool.hpp"
+#include "text.hpp"
+#include "hardware/gpio.h"
+#include "pico/stdio.h"
+#include "pico/time.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if PICO_ON_DEVICE
+#include "hardware/clocks.h"
+#include "pico/stdio_usb.h"
+#else
+#include <time.h>
+#endif
+
+// Benchmarks of the per-move hot path and of complete scripted games
+// Runs on the host (against the simulator's stand-in SDK) and on the Pico,
+// timing with the monotonic clock and time_us_64 respectively. The results
+// are written as JSON, one benchmark per line, and can be checked against a
+// baseline so that regressions of the move path fail the run
+
+namespace {
+
+// Every sample runs for at least this long, the fastest of SAMPLES counts
+const uint64_t MIN_SAMPLE_NS = 20000000;
+const uint SAMPLES = 5;
+
+// Number of positions the per-move benchmarks cycle through (a power of 2)
+const uint POSITIONS = 64;
+
+// Number of scripted games played per iteration of the game benchmark
+const uint GAMES = 16;
+
+// Number of boards of the classifier sweep: every base-3 encoding of the
+// 3x3 board, random encodings of the larger boards
+#if PICO_ON_DEVICE
+const uint64_t RANDOM_SWEEP_BOARDS = 8192;
+#else
+const uint64_t RANDOM_SWEEP_BOARDS = 65536;
+#endif
+const uint64_t SWEEP_BOARDS = (TicTacToe::CELLS <= 9) ? 19683 : RANDOM_SWEEP_BOARDS;
+
+// Number of gestures the transition benchmarks route per iteration (a power of 2)
+const uint ROUTES = 1024;
+
+// Numbers of open sessions the session pool is timed with
+const uint POOL_SESSIONS[] = {1, 64, 1024};
+
+// Maximum number of benchmark results
+const uint MAX_RESULTS = 24;
+
+// A tap as the host scripts make it: pressed for 100 ms, then a 150 ms pause
+const uint32_t TAP_MS = 250;
+const uint32_t TAP_PAUSE_MS = 150;
+
+// Default slowdown in percent above which a benchmark counts as a regression
+const double DEFAULT_TOLERANCE = 10.0;
+
+typedef TicTacToe::Board Board;
+typedef BatchClassifier<TicTacToe::ROWS, TicTacToe::COLS, TicTacToe::WIN_LENGTH> Classifier;
+typedef SessionPool<TicTacToe::ROWS, TicTacToe::COLS, TicTacToe::WIN_LENGTH> Pool;
+
+// Struct for storing a position to time the move functions on
+// @field board The marks on the board
+// @field player The player to move
+// @field free_cell An empty cell the player can move to
+typedef struct {
+    Board board;
+    char player;
+    uint free_cell;
+} Position;
+
+// Struct for storing a complete game as the cells played in turn
+// @field cells The cells played, starting with X
+// @field length Number of moves until the game was won or tied
+typedef struct {
+    uint8_t cells[TicTacToe::CELLS];
+    uint length;
+} Script;
+
+// Struct for storing the result of one benchmark
+// @field name Name of the benchmark
+// @field iterations Number of operations timed over all samples
+// @field ns_per_op Time per operation of the fastest sample
+typedef struct {
+    char name[32];
+    uint64_t iterations;
+    double ns_per_op;
+} BenchResult;
+
+// Struct for storing what it takes a player to make the scripted moves
+// @field moves Moves made
+// @field linear_presses Presses with the cursor stepping through every
+//        cell from cell 0, as before skip-to-empty navigation
+// @field presses Presses with skip-to-empty taps or a held reverse
+// @field linear_ms Time the linear presses take at the tap rate
+// @field ms Time of the presses, holds lasting until the last repeat
+typedef struct {
+    uint64_t moves;
+    uint64_t linear_presses;
+    uint64_t presses;
+    uint64_t linear_ms;
+    uint64_t ms;
+} Navigation;
+
+// Statically allocated, like the firmware's, as the renderer's frame
+// buffers don't fit on core 0's 2 KB stack
+TicTacToe game;
+Position positions[POSITIONS];
+Script scripts[GAMES];
+
+// Classifier sweep in struct-of-arrays layout, and its results
+TicTacToe::Mask sweep_x[SWEEP_BOARDS];
+TicTacToe::Mask sweep_o[SWEEP_BOARDS];
+uint8_t sweep_classes[SWEEP_BOARDS];
+uint8_t sweep_reference[SWEEP_BOARDS];
+// Session pool, each session replaying a script, and one pass of its moves
+Pool pool;
+uint8_t session_steps[Pool::CAPACITY];
+SessionMove session_moves[Pool::CAPACITY];
+uint8_t session_outcomes[Pool::CAPACITY];
+uint64_t session_errors = 0;
+
+// Random gestures made in the phases a player can see, and the actions the
+// table and the branches chose for them
+Gesture route_gestures[ROUTES];
+GamePhase route_phases[ROUTES];
+uint8_t route_actions[ROUTES];
+uint8_t route_reference[ROUTES];
+
+BenchResult results[MAX_RESULTS];
+uint number_of_results = 0;
+Navigation navigation = {0, 0, 0, 0, 0};
+
+// Bytes of frames the renderer produced, written nowhere
+uint64_t rendered_bytes = 0;
+
+// Renderer sink that only counts the bytes of the frames
+void null_sink(const char *data, size_t length) {
+    (void)data;
+    rendered_bytes += length;
+}
+
+// Record sink that drops the records of the finished games
+void null_record_sink(const uint8_t *record, size_t length) {
+    (void)record;
+    (void)length;
+}
+
+// Output sink that drops the drained bytes
+void null_output_sink(const char *data, size_t length) {
+    (void)data;
+    (void)length;
+}
+
+// Returns the time in nanoseconds from a clock that never goes back
+uint64_t now_ns() {
+#if PICO_ON_DEVICE
+    return time_us_64() * 1000;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<uint64_t>(now.tv_sec) * 1000000000 + static_cast<uint64_t>(now.tv_nsec);
+#endif
+}
+
+// Keeps the compiler from optimizing away a result that is otherwise unused
+template <typename T>
+inline void keep(const T &value) {
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+// Returns the next number of a xorshift generator, so every run times the
+// same positions and games
+uint32_t next_random(uint32_t *state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+// Returns a random empty cell of the board, which must not be full
+uint random_free_cell(const Board &board, uint32_t *state) {
+    while (true) {
+        uint cell = next_random(state) % TicTacToe::CELLS;
+        if (game.is_empty_pos(cell / TicTacToe::COLS, cell % TicTacToe::COLS, board)) {
+            return cell;
+        }
+    }
+}
+
+// Places the player's mark at cell without touching the renderer
+void place(Board *board, const char player, const uint cell) {
+    TicTacToe::Mask mask = static_cast<TicTacToe::Mask>(static_cast<TicTacToe::Mask>(1) << cell);
+    if (player == TicTacToe::X) {
+        board->x |= mask;
+    } else {
+        board->o |= mask;
+    }
+}
+
+// Fills positions[] with random positions reached by legal play, each with
+// at least one empty cell and no winner yet
+void make_positions(uint32_t *state) {
+    for (uint i = 0; i < POSITIONS; i++) {
+        Position &position = positions[i];
+        position.board = {0, 0};
+        position.player = TicTacToe::X;
+        uint length = next_random(state) % TicTacToe::CELLS;
+        for (uint move = 0; move < length; move++) {
+            uint cell = random_free_cell(position.board, state);
+            Board next = position.board;
+            place(&next, position.player, cell);
+            if (game.is_win_at(position.player, cell, next)) {
+                break;
+            }
+            position.board = next;
+            position.player = game.get_new_player(position.player);
+        }
+        position.free_cell = random_free_cell(position.board, state);
+    }
+}
+
+// Fills scripts[] with random games played until a win or a tie
+void make_scripts(uint32_t *state) {
+    for (uint i = 0; i < GAMES; i++) {
+        Script &script = scripts[i];
+        Board board = {0, 0};
+        char player = TicTacToe::X;
+        script.length = 0;
+        while (true) {
+            uint cell = random_free_cell(board, state);
+            place(&board, player, cell);
+            script.cells[script.length++] = static_cast<uint8_t>(cell);
+            if (game.is_win_at(player, cell, board) || game.is_tie(board)) {
+                break;
+            }
+            player = game.get_new_player(player);
+        }
+    }
+}
+
+// Fills the classifier sweep with every encoding of a 3x3 board, or with
+// random encodings of a larger one (one random digit per cell)
+void make_sweep(uint32_t *state) {
+    for (uint64_t i = 0; i < SWEEP_BOARDS; i++) {
+        uint64_t code = i;
+        if (TicTacToe::CELLS > 9) {
+            code = 0;
+            for (uint cell = 0; cell < TicTacToe::CELLS; cell++) {
+                code = 3 * code + next_random(state) % 3;
+            }
+        }
+        Classifier::decode(code, &sweep_x[i], &sweep_o[i]);
+    }
+}
+
+// Plays a script with button presses: btn1 until the cursor is on the
+// cell, then btn2, as a player at the board would
+void play(const Script &script) {
+    TicTacToe::State state = {};
+    game.dispatch(&state, GAME_EVENT_RESET_CONFIRMED);
+    for (uint i = 0; i < script.length; i++) {
+        while (state.cursor != script.cells[i]) {
+            game.dispatch(&state, GAME_EVENT_CURSOR_NEXT);
+        }
+        game.dispatch(&state, GAME_EVENT_PLACE);
+    }
+    keep(state);
+}
+
+// Fills the route inputs with random gestures of the three buttons in the
+// idle, playing and won phases
+void make_routes(uint32_t *state) {
+    const GamePhase phases[3] = {GAME_PHASE_IDLE, GAME_PHASE_PLAYING, GAME_PHASE_WON};
+    for (uint i = 0; i < ROUTES; i++) {
+        Gesture &gesture = route_gestures[i];
+        gesture.button = static_cast<uint8_t>(next_random(state) % Input::NUMBER_OF_BUTTONS);
+        gesture.type = static_cast<GestureType>(next_random(state) % (GESTURE_CHORD + 1));
+        gesture.modifier = static_cast<uint8_t>(next_random(state) % Input::NUMBER_OF_BUTTONS);
+        gesture.edge_us = 0;
+        route_phases[i] = phases[next_random(state) % 3];
+    }
+}
+
+// Returns the action of a gesture from the state machine's two tables
+uint8_t route_by_table(const Gesture &gesture, const GamePhase phase) {
+    GameEvent event = GameMachine::get_gesture_event(gesture);
+    if (event == GAME_EVENT_NONE) {
+        return GAME_ACTION_NONE;
+    }
+    return GameMachine::get_transition(event, phase).action;
+}
+
+// Returns the action of a gesture as the branches of main() and the button
+// handlers chose it before the transition table, from the game over flag
+// and the board
+uint8_t route_by_branches(const Gesture &gesture, const bool is_game_over, 
+                          const bool is_empty) {
+    GestureType type = gesture.type;
+    if (type == GESTURE_CHORD) {
+        if (gesture.button == 2 && gesture.modifier == 0) {
+            return is_game_over ? GAME_ACTION_GAME_OVER : GAME_ACTION_UNDO;
+        }
+        type = GESTURE_PRESS;
+    }
+
+    if (gesture.button == 0 && !is_game_over) {
+        // Forward on the release of a tap, so a long press only steps back
+        if (type == GESTURE_LONG_PRESS || type == GESTURE_REPEAT) {
+            return GAME_ACTION_CURSOR_BACK;
+        }
+        bool is_forward = (type == GESTURE_TAP || gesture.type == GESTURE_CHORD);
+        return is_forward ? GAME_ACTION_CURSOR_NEXT : GAME_ACTION_NONE;
+    } else if (gesture.button == 1 && (type == GESTURE_PRESS || type == GESTURE_DOUBLE_CLICK) && 
+               !is_game_over) {
+        return GAME_ACTION_PLACE;
+    } else if (gesture.button == 2 && (type == GESTURE_PRESS || type == GESTURE_DOUBLE_CLICK)) {
+#ifdef CONFIRM_RESET
+        bool is_in_progress = !is_game_over && !is_empty;
+        return (type == GESTURE_DOUBLE_CLICK || !is_in_progress) ? GAME_ACTION_RESET 
+                                                                 : GAME_ACTION_ASK_CONFIRMATION;
+#else
+        (void)is_empty;
+        return (type == GESTURE_PRESS) ? GAME_ACTION_RESET : GAME_ACTION_NONE;
+#endif
+    }
+    return GAME_ACTION_NONE;
+}
+
+// Applies the next move of every one of the first sessions in one pass, as
+// a server would with its clients' moves, and restarts the finished games
+void play_sessions(const uint sessions) {
+    for (uint session = 0; session < sessions; session++) {
+        session_moves[session].session = static_cast<uint16_t>(session);
+        session_moves[session].cell = scripts[session % GAMES].cells[session_steps[session]];
+    }
+    pool.apply(session_moves, sessions, session_outcomes);
+    for (uint session = 0; session < sessions; session++) {
+        uint8_t outcome = session_outcomes[session];
+        if (outcome == MOVE_PLACED) {
+            session_steps[session]++;
+            continue;
+        }
+        // A script ends on its win or tie, anything else is a bug
+        session_errors += (outcome == MOVE_WON || outcome == MOVE_TIED) ? 0 : 1;
+        pool.reset(session);
+        session_steps[session] = 0;
+    }
+}
+
+// Counts the presses and the time it takes a player to make the scripted
+// moves: tapping btn1 forward, or holding it for a long press and repeats
+// backward, whichever is quicker, then tapping btn2
+void count_navigation() {
+    for (uint i = 0; i < GAMES; i++) {
+        const Script &script = scripts[i];
+        Board board = {0, 0};
+        char player = TicTacToe::X;
+        uint cursor = 0;
+        for (uint move = 0; move < script.length; move++) {
+            uint cell = script.cells[move];
+
+            uint forward = 0;
+            for (uint at = cursor; at != cell; at = game.find_empty_cell(at, board, false)) {
+                forward++;
+            }
+            uint backward = 0;
+            for (uint at = cursor; at != cell; at = game.find_empty_cell(at, board, true)) {
+                backward++;
+            }
+            uint64_t forward_ms = forward * TAP_MS;
+            uint64_t backward_ms = (backward == 0) ? 0 : Gestures::LONG_PRESS_MS + 
+                                   (backward - 1) * Gestures::REPEAT_MS + TAP_PAUSE_MS;
+
+            navigation.moves++;
+            navigation.linear_presses += cell + 1;
+            navigation.linear_ms += (cell + 1) * TAP_MS;
+            navigation.presses += ((backward_ms < forward_ms) ? 1 : forward) + 1;
+            navigation.ms += ((backward_ms < forward_ms) ? backward_ms : forward_ms) + TAP_MS;
+
+            // The cursor parks on the first empty cell after a move
+            place(&board, player, cell);
+            player = game.get_new_player(player);
+            cursor = game.find_empty_cell(TicTacToe::CELLS - 1, board, false);
+        }
+    }
+}
+
+// Times body(i) for i = 0, 1, ... and records the time per call, or per
+// item if every call handles items of them
+// The batch doubles until a sample takes MIN_SAMPLE_NS, then the fastest
+// of SAMPLES samples of that batch counts, which filters out preemption
+// on the host and USB interrupts on the Pico
+template <typename Body>
+void measure(const char *name, Body body, const uint64_t items = 1) {
+    uint64_t batch = 1;
+    uint64_t elapsed = 0;
+    uint64_t iterations = 0;
+    while (true) {
+        uint64_t start = now_ns();
+        for (uint64_t i = 0; i < batch; i++) {
+            body(i);
+        }
+        elapsed = now_ns() - start;
+        iterations += batch;
+        if (elapsed >= MIN_SAMPLE_NS) {
+            break;
+        }
+        batch *= 2;
+    }
+
+    uint64_t best = elapsed;
+    for (uint sample = 1; sample < SAMPLES; sample++) {
+        uint64_t start = now_ns();
+        for (uint64_t i = 0; i < batch; i++) {
+            body(i);
+        }
+        elapsed = now_ns() - start;
+        iterations += batch;
+        best = (elapsed < best) ? elapsed : best;
+    }
+
+    if (number_of_results < MAX_RESULTS) {
+        BenchResult &result = results[number_of_results++];
+        snprintf(result.name, sizeof(result.name), "%s", name);
+        result.iterations = iterations * items;
+        result.ns_per_op = static_cast<double>(best) / static_cast<double>(batch * items);
+    }
+}
+
+// Sets up the pins and LEDs like the firmware does, so handle_btn2 drives
+// the LEDs' PWM, and sends the frames to the null sink
+void init_game() {
+    GpioConfig my_gpio[TicTacToe::NUMBER_OF_GPIOS] = {
+        {TicTacToe::LED1, GPIO_OUT},
+        {TicTacToe::LED2, GPIO_OUT},
+        {TicTacToe::BTN1, GPIO_IN},
+        {TicTacToe::BTN2, GPIO_IN},
+        {TicTacToe::BTN3, GPIO_IN},
+        {TicTacToe::ONBOARD_LED, GPIO_OUT},
+    };
+    game.init_gpio(my_gpio);
+    game.set_render_sink(null_sink);
+    game.set_record_sink(null_record_sink);
+}
+
+// Runs every benchmark
+void run_benchmarks() {
+    uint32_t state = 0x2545f491;
+    make_positions(&state);
+    make_scripts(&state);
+    make_sweep(&state);
+    make_routes(&state);
+    count_navigation();
+
+    measure("is_win", [](uint64_t i) {
+        const Position &position = positions[i & (POSITIONS - 1)];
+        bool is_win = game.is_win(position.player, position.board);
+        keep(is_win);
+    });
+
+    measure("is_win_at", [](uint64_t i) {
+        const Position &position = positions[i & (POSITIONS - 1)];
+        bool is_win = game.is_win_at(position.player, position.free_cell, position.board);
+        keep(is_win);
+    });
+
+    measure("is_tie", [](uint64_t i) {
+        bool is_tie = game.is_tie(positions[i & (POSITIONS - 1)].board);
+        keep(is_tie);
+    });
+
+    measure("update_board", [](uint64_t i) {
+        const Position &position = positions[i & (POSITIONS - 1)];
+        Board board = position.board;
+        game.update_board(position.player, position.free_cell, &board);
+        keep(board);
+    });
+
+    measure("update_position", [](uint64_t i) {
+        static uint moves = 0;
+        game.update_position(&moves, positions[i & (POSITIONS - 1)].board, false);
+        keep(moves);
+    });
+
+    // Consecutive positions differ, so every call draws a diff frame
+    measure("print_board", [](uint64_t i) {
+        game.print_board(positions[i & (POSITIONS - 1)].board);
+    });
+
+    // A move to an empty cell through the state machine: win and tie
+    // checks, LEDs and the frame
+    measure("handle_btn2", [](uint64_t i) {
+        // The positions are not a game the board played, so start a new one
+        // before its move log holds more moves than the board has cells
+        // (amortized over the CELLS moves)
+        if (i % TicTacToe::CELLS == 0) {
+            TicTacToe::State reset = {};
+            game.dispatch(&reset, GAME_EVENT_RESET_CONFIRMED);
+        }
+        const Position &position = positions[i & (POSITIONS - 1)];
+        TicTacToe::State state = {position.board, static_cast<uint8_t>(position.free_cell), 
+                                  position.player, GAME_PHASE_PLAYING};
+        game.dispatch(&state, GAME_EVENT_PLACE);
+        keep(state);
+    });
+
+    // Per gesture: from the gesture and phase to the action, through the
+    // transition table and through the branches it replaced
+    measure("transition_table", [](uint64_t i) {
+        (void)i;
+        for (uint route = 0; route < ROUTES; route++) {
+            route_actions[route] = route_by_table(route_gestures[route], route_phases[route]);
+        }
+        keep(route_actions);
+    }, ROUTES);
+
+    measure("transition_branches", [](uint64_t i) {
+        (void)i;
+        for (uint route = 0; route < ROUTES; route++) {
+            GamePhase phase = route_phases[route];
+            route_reference[route] = route_by_branches(route_gestures[route], 
+                                                       phase == GAME_PHASE_WON, 
+                                                       phase == GAME_PHASE_IDLE);
+        }
+        keep(route_reference);
+    }, ROUTES);
+
+    measure("game", [](uint64_t i) {
+        play(scripts[i % GAMES]);
+    });
+
+    // Per board: the batch classifier, its scalar loop, and what the game's
+    // functions can tell on their own (winner or tie, but not legality)
+    measure("classify_batch", [](uint64_t i) {
+        (void)i;
+        Classifier::classify(sweep_x, sweep_o, SWEEP_BOARDS, sweep_classes);
+        keep(sweep_classes);
+    }, SWEEP_BOARDS);
+
+    measure("classify_scalar", [](uint64_t i) {
+        (void)i;
+        Classifier::classify_scalar(sweep_x, sweep_o, SWEEP_BOARDS, sweep_reference);
+        keep(sweep_reference);
+    }, SWEEP_BOARDS);
+
+    measure("classify_is_win_loop", [](uint64_t i) {
+        (void)i;
+        for (uint64_t board = 0; board < SWEEP_BOARDS; board++) {
+            Board position = {sweep_x[board], sweep_o[board]};
+            uint8_t result = POSITION_ONGOING;
+            if (game.is_win(TicTacToe::X, position)) {
+                result = POSITION_X_WIN;
+            } else if (game.is_win(TicTacToe::O, position)) {
+                result = POSITION_O_WIN;
+            } else if (game.is_tie(position)) {
+                result = POSITION_TIE;
+            }
+            sweep_classes[board] = result;
+        }
+        keep(sweep_classes);
+    }, SWEEP_BOARDS);
+
+    // Per move, with one move of every open session per pass
+    while (pool.open() >= 0) {
+    }
+    for (uint sessions : POOL_SESSIONS) {
+        if (sessions > Pool::CAPACITY) {
+            continue;
+        }
+        TextBuffer<32> name;
+        name.format("session_pool_%u", sessions);
+        measure(name.c_str(), [sessions](uint64_t i) {
+            (void)i;
+            play_sessions(sessions);
+        }, sessions);
+    }
+    if (session_errors > 0) {
+        fputs("bench: the session pool disagrees with the scripted games\n", stderr);
+        exit(3);
+    }
+
+    // A diff frame queued in the output ring as core 0 does, drained here
+    // only when the ring is full; last, as the ring stays on from now on
+    Output::set_sink(null_output_sink);
+    Output::start_draining();
+    measure("output_write", [](uint64_t i) {
+        static const char frame[160] = {};
+        if (!Output::write(frame, sizeof(frame) - (i & 15), true)) {
+            Output::drain();
+        }
+    });
+
+    // The table must choose the actions the branches chose
+    if (memcmp(route_actions, route_reference, sizeof(route_actions)) != 0) {
+        fputs("bench: the transition table disagrees with the branches it replaced\n", stderr);
+        exit(3);
+    }
+
+    // The vector code must agree with the scalar loop on every board
+    Classifier::classify(sweep_x, sweep_o, SWEEP_BOARDS, sweep_classes);
+    if (memcmp(sweep_classes, sweep_reference, sizeof(sweep_classes)) != 0) {
+        fputs("bench: classify() disagrees with classify_scalar()\n", stderr);
+        exit(3);
+    }
+}
+
+// Writes the results as JSON, one benchmark per line
+void write_results(FILE *file) {
+    fprintf(file, "{\n");
+#if PICO_ON_DEVICE
+    fprintf(file, "  \"platform\": \"rp2040\",\n");
+#else
+    fprintf(file, "  \"platform\": \"host\",\n");
+#endif
+    fprintf(file, "  \"board\": \"%ux%ux%u\",\n", static_cast<uint>(TicTacToe::ROWS),
+            static_cast<uint>(TicTacToe::COLS), static_cast<uint>(TicTacToe::WIN_LENGTH));
+    fprintf(file, "  \"rendered_bytes\": %llu,\n", static_cast<unsigned long long>(rendered_bytes));
+    fprintf(file, "  \"classifier_isa\": \"%s\",\n", Classifier::get_isa());
+    uint64_t moves = (navigation.moves > 0) ? navigation.moves : 1;
+    fprintf(file, "  \"navigation\": {\"linear_presses_per_move\": %.2f, \"presses_per_move\": %.2f, "
+            "\"linear_ms_per_move\": %.0f, \"ms_per_move\": %.0f},\n",
+            static_cast<double>(navigation.linear_presses) / moves,
+            static_cast<double>(navigation.presses) / moves,
+            static_cast<double>(navigation.linear_ms) / moves,
+            static_cast<double>(navigation.ms) / moves);
+    fprintf(file, "  \"benchmarks\": [\n");
+    for (uint i = 0; i < number_of_results; i++) {
+        const BenchResult &result = results[i];
+        TextBuffer<160> line;
+        line.format("    {\"name\": \"%s\", \"iterations\": %llu, \"ns_per_op\": %.2f, "
+                    "\"ops_per_sec\": %.1f", result.name,
+                    static_cast<unsigned long long>(result.iterations), result.ns_per_op,
+                    1e9 / result.ns_per_op);
+#if PICO_ON_DEVICE
+        // time_us_64 ticks once a microsecond, so cycles are derived from the clock
+        line.append(", \"cycles_per_op\": %.1f",
+                    result.ns_per_op * clock_get_hz(clk_sys) / 1e9);
+#endif
+        line.append("}%s\n", (i + 1 < number_of_results) ? "," : "");
+        fputs(line.c_str(), file);
+    }
+    fprintf(file, "  ]\n}\n");
+    fflush(file);
+}
+
+#if !PICO_ON_DEVICE
+
+void usage() {
+    fputs("Usage: tictactoe_bench [--output FILE] [--baseline FILE [--tolerance PCT]]\n"
+          "                       [--results FILE]\n"
+          "\n"
+          "Times the move functions and complete scripted games and writes the\n"
+          "results as JSON to stdout or FILE. With --baseline, every benchmark more\n"
+          "than PCT percent (default 10) slower than in the baseline fails the run.\n"
+          "--results checks earlier results, e.g. captured from the Pico, instead\n"
+          "of running the benchmarks.\n", stderr);
+}
+
+// Reads results written by write_results
+// @return false if the file can't be read
+bool read_results(const char *path, BenchResult *read, uint *count) {
+    FILE *file = fopen(path, "r");
+    if (file == nullptr) {
+        return false;
+    }
+    char line[256];
+    *count = 0;
+    while (*count < MAX_RESULTS && fgets(line, sizeof(line), file) != nullptr) {
+        BenchResult &result = read[*count];
+        unsigned long long iterations = 0;
+        if (sscanf(line, " {\"name\": \"%31[^\"]\", \"iterations\": %llu, \"ns_per_op\": %lf",
+                   result.name, &iterations, &result.ns_per_op) == 3) {
+            result.iterations = iterations;
+            (*count)++;
+        }
+    }
+    fclose(file);
+    return true;
+}
+
+// Compares the results with the baseline's
+// @return Number of benchmarks that got slower by more than tolerance percent
+uint compare(const BenchResult *baseline, const uint baseline_count, const double tolerance) {
+    uint regressions = 0;
+    for (uint i = 0; i < number_of_results; i++) {
+        const BenchResult &result = results[i];
+        for (uint j = 0; j < baseline_count; j++) {
+            if (strcmp(baseline[j].name, result.name) != 0) {
+                continue;
+            }
+            double change = 100.0 * (result.ns_per_op / baseline[j].ns_per_op - 1.0);
+            bool is_regression = change > tolerance;
+            regressions += is_regression ? 1 : 0;
+            fprintf(stderr, "bench: %-16s %12.2f ns -> %12.2f ns (%+6.1f%%)%s\n", result.name,
+                    baseline[j].ns_per_op, result.ns_per_op, change,
+                    is_regression ? " REGRESSION" : "");
+        }
+    }
+    return regressions;
+}
+
+#endif
+
+}  // namespace
+
+#if PICO_ON_DEVICE
+
+int main() {
+    stdio_init_all();
+
+    init_game();
+
+    // Wait for a terminal, so the results aren't lost
+    while (!stdio_usb_connected()) {
+        sleep_ms(100);
+    }
+    run_benchmarks();
+    write_results(stdout);
+
+    while (true) {
+        sleep_ms(1000);
+    }
+    return 0;
+}
+
+#else
+
+int main(int argc, char **argv) {
+    const char *output_path = nullptr;
+    const char *baseline_path = nullptr;
+    const char *results_path = nullptr;
+    double tolerance = DEFAULT_TOLERANCE;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            output_path = argv[++i];
+        } else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+            baseline_path = argv[++i];
+        } else if (strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc) {
+            tolerance = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--results") == 0 && i + 1 < argc) {
+            results_path = argv[++i];
+        } else {
+            usage();
+            return 1;
+        }
+    }
+
+    if (results_path != nullptr) {
+        if (!read_results(results_path, results, &number_of_results)) {
+            fprintf(stderr, "Cannot read %s\n", results_path);
+            return 1;
+        }
+    } else {
+        init_game();
+        run_benchmarks();
+
+        FILE *file = stdout;
+        if (output_path != nullptr) {
+            file = fopen(output_path, "w");
+            if (file == nullptr) {
+                fprintf(stderr, "Cannot write %s\n", output_path);
+                return 1;
+            }
+        }
+        write_results(file);
+        if (file != stdout) {
+            fclose(file);
+        }
+    }
+
+    if (baseline_path != nullptr) {
+        static BenchResult baseline[MAX_RESULTS];
+        uint baseline_count = 0;
+        if (!read_results(baseline_path, baseline, &baseline_count)) {
+            fprintf(stderr, "Cannot read %s\n", baseline_path);
+            return 1;
+        }
+        uint regressions = compare(baseline, baseline_count, tolerance);
+        if (regressions > 0) {
+            fprintf(stderr, "bench: %u benchmarks slower than the baseline by more than %.1f%%\n",
+                    regressions, tolerance);
+            return 2;
+        }
+    }
+    return 0;
+}
+
+#endif
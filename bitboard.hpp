@@ -0,0 +1,153 @@
+#ifndef __BITBOARD_HPP__
+#define __BITBOARD_HPP__
+
+#include <array>
+#include <stdint.h>
+#include <type_traits>
+
+// Smallest unsigned integer type with at least one bit per cell
+// 3x3 and 4x4 boards use 16 bits, 5x5 uses 32 bits and 7x7 uses 64 bits
+template <unsigned int Cells>
+using BoardMask = typename std::conditional<(Cells <= 16), uint16_t,
+                  typename std::conditional<(Cells <= 32), uint32_t, uint64_t>::type>::type;
+
+// Struct for storing the board as one occupancy mask per player
+// Cell (row, col) is stored in bit (row * Cols + col)
+// @field x Cells occupied by player X
+// @field o Cells occupied by player O
+template <unsigned int Cells>
+struct BasicBitboard {
+    static_assert(Cells <= 64, "Board must fit into a 64-bit mask");
+    typedef BoardMask<Cells> Mask;
+
+    Mask x;
+    Mask o;
+};
+
+// Bitboard of the classic 3x3 board, cells 0 to 8 map to bits 0 to 8
+typedef BasicBitboard<9> Bitboard;
+
+// Geometry of a Rows x Cols board on which K in a row wins
+// Holds the full-board mask and the precomputed masks of every winning line
+template <unsigned int Rows, unsigned int Cols, unsigned int K>
+struct BoardGeometry {
+    static_assert(K >= 1 && (K <= Rows || K <= Cols), "K must fit on the board");
+    typedef BoardMask<Rows * Cols> Mask;
+
+    static constexpr unsigned int CELLS = Rows * Cols;
+
+    // Mask with every cell of the board set
+    static constexpr Mask FULL_BOARD =
+        (CELLS == 64) ? static_cast<Mask>(~static_cast<Mask>(0))
+                      : static_cast<Mask>((static_cast<uint64_t>(1) << CELLS) - 1);
+
+    // Number of winning lines: horizontal, vertical and both diagonals
+    static constexpr unsigned int NUMBER_OF_WIN_MASKS =
+        (Cols >= K ? Rows * (Cols - K + 1) : 0) +
+        (Rows >= K ? Cols * (Rows - K + 1) : 0) +
+        (Rows >= K && Cols >= K ? 2 * (Rows - K + 1) * (Cols - K + 1) : 0);
+
+    // Builds the mask of the K cells starting at (row, col) in direction (d_row, d_col)
+    static constexpr Mask line_mask(int row, int col, int d_row, int d_col) {
+        Mask mask = 0;
+        for (unsigned int i = 0; i < K; i++) {
+            mask |= static_cast<Mask>(static_cast<Mask>(1) << (row * Cols + col));
+            row += d_row;
+            col += d_col;
+        }
+        return mask;
+    }
+
+    // Generates the table of winning lines at compile time
+    // Ordered as rows, columns, diagonals and anti-diagonals
+    static constexpr std::array<Mask, NUMBER_OF_WIN_MASKS> make_win_masks() {
+        std::array<Mask, NUMBER_OF_WIN_MASKS> masks = {};
+        unsigned int n = 0;
+        for (unsigned int r = 0; r < Rows && Cols >= K; r++) {
+            for (unsigned int c = 0; c + K <= Cols; c++) {
+                masks[n++] = line_mask(r, c, 0, 1);
+            }
+        }
+        for (unsigned int c = 0; c < Cols && Rows >= K; c++) {
+            for (unsigned int r = 0; r + K <= Rows; r++) {
+                masks[n++] = line_mask(r, c, 1, 0);
+            }
+        }
+        for (unsigned int r = 0; r + K <= Rows; r++) {
+            for (unsigned int c = 0; c + K <= Cols; c++) {
+                masks[n++] = line_mask(r, c, 1, 1);
+            }
+        }
+        for (unsigned int r = 0; r + K <= Rows; r++) {
+            for (unsigned int c = K - 1; c < Cols; c++) {
+                masks[n++] = line_mask(r, c, 1, -1);
+            }
+        }
+        return masks;
+    }
+
+    static constexpr std::array<Mask, NUMBER_OF_WIN_MASKS> WIN_MASKS = make_win_masks();
+
+    // Returns the number of winning lines passing through each cell
+    static constexpr std::array<uint8_t, CELLS> make_cell_line_counts() {
+        std::array<uint8_t, CELLS> counts = {};
+        for (unsigned int i = 0; i < NUMBER_OF_WIN_MASKS; i++) {
+            for (unsigned int cell = 0; cell < CELLS; cell++) {
+                if ((WIN_MASKS[i] >> cell) & 1) {
+                    counts[cell]++;
+                }
+            }
+        }
+        return counts;
+    }
+
+    static constexpr std::array<uint8_t, CELLS> CELL_LINE_COUNT = make_cell_line_counts();
+
+    // Largest number of winning lines through a single cell, at most 4 * K
+    static constexpr unsigned int max_cell_lines() {
+        unsigned int max = 0;
+        for (unsigned int cell = 0; cell < CELLS; cell++) {
+            max = (CELL_LINE_COUNT[cell] > max) ? CELL_LINE_COUNT[cell] : max;
+        }
+        return max;
+    }
+
+    static constexpr unsigned int MAX_CELL_LINES = max_cell_lines();
+
+    typedef std::array<std::array<Mask, MAX_CELL_LINES>, CELLS> CellLines;
+
+    // Groups the winning lines by the cells they pass through, so a move
+    // only has to be checked against the lines through its own cell
+    static constexpr CellLines make_cell_lines() {
+        CellLines lines = {};
+        std::array<uint8_t, CELLS> n = {};
+        for (unsigned int i = 0; i < NUMBER_OF_WIN_MASKS; i++) {
+            for (unsigned int cell = 0; cell < CELLS; cell++) {
+                if ((WIN_MASKS[i] >> cell) & 1) {
+                    lines[cell][n[cell]++] = WIN_MASKS[i];
+                }
+            }
+        }
+        return lines;
+    }
+
+    static constexpr CellLines CELL_LINES = make_cell_lines();
+};
+
+// Cell numbers of the 3x3 board:   0 | 1 | 2
+//                                 ---+---+---
+//                                  3 | 4 | 5
+//                                 ---+---+---
+//                                  6 | 7 | 8
+static_assert(BoardGeometry<3, 3, 3>::FULL_BOARD == 0x1FF, "3x3 board has 9 cells");
+static_assert(BoardGeometry<3, 3, 3>::NUMBER_OF_WIN_MASKS == 8, "3x3 board has 8 lines");
+static_assert(BoardGeometry<3, 3, 3>::WIN_MASKS[0] == 0x007 &&      // Row 0
+              BoardGeometry<3, 3, 3>::WIN_MASKS[3] == 0x049 &&      // Column 0
+              BoardGeometry<3, 3, 3>::WIN_MASKS[6] == 0x111 &&      // Diagonal (0, 4, 8)
+              BoardGeometry<3, 3, 3>::WIN_MASKS[7] == 0x054,        // Anti-diagonal (2, 4, 6)
+              "3x3 win masks");
+static_assert(BoardGeometry<3, 3, 3>::CELL_LINE_COUNT[4] == 4 &&    // Center: row, column, both diagonals
+              BoardGeometry<3, 3, 3>::CELL_LINE_COUNT[1] == 2,      // Edge: row and column
+              "3x3 lines per cell");
+
+#endif  // __BITBOARD_HPP__
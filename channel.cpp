@@ -0,0 +1,76 @@
+#include "channel.hpp"
+#include "trace.hpp"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+#include "pico/multicore.h"
+#include "pico/platform.h"
+
+SpscQueue<Message, Channel::QUEUE_SIZE> Channel::queues[EventLoop::NUMBER_OF_CORES];
+volatile uint32_t Channel::sent[EventLoop::NUMBER_OF_CORES] = {};
+volatile uint32_t Channel::received[EventLoop::NUMBER_OF_CORES] = {};
+volatile uint32_t Channel::doorbells_skipped[EventLoop::NUMBER_OF_CORES] = {};
+
+bool Channel::send(const Message &message) {
+    TRACE_SCOPE(TRACE_CHANNEL_SEND);
+    uint other = 1 - get_core_num();
+
+    if (!queues[other].try_push(message)) {
+        return false;
+    }
+    sent[other]++;
+
+    // Ring the doorbell only after the message is visible. The FIFO has a
+    // single writer per direction, so if it has room the push can't block
+    if (multicore_fifo_wready()) {
+        multicore_fifo_push_blocking(DOORBELL);
+    } else {
+        // A doorbell is already pending, still signal an event for WFE
+        doorbells_skipped[other]++;
+        __sev();
+    }
+    return true;
+}
+
+bool Channel::receive(Message *message) {
+    TRACE_BEGIN(start);
+    uint core = get_core_num();
+
+    // Drain first: a doorbell arriving after this belongs to a message
+    // the pop below may not see yet and wakes the core again
+    drain_doorbells();
+
+    if (!queues[core].try_pop(message)) {
+        return false;
+    }
+    received[core]++;
+    // Only receives that found a message, the loops poll until it's empty
+    TRACE_END(TRACE_CHANNEL_RECEIVE, start);
+    return true;
+}
+
+bool Channel::has_messages() {
+    return !queues[get_core_num()].is_empty();
+}
+
+void Channel::enable_doorbell_irq() {
+    multicore_fifo_clear_irq();
+    irq_set_exclusive_handler(SIO_IRQ_PROC0, &Channel::on_doorbell);
+    irq_set_enabled(SIO_IRQ_PROC0, true);
+}
+
+ChannelStats Channel::get_stats(const uint core) {
+    ChannelStats stats = {sent[core], received[core], queues[core].get_dropped(), 
+                          doorbells_skipped[core]};
+    return stats;
+}
+
+void Channel::drain_doorbells() {
+    // Unlike a pop, draining can't block if an IRQ emptied the FIFO meanwhile
+    multicore_fifo_drain();
+}
+
+void Channel::on_doorbell() {
+    drain_doorbells();
+    // Clear the FIFO error flags, which also raise this interrupt
+    multicore_fifo_clear_irq();
+}
@@ -0,0 +1,115 @@
+#ifndef __CHANNEL_HPP__
+#define __CHANNEL_HPP__
+
+#include "event_loop.hpp"
+#include "spsc_queue.hpp"
+#include "pico/stdlib.h"
+#include <stdint.h>
+
+// Types of the messages exchanged between the cores
+enum MessageType : uint8_t {
+    MSG_STATS_REQUEST = 1,  // Core 0 -> 1: reply with a snapshot of the idle statistics
+    MSG_STATS,              // Core 1 -> 0: the requested idle statistics
+    MSG_SEARCH_REQUEST,     // Core 0 -> 1: help the engine search the given position
+    MSG_SEARCH_RESULT,      // Core 1 -> 0: no move, when core 1 has no engine to help
+    MSG_FLASH_PARK,         // Core 0 -> 1: wait in RAM while the flash is written
+};
+
+// Struct for storing a search request
+// @field x Occupancy mask of X
+// @field o Occupancy mask of O
+// @field budget_us Time budget of the search
+typedef struct {
+    uint64_t x;
+    uint64_t o;
+    uint32_t budget_us;
+} SearchRequestMsg;
+
+// Struct for storing a search result
+// @field cell Cell of the best move, -1 if there is none
+// @field score Score of the best move from the mover's point of view
+// @field depth Deepest fully completed iteration
+// @field nodes Number of nodes searched
+typedef struct {
+    int16_t cell;
+    int16_t score;
+    uint8_t depth;
+    uint32_t nodes;
+} SearchResultMsg;
+
+// Struct for storing one tagged message
+// @field type MessageType, selects the member of the payload
+// @field player Side to move (MSG_SEARCH_*)
+// @field id Sequence number matching a reply to its request, the engine's
+//        ticket (Engine::open_search) in MSG_SEARCH_REQUEST
+typedef struct {
+    uint8_t type;
+    char player;
+    uint16_t id;
+    union {
+        IdleStats stats;
+        SearchRequestMsg search;
+        SearchResultMsg result;
+    };
+} Message;
+
+// Struct for storing the statistics of one direction of the channel
+// @field sent Messages queued
+// @field received Messages taken off the queue
+// @field dropped Messages rejected because the queue was full
+// @field doorbells_skipped Doorbells not rung because the hardware FIFO was
+//        full, i.e. the receiver was behind (back-pressure)
+typedef struct {
+    uint32_t sent;
+    uint32_t received;
+    uint32_t dropped;
+    uint32_t doorbells_skipped;
+} ChannelStats;
+
+// Typed, non-blocking message channel between the two cores
+// Each direction is a lock-free SPSC ring of Messages in shared SRAM. The
+// 8-entry hardware FIFO only carries doorbells: a push raises an event
+// (waking the other core from WFE) and, on core 0, the SIO interrupt (waking
+// it from WFI). Sending never blocks; a full queue drops the message and a
+// full FIFO skips the doorbell, as one is already pending
+class Channel {
+    public:
+        static const uint32_t QUEUE_SIZE = 16;
+
+        // Sends the message to the other core
+        // @return false if the other core's queue was full and it was dropped
+        static bool send(const Message &message);
+
+        // Takes the oldest message for the calling core
+        // @return false if there is none
+        static bool receive(Message *message);
+
+        // Returns true if messages for the calling core are waiting
+        static bool has_messages();
+
+        // Lets doorbells from core 1 interrupt core 0, so a reply ends its WFI
+        // Must be called on core 0 after core 1 has been launched
+        static void enable_doorbell_irq();
+
+        // Returns the statistics of the messages sent to the given core
+        static ChannelStats get_stats(const uint core);
+
+    private:
+        static const uint32_t DOORBELL = 0xD00B;
+
+        // Queue of the messages for each core
+        static SpscQueue<Message, QUEUE_SIZE> queues[EventLoop::NUMBER_OF_CORES];
+
+        // Counters of each direction, written by one side only
+        static volatile uint32_t sent[EventLoop::NUMBER_OF_CORES];
+        static volatile uint32_t received[EventLoop::NUMBER_OF_CORES];
+        static volatile uint32_t doorbells_skipped[EventLoop::NUMBER_OF_CORES];
+
+        // Empties the hardware FIFO of doorbells
+        static void drain_doorbells();
+
+        // SIO interrupt handler of core 0, its only job is to wake the core
+        static void on_doorbell();
+};
+
+#endif  // __CHANNEL_HPP__
@@ -0,0 +1,180 @@
+#include "classifier.hpp"
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CLASSIFIER_X86 1
+#else
+#define CLASSIFIER_X86 0
+#endif
+
+// Returns the number of set bits of a mask
+template <typename Mask>
+static uint count_marks(Mask mask) {
+    return static_cast<uint>(__builtin_popcountll(static_cast<unsigned long long>(mask)));
+}
+
+// Classifies the boards of the vector at x and o, Bytes / sizeof(Mask) of them
+// Always inlined, so it is compiled for the instruction set of its caller
+// The lanes of a comparison are all ones where it holds and zero elsewhere,
+// so the conditions combine with & and | and select with masks
+template <typename Geometry, typename Mask, size_t Bytes>
+__attribute__((always_inline)) static inline void classify_vector(const Mask *x, const Mask *o,
+                                                                  uint8_t *classes) {
+    typedef Mask Vector __attribute__((vector_size(Bytes)));
+    const size_t LANES = Bytes / sizeof(Mask);
+    const Vector ZERO = {};
+
+    Vector xs;
+    Vector os;
+    memcpy(&xs, x, sizeof(xs));
+    memcpy(&os, o, sizeof(os));
+
+    // Does either player own every cell of a winning line?
+    Vector x_wins = ZERO;
+    Vector o_wins = ZERO;
+    for (uint i = 0; i < Geometry::NUMBER_OF_WIN_MASKS; i++) {
+        const Vector line = ZERO + Geometry::WIN_MASKS[i];
+        x_wins |= reinterpret_cast<Vector>((xs & line) == line);
+        o_wins |= reinterpret_cast<Vector>((os & line) == line);
+    }
+
+    // Count the marks by adding up the bits in pairs, nibbles, then bytes
+    Vector counts[2] = {xs, os};
+    for (Vector &count : counts) {
+        count = count - ((count >> 1) & static_cast<Mask>(0x5555555555555555ull));
+        count = (count & static_cast<Mask>(0x3333333333333333ull)) +
+                ((count >> 2) & static_cast<Mask>(0x3333333333333333ull));
+        count = (count + (count >> 4)) & static_cast<Mask>(0x0f0f0f0f0f0f0f0full);
+        for (uint shift = 8; shift < 8 * sizeof(Mask); shift *= 2) {
+            count += count >> shift;
+        }
+        count &= static_cast<Mask>(0xff);
+    }
+    // Unsigned, so O having more marks than X wraps to a large difference
+    Vector difference = counts[0] - counts[1];
+    Vector is_x_ahead = reinterpret_cast<Vector>(difference == 1);
+    Vector is_even = reinterpret_cast<Vector>(difference == 0);
+
+    Vector is_illegal = reinterpret_cast<Vector>((xs & os) != 0) | ~(is_x_ahead | is_even) |
+                        (x_wins & o_wins) | (x_wins & ~is_x_ahead) | (o_wins & ~is_even);
+    Vector is_full = reinterpret_cast<Vector>((xs | os) == Geometry::FULL_BOARD);
+
+    // Later conditions take precedence
+    Vector result = ZERO + static_cast<Mask>(POSITION_ONGOING);
+    result = (result & ~is_full) | ((ZERO + static_cast<Mask>(POSITION_TIE)) & is_full);
+    result = (result & ~o_wins) | ((ZERO + static_cast<Mask>(POSITION_O_WIN)) & o_wins);
+    result = (result & ~x_wins) | ((ZERO + static_cast<Mask>(POSITION_X_WIN)) & x_wins);
+    result = (result & ~is_illegal) | ((ZERO + static_cast<Mask>(POSITION_ILLEGAL)) & is_illegal);
+
+    for (size_t lane = 0; lane < LANES; lane++) {
+        classes[lane] = static_cast<uint8_t>(result[lane]);
+    }
+}
+
+// Classifies the whole vectors of the batch with Bytes-wide vectors
+// @return Number of boards classified, the rest is left to the scalar loop
+template <typename Geometry, typename Mask, size_t Bytes>
+__attribute__((always_inline)) static inline size_t classify_vectors(const Mask *x, const Mask *o,
+                                                                     const size_t count,
+                                                                     uint8_t *classes) {
+    const size_t LANES = Bytes / sizeof(Mask);
+    size_t i = 0;
+    for (; i + LANES <= count; i += LANES) {
+        classify_vector<Geometry, Mask, Bytes>(x + i, o + i, classes + i);
+    }
+    return i;
+}
+
+#if CLASSIFIER_X86
+
+// SSE2 is part of every x86-64 CPU
+template <typename Geometry, typename Mask>
+static size_t classify_sse2(const Mask *x, const Mask *o, const size_t count, uint8_t *classes) {
+    return classify_vectors<Geometry, Mask, 16>(x, o, count, classes);
+}
+
+template <typename Geometry, typename Mask>
+__attribute__((target("avx2")))
+static size_t classify_avx2(const Mask *x, const Mask *o, const size_t count, uint8_t *classes) {
+    return classify_vectors<Geometry, Mask, 32>(x, o, count, classes);
+}
+
+// Checked once, on the first call
+static bool has_avx2() {
+    static const bool has = __builtin_cpu_supports("avx2");
+    return has;
+}
+
+#endif
+
+template <uint Rows, uint Cols, uint K>
+void BatchClassifier<Rows, Cols, K>::classify(const Mask *x, const Mask *o, const size_t count,
+                                              uint8_t *classes) {
+    size_t done = 0;
+#if CLASSIFIER_X86
+    done = has_avx2() ? classify_avx2<Geometry, Mask>(x, o, count, classes)
+                      : classify_sse2<Geometry, Mask>(x, o, count, classes);
+#endif
+    classify_scalar(x + done, o + done, count - done, classes + done);
+}
+
+template <uint Rows, uint Cols, uint K>
+void BatchClassifier<Rows, Cols, K>::classify_scalar(const Mask *x, const Mask *o,
+                                                     const size_t count, uint8_t *classes) {
+    for (size_t i = 0; i < count; i++) {
+        bool x_wins = false;
+        bool o_wins = false;
+        for (uint line = 0; line < Geometry::NUMBER_OF_WIN_MASKS; line++) {
+            x_wins |= (x[i] & Geometry::WIN_MASKS[line]) == Geometry::WIN_MASKS[line];
+            o_wins |= (o[i] & Geometry::WIN_MASKS[line]) == Geometry::WIN_MASKS[line];
+        }
+
+        uint x_marks = count_marks(x[i]);
+        uint o_marks = count_marks(o[i]);
+        bool is_x_ahead = (x_marks == o_marks + 1);
+        bool is_even = (x_marks == o_marks);
+
+        if ((x[i] & o[i]) != 0 || !(is_x_ahead || is_even) || (x_wins && o_wins) ||
+            (x_wins && !is_x_ahead) || (o_wins && !is_even)) {
+            classes[i] = POSITION_ILLEGAL;
+        } else if (x_wins) {
+            classes[i] = POSITION_X_WIN;
+        } else if (o_wins) {
+            classes[i] = POSITION_O_WIN;
+        } else if ((x[i] | o[i]) == Geometry::FULL_BOARD) {
+            classes[i] = POSITION_TIE;
+        } else {
+            classes[i] = POSITION_ONGOING;
+        }
+    }
+}
+
+template <uint Rows, uint Cols, uint K>
+const char *BatchClassifier<Rows, Cols, K>::get_isa() {
+#if CLASSIFIER_X86
+    return has_avx2() ? "avx2" : "sse2";
+#else
+    return "scalar";
+#endif
+}
+
+template <uint Rows, uint Cols, uint K>
+void BatchClassifier<Rows, Cols, K>::decode(uint64_t code, Mask *x, Mask *o) {
+    *x = 0;
+    *o = 0;
+    for (uint cell = 0; cell < CELLS; cell++) {
+        uint digit = static_cast<uint>(code % 3);
+        code /= 3;
+        if (digit == 1) {
+            *x |= static_cast<Mask>(static_cast<Mask>(1) << cell);
+        } else if (digit == 2) {
+            *o |= static_cast<Mask>(static_cast<Mask>(1) << cell);
+        }
+    }
+}
+
+// Supported board variants, see game.cpp
+template class BatchClassifier<3, 3, 3>;
+template class BatchClassifier<4, 4, 4>;
+template class BatchClassifier<5, 5, 4>;
+template class BatchClassifier<7, 7, 5>;
@@ -0,0 +1,59 @@
+#ifndef __CLASSIFIER_HPP__
+#define __CLASSIFIER_HPP__
+
+#include "bitboard.hpp"
+#include "pico/stdlib.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// Class of a position, as found by BatchClassifier
+enum PositionClass : uint8_t {
+    POSITION_ONGOING = 0,   // Legal, no winner and empty cells left
+    POSITION_X_WIN,         // X owns a winning line
+    POSITION_O_WIN,         // O owns a winning line
+    POSITION_TIE,           // Full board without a winner
+    POSITION_ILLEGAL        // Can't be reached by alternating moves from the empty board
+};
+
+// Classifies whole batches of Rows x Cols, K-in-a-row positions
+// The boards are passed as a struct of arrays, the X masks in one array and
+// the O masks in another, so that the win masks are checked on a vector of
+// boards at a time: 8 to 16 boards per instruction with SSE2 (16-byte
+// vectors) or AVX2 (32-byte vectors), picked at run time on x86 hosts. Other
+// targets, like the RP2040, use the scalar loop, which gives identical results
+//
+// A position is illegal if the players share a cell, X doesn't have the same
+// number of marks as O or one more, both players own a line, or the winner
+// didn't make the last move (X wins with one mark more, O with equal counts)
+template <uint Rows, uint Cols, uint K>
+class BatchClassifier {
+    public:
+        typedef BoardGeometry<Rows, Cols, K> Geometry;
+        typedef BasicBitboard<Rows * Cols> Board;
+        typedef typename Board::Mask Mask;
+        static const uint CELLS = Rows * Cols;
+
+        // Classifies count boards with the fastest code the CPU supports
+        // @param x X masks of the boards
+        // @param o O masks of the boards, o[i] belongs to x[i]
+        // @param count Number of boards
+        // @param classes Set to the PositionClass of every board
+        static void classify(const Mask *x, const Mask *o, const size_t count, uint8_t *classes);
+
+        // Classifies count boards one at a time, the reference for classify()
+        static void classify_scalar(const Mask *x, const Mask *o, const size_t count,
+                                    uint8_t *classes);
+
+        // Returns the instruction set classify() uses: "avx2", "sse2" or "scalar"
+        static const char *get_isa();
+
+        // Decodes a base-3 position number, one digit per cell starting at
+        // cell 0: 0 for empty, 1 for X and 2 for O
+        // There are 3^CELLS numbers, e.g. 19683 on the 3x3 board
+        // @param code The position number
+        // @param x Set to the X mask
+        // @param o Set to the O mask
+        static void decode(uint64_t code, Mask *x, Mask *o);
+};
+
+#endif  // __CLASSIFIER_HPP__
@@ -0,0 +1,41 @@
+# Prints the section sizes of an ELF file at build time and fails the build
+# if it doesn't fit the flash or RAM budget
+# Usage: cmake -DSIZE=<size> -DELF=<file> -DFLASH_BUDGET=<bytes> -DRAM_BUDGET=<bytes>
+#              -P check_size.cmake
+
+execute_process(
+    COMMAND ${SIZE} --format=berkeley ${ELF}
+    OUTPUT_VARIABLE size_output
+    RESULT_VARIABLE size_result
+)
+
+if (NOT size_result EQUAL 0)
+    message(WARNING "Could not read section sizes of ${ELF}")
+    return()
+endif()
+
+# text data bss dec hex filename
+if (NOT size_output MATCHES "\n[ \t]*([0-9]+)[ \t]+([0-9]+)[ \t]+([0-9]+)[ \t]")
+    message(WARNING "Unexpected output of ${SIZE}: ${size_output}")
+    return()
+endif()
+
+set(text ${CMAKE_MATCH_1})
+set(data ${CMAKE_MATCH_2})
+set(bss ${CMAKE_MATCH_3})
+
+# .data is stored in flash and copied to RAM at boot
+math(EXPR flash "${text} + ${data}")
+math(EXPR ram "${data} + ${bss}")
+
+message(STATUS ".text: ${text} bytes, .data: ${data} bytes, .bss: ${bss} bytes")
+message(STATUS "Flash: ${flash} of ${FLASH_BUDGET} bytes, RAM: ${ram} of ${RAM_BUDGET} bytes")
+
+if (flash GREATER FLASH_BUDGET)
+    math(EXPR over "${flash} - ${FLASH_BUDGET}")
+    message(FATAL_ERROR "Flash budget exceeded by ${over} bytes")
+endif()
+if (ram GREATER RAM_BUDGET)
+    math(EXPR over "${ram} - ${RAM_BUDGET}")
+    message(FATAL_ERROR "RAM budget exceeded by ${over} bytes")
+endif()
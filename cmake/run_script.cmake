@@ -0,0 +1,48 @@
+# Runs a simulator script and fails if the output differs from the expected
+# output stored next to the script: <script>.out for stdout, compared byte
+# for byte (frames and records included), and <script>.err for the run report,
+# in which the wall time is replaced by X
+# Usage: cmake -DHOST=<tictactoe_host> -DSCRIPT=<script.txt> [-DUPDATE=ON]
+#              -P run_script.cmake
+# With UPDATE=ON the expected output is rewritten from this run
+
+string(REGEX REPLACE "\\.txt$" "" expected ${SCRIPT})
+string(RANDOM LENGTH 8 suffix)
+set(actual_out ${CMAKE_CURRENT_BINARY_DIR}/run_script_${suffix}.out)
+
+execute_process(
+    COMMAND ${HOST} ${SCRIPT}
+    OUTPUT_FILE ${actual_out}
+    ERROR_VARIABLE actual_err
+    RESULT_VARIABLE result
+)
+
+if (NOT result EQUAL 0)
+    file(REMOVE ${actual_out})
+    message(FATAL_ERROR "${HOST} ${SCRIPT} exited with ${result}\n${actual_err}")
+endif()
+
+# The only part of a run that depends on the host
+string(REGEX REPLACE "in [0-9]+ us wall time" "in X us wall time" actual_err "${actual_err}")
+
+if (UPDATE)
+    file(RENAME ${actual_out} ${expected}.out)
+    file(WRITE ${expected}.err "${actual_err}")
+    message(STATUS "Updated ${expected}.out and ${expected}.err")
+    return()
+endif()
+
+execute_process(
+    COMMAND ${CMAKE_COMMAND} -E compare_files ${actual_out} ${expected}.out
+    RESULT_VARIABLE out_differs
+)
+file(REMOVE ${actual_out})
+file(READ ${expected}.err expected_err)
+
+if (out_differs)
+    message(FATAL_ERROR "Output of ${SCRIPT} differs from ${expected}.out")
+endif()
+if (NOT actual_err STREQUAL expected_err)
+    message(FATAL_ERROR "Report of ${SCRIPT} differs from ${expected}.err:\n"
+                        "${actual_err}\nexpected:\n${expected_err}")
+endif()
@@ -0,0 +1,30 @@
+# Prints the size of the given symbols of an ELF file at build time
+# Usage: cmake -DNM=<nm> -DELF=<file> -DSYMBOLS=<name;name> -P symbol_size.cmake
+
+execute_process(
+    COMMAND ${NM} --print-size --radix=d --demangle ${ELF}
+    OUTPUT_VARIABLE nm_output
+    RESULT_VARIABLE nm_result
+)
+
+if (NOT nm_result EQUAL 0)
+    message(WARNING "Could not read symbols of ${ELF}")
+    return()
+endif()
+
+string(REPLACE "\n" ";" nm_lines "${nm_output}")
+
+foreach (symbol ${SYMBOLS})
+    set(found FALSE)
+    foreach (line ${nm_lines})
+        # <address> <size> <type> <name>
+        if (line MATCHES "^[0-9]+ ([0-9]+) [A-Za-z] ${symbol}$")
+            math(EXPR size "${CMAKE_MATCH_1}")
+            message(STATUS "${symbol}: ${size} bytes")
+            set(found TRUE)
+        endif()
+    endforeach()
+    if (NOT found)
+        message(STATUS "${symbol}: not linked")
+    endif()
+endforeach()
@@ -0,0 +1,94 @@
+#include "event_loop.hpp"
+#include "hardware/sync.h"
+#include "pico/platform.h"
+
+IdleStats EventLoop::idle_stats[NUMBER_OF_CORES] = {};
+
+EventLoop::EventLoop() : number_of_timers(0) {
+}
+
+bool EventLoop::add_timer(const uint32_t period_ms, TimerHandler handler) {
+    if (number_of_timers == MAX_TIMERS) {
+        return false;
+    }
+    timers[number_of_timers].handler = handler;
+    timers[number_of_timers].period_ms = period_ms;
+    timers[number_of_timers].next = make_timeout_time_ms(period_ms);
+    number_of_timers++;
+    return true;
+}
+
+absolute_time_t EventLoop::run_timers() {
+    absolute_time_t next = at_the_end_of_time;
+
+    for (uint i = 0; i < number_of_timers; i++) {
+        if (time_reached(timers[i].next)) {
+            timers[i].handler();
+            // Keep a steady period, but don't try to catch up on missed runs
+            timers[i].next = delayed_by_ms(timers[i].next, timers[i].period_ms);
+            if (time_reached(timers[i].next)) {
+                timers[i].next = make_timeout_time_ms(timers[i].period_ms);
+            }
+        }
+        if (absolute_time_diff_us(timers[i].next, next) > 0) {
+            next = timers[i].next;
+        }
+    }
+    return next;
+}
+
+void EventLoop::sleep_until_irq(const absolute_time_t deadline, WorkCheck has_work) {
+    // An alarm at the deadline guarantees an interrupt to wake up from
+    alarm_id_t alarm = 0;
+    if (!is_nil_time(deadline) && !is_at_the_end_of_time(deadline)) {
+        if (time_reached(deadline)) {
+            return;
+        }
+        alarm = add_alarm_at(deadline, &EventLoop::on_wake_alarm, NULL, true);
+    }
+
+    uint64_t start = time_us_64();
+    uint32_t status = save_and_disable_interrupts();
+    if (!has_work()) {
+        // A pending interrupt wakes WFI even while interrupts are masked;
+        // its handler runs as soon as they are restored below
+        __wfi();
+    }
+    restore_interrupts(status);
+    account(start);
+
+    if (alarm > 0) {
+        cancel_alarm(alarm);
+    }
+}
+
+void EventLoop::sleep_until_event(const absolute_time_t deadline) {
+    uint64_t start = time_us_64();
+    // Returns on an event (SEV from the other core or an alarm) or at the deadline
+    best_effort_wfe_or_timeout(deadline);
+    account(start);
+}
+
+const IdleStats &EventLoop::get_idle_stats(const uint core) {
+    return idle_stats[core];
+}
+
+void EventLoop::reset_idle_stats() {
+    IdleStats &stats = idle_stats[get_core_num()];
+    stats.wakeups = 0;
+    stats.asleep_us = 0;
+    stats.since_us = time_us_64();
+}
+
+void EventLoop::account(const uint64_t start_us) {
+    IdleStats &stats = idle_stats[get_core_num()];
+    stats.wakeups++;
+    stats.asleep_us += time_us_64() - start_us;
+}
+
+int64_t EventLoop::on_wake_alarm(alarm_id_t id, void *user_data) {
+    (void)id;
+    (void)user_data;
+    // Don't reschedule the alarm
+    return 0;
+}
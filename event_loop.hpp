@@ -0,0 +1,81 @@
+#ifndef __EVENT_LOOP_HPP__
+#define __EVENT_LOOP_HPP__
+
+#include "pico/stdlib.h"
+#include "pico/time.h"
+#include <stdint.h>
+
+// Struct for storing the idle statistics of one core
+// @field wakeups Number of times the core woke from sleep
+// @field asleep_us Total time spent asleep
+// @field since_us Time the statistics were last reset
+typedef struct {
+    uint32_t wakeups;
+    uint64_t asleep_us;
+    uint64_t since_us;
+} IdleStats;
+
+// Small per-core event scheduler with low-power idle
+// A core runs its due timers, handles pending work and then sleeps until
+// the next timer or an interrupt (core 0, WFI) or event (core 1, WFE) arrives
+class EventLoop {
+    public:
+        static const uint MAX_TIMERS = 4;
+        static const uint NUMBER_OF_CORES = 2;
+
+        // Function run by a timer
+        typedef void (*TimerHandler)(void);
+
+        // Function returning true while there is work waiting, checked with
+        // interrupts disabled right before the core goes to sleep
+        typedef bool (*WorkCheck)(void);
+
+        // Constructor
+        EventLoop();
+
+        // Registers handler to run every period_ms, starting one period from now
+        // @return false if all MAX_TIMERS slots are taken
+        bool add_timer(const uint32_t period_ms, TimerHandler handler);
+
+        // Runs every due timer
+        // @return The time at which the next timer is due
+        absolute_time_t run_timers();
+
+        // Core 0: sleeps with WFI until an interrupt fires or the deadline passes
+        // The check runs with interrupts disabled, so work queued by an IRQ just
+        // before the WFI can't be missed: the pending IRQ wakes the core at once
+        // @param deadline Latest wake-up time, nil_time to wait for an interrupt only
+        // @param has_work Skip sleeping if this returns true
+        static void sleep_until_irq(const absolute_time_t deadline, WorkCheck has_work);
+
+        // Core 1: sleeps with WFE until an event (e.g. a FIFO push from the other
+        // core, which signals SEV) or the deadline
+        static void sleep_until_event(const absolute_time_t deadline);
+
+        // Returns the idle statistics of the given core
+        static const IdleStats &get_idle_stats(const uint core);
+
+        // Restarts the idle statistics of the calling core
+        static void reset_idle_stats();
+
+    private:
+        // Struct for storing one repeating timer
+        typedef struct {
+            TimerHandler handler;
+            uint32_t period_ms;
+            absolute_time_t next;
+        } Timer;
+
+        Timer timers[MAX_TIMERS];
+        uint number_of_timers;
+
+        static IdleStats idle_stats[NUMBER_OF_CORES];
+
+        // Adds the time asleep to the calling core's statistics
+        static void account(const uint64_t start_us);
+
+        // Alarm callback that only exists to raise an interrupt and wake core 0
+        static int64_t on_wake_alarm(alarm_id_t id, void *user_data);
+};
+
+#endif  // __EVENT_LOOP_HPP__
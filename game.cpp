@@ -1,16 +1,30 @@
 #include "game.hpp"
+#include "channel.hpp"
+#include "event_loop.hpp"
+#include "led.hpp"
+#include "output.hpp"
+#include "solved3.hpp"
+#include "solved4.hpp"
+#include "stats_store.hpp"
+#include "text.hpp"
+#include "trace.hpp"
 #include "hardware/gpio.h"
 #include "pico/multicore.h"
 #include "pico/time.h"
 #include <array>
 #include <cstdint> 
 #include <cstddef>
-#include <iostream>
-#include <ostream>
 
 using namespace std;
 
-Game::Game() {
+// Default record sink: the binary record goes out between the frames
+static void write_record(const uint8_t *record, size_t length) {
+    Output::write(reinterpret_cast<const char *>(record), length);
+}
+
+GameBase::GameBase(const uint rows, const uint cols)
+    : renderer(rows, cols), board_cols(cols), record_sink(write_record), game_number(0),
+      is_recorded(true) {
     // Initialize game variables such as game board and other variables here
     // Pull-up the buttons to get them to work
     gpio_pull_up(BTN1);
@@ -19,135 +33,128 @@ Game::Game() {
 }
 
 // void init_gpio(GpioConfig *gpio, size_t len);
-void Game::init_gpio(GpioConfig (&gpio)[NUMBER_OF_GPIOS]) {
+void GameBase::init_gpio(GpioConfig (&gpio)[NUMBER_OF_GPIOS]) {
     // Loop through the GpioConfig array length
     // Initialize the LEDs, BTNs and set respective directions (IP/OP)
-    for (size_t i = 0; i < Game::NUMBER_OF_GPIOS; i++) {
+    for (size_t i = 0; i < NUMBER_OF_GPIOS; i++) {
         gpio_init(gpio[i].pin_number);
         gpio_set_dir(gpio[i].pin_number, gpio[i].pin_dir);
     }
-}
 
-bool Game::debounce(const volatile BtnState &btn) {
-    // Checks whether btn state has changed or not
-    if (has_changed(btn.prev_state, btn.curr_state)) {
-        // Checks whether btn state is stable
-        if (is_stable(btn.but_pin, btn.curr_state)) {
-            // Return true if btn state has changed and is stable
-            return true;
-        }
-    }
-    // Return false if btn state has not changed or is not stable
-    return false;
+    // Hand the LEDs over to their PWM slices
+    const uint leds[NUMBER_OF_LEDS] = {LED1, LED2, ONBOARD_LED};
+    LedPatterns::init(leds, NUMBER_OF_LEDS);
 }
 
-bool Game::is_stable(const uint button, const bool prev_state) {
-    // Wait for the specified amount of time i.e., 500ms
-    sleep_ms(DEBOUNCE_DELAY);
-    // Now get the current state of the button
-    uint current_state = gpio_get(button);
-    // Check if previous and current state of the button is high
-    if (prev_state == HIGH && current_state == HIGH) {
-        // Optionally print a message if button state is stable if 
-        // the preprocessor macro "VERBOSE" is defined
-        #ifdef VERBOSE
-            printf("Button state is stable");
-        #endif
-
-        // Returns true if button state is stable
-        return true;
-    }
-    // Returns false if button state is not stable
-    return false;
+template <uint Rows, uint Cols, uint K>
+Game<Rows, Cols, K>::Game() : GameBase(Rows, Cols) {
 }
 
-bool Game::has_changed(bool prev_state, bool curr_state) {
-    // Edge detector - Checks if previous state is LOW and current state if HIGH    
-    bool changed = (prev_state == LOW && curr_state == HIGH);
-    // Optionally print a message if button state is stable if 
-    // the preprocessor macro "VERBOSE" is defined
-    #ifdef VERBOSE
-        if(changed) {
-            printf("Button state is stable");
-        }
-    #endif    
+template <uint Rows, uint Cols, uint K>
+const typename Game<Rows, Cols, K>::Action Game<Rows, Cols, K>::ACTIONS[NUMBER_OF_GAME_ACTIONS] = {
+    &Game::ignore_event,            // GAME_ACTION_NONE
+    &Game::move_cursor_next,        // GAME_ACTION_CURSOR_NEXT
+    &Game::move_cursor_back,        // GAME_ACTION_CURSOR_BACK
+    &Game::handle_btn2,             // GAME_ACTION_PLACE
+    &Game::handle_ai_turn,          // GAME_ACTION_ENGINE_MOVE
+    &Game::celebrate_win,           // GAME_ACTION_WIN
+    &Game::record_tie,              // GAME_ACTION_TIE
+    &Game::reset_board,             // GAME_ACTION_RESET
+    &Game::restart_after_tie,       // GAME_ACTION_RESTART
+    &Game::ask_reset_confirmation,  // GAME_ACTION_ASK_CONFIRMATION
+    &Game::handle_undo,             // GAME_ACTION_UNDO
+    &Game::show_game_over,          // GAME_ACTION_GAME_OVER
+};
+
+template <uint Rows, uint Cols, uint K>
+void Game<Rows, Cols, K>::dispatch(State *state, const GameEvent event) {
+    TRACE_BEGIN(stamp);
+
+    // One table load and one indexed call per event, follow-ups included
+    GameEvent next = event;
+    while (next != GAME_EVENT_NONE) {
+        const GameTransition transition = GameMachine::get_transition(next, state->phase);
+        state->phase = transition.next;
+        next = (this->*ACTIONS[transition.action])(state);
+    }
 
-    // Returns true if button state has changed, false otherwise
-    return changed;
-}
+    // Draw the event and its follow-ups (e.g. the engine's reply) in one frame
+    print_board(state->board);
 
-void Game::update_btn_state(volatile BtnState *btn) {
-    // Check if the current state of the button is 0
-    if (btn->curr_state == 0) {
-        // If yes, then set previous state of the button to 0
-        btn->prev_state = 0;
-    }
-    // Check if the current state of the button is 1
-    else if(btn->curr_state == 1) {
-        // If yes, then set previous state of the button to 1
-        btn->prev_state = 1;
+    if (event == GAME_EVENT_PLACE) {
+        TRACE_END(TRACE_BTN2, stamp);
+    } else if (event == GAME_EVENT_CURSOR_NEXT || event == GAME_EVENT_CURSOR_BACK) {
+        TRACE_END(TRACE_BTN1, stamp);
     }
-    // Update current state of the button by reading the button pin
-    btn->curr_state = gpio_get(btn->but_pin);
 }
 
-void Game::reset_board(char *current_player, uint *moves, char (*board)[COLS], 
-                       bool *is_game_over) {
-    // Print message indicating board is being reset
-    cout << "Reset board" << endl;
-    for (int i = 0; i < ROWS; i++) {
-        for (int j = 0; j < COLS; j++) {
-            // Set each cell value to EMPTY i.e., ' '
-            board[i][j] = EMPTY;
-        }
+template <uint Rows, uint Cols, uint K>
+GameEvent Game<Rows, Cols, K>::reset_board(State *state) {
+    // Keep a record of a game that was reset before it was decided
+    if (!is_recorded && history.get_count() > 0) {
+        send_record(RESULT_ABANDONED);
     }
+    history.start_game();
+    game_number++;
+    is_recorded = false;
 
-    // Reset the number of moves to 0
-    *moves = 0;
+    // Show message indicating board is being reset
+    renderer.set_message("Reset board");
 
-    // Reset the current player to "X"
-    *current_player = X;
+    // Clear both players' masks, setting every cell to EMPTY
+    state->board.x = 0;
+    state->board.o = 0;
 
-    // Reset the game over flag to false
-    *is_game_over = false;
+    // Reset the cursor to cell 0
+    state->cursor = 0;
 
-    // Call the function "print_board" with the board as an argument
-    print_board(board);
+    // Reset the current player to "X"
+    state->player = X;
+
+    // Call the function "print_player_turn" with the current player as the argument
+    print_player_turn(state->player);
 
-    // Call the function "print_player_turn" with current_player as the argument
-    print_player_turn(*current_player);
+    // Light X's LED and blink the onboard LED while waiting for moves (a
+    // blink needs 2 updates a second, breathing would need 50)
+    update_player_led(state->player);
+    LedPatterns::show(ONBOARD_LED, LedPatterns::blink(HEARTBEAT_PERIOD));
+    renderer.set_cursor(state->cursor);
 
-    // Call the function "multicore_fifo_push_blocking" with EMPTY as the arg
-    // Push EMPTY to each cell on the board
-    multicore_fifo_push_blocking(EMPTY);
+    // In single-player mode the engine opens the game if it plays X
+    return (engine != nullptr && state->player == ai_player) ? GAME_EVENT_ENGINE_TURN
+                                                             : GAME_EVENT_NONE;
 }
 
-uint Game::get_curr_row(const uint moves) {
+template <uint Rows, uint Cols, uint K>
+uint Game<Rows, Cols, K>::get_curr_row(const uint moves) {
     // Return the current row in the game board
-    // Divide the number of moves by ROWS (which is 3) 
+    // Divide the number of moves by COLS (3 on the classic board) 
     // 0 to 8 represent the cell numbers below: 
     // 0/3 = 0; 1/3 = 0; 2/3 = 0; --> Row 0
     // 3/3 = 1; 4/3 = 1; 5/3 = 1; --> Row 1
     // 6/3 = 2; 7/3 = 2; 8/3 = 2; --> Row 2
-    return static_cast<uint>(moves) / ROWS;
+    return static_cast<uint>(moves) / COLS;
 }
 
-uint Game::get_next_row(const uint moves) {
+template <uint Rows, uint Cols, uint K>
+uint Game<Rows, Cols, K>::get_next_row(const uint moves) {
     // C -> Cell; R -> ROW
     // (C2 + 1) / 3 = R1; (C5 + 1) / 3 = R2;
-    return static_cast<uint>(moves + 1) / ROWS;
+    return static_cast<uint>(moves + 1) / COLS;
 }
 
-uint Game::get_next_col(const uint moves) {
+template <uint Rows, uint Cols, uint K>
+uint Game<Rows, Cols, K>::get_next_col(const uint moves) {
     // Return the next column on the board based on:
     // C -> Cell; C -> COLS
     // (C0 + 1) % 3 = C1; (C1 + 1) / 3 = C2;
     return static_cast<uint>(moves + 1) % COLS;
 }
 
-uint Game::get_curr_col(const uint moves) {
+template <uint Rows, uint Cols, uint K>
+uint Game<Rows, Cols, K>::get_curr_col(const uint moves) {
     // Return the current column in the game board
-    // Divide the number of moves by COLS (which is 3) 
+    // Take the number of moves modulo COLS (3 on the classic board) 
     // 0 to 8 represent the cell numbers below: 
     // 0%3 = 0; 1%3 = 1; 2%3 = 2; --> Column 0, 1, 2
     // 3%3 = 0; 4%3 = 1; 5%3 = 2; --> Column 0, 1, 2
@@ -155,222 +162,619 @@ uint Game::get_curr_col(const uint moves) {
     return static_cast<uint>(moves) % COLS;
 }
 
-void Game::update_position(uint *moves) {
-    // Calculate the next row and column of the board
-    uint next_row = get_next_row(*moves);
-    uint next_col = get_next_col(*moves);
+template <uint Rows, uint Cols, uint K>
+void Game<Rows, Cols, K>::update_position(uint *moves, const Board &board, const bool is_reverse) {
+    uint next = find_empty_cell(*moves, board, is_reverse);
 
-    // Check if the next position is within the valid range of the board
-    if (is_valid_pos(next_row, next_col)) {
-        (*moves)++;
-    } else {
-        #ifdef VERBOSE
+    #ifdef VERBOSE
+        if (is_reverse ? next > *moves : next < *moves) {
             // Prints message to indicate start of new round
-            printf("Starting new round");
-        #endif
+            static const char NEW_ROUND[] = "Starting new round" TEXT_NEWLINE;
+            Output::write(NEW_ROUND, sizeof(NEW_ROUND) - 1);
+        }
+    #endif
+
+    *moves = next;
+}
+
+template <uint Rows, uint Cols, uint K>
+uint Game<Rows, Cols, K>::find_empty_cell(const uint cell, const Board &board, 
+                                          const bool is_reverse) {
+    const Mask one = 1;
+    Mask empty = static_cast<Mask>(~(board.x | board.o) & Geometry::FULL_BOARD);
+    if (empty == 0) {
+        return cell;
+    }
 
-        // Reset the moves counter
-        *moves = 0;
+    if (!is_reverse) {
+        // The lowest free cell above the cursor, else the lowest overall
+        Mask after = static_cast<Mask>(empty & ~((one << cell << 1) - 1));
+        Mask candidates = (after != 0) ? after : empty;
+        return static_cast<uint>(__builtin_ctzll(static_cast<unsigned long long>(candidates)));
     }
+    // The highest free cell below the cursor, else the highest overall
+    Mask before = static_cast<Mask>(empty & ((one << cell) - 1));
+    Mask candidates = (before != 0) ? before : empty;
+    return static_cast<uint>(63 - __builtin_clzll(static_cast<unsigned long long>(candidates)));
 }
 
-void Game::print_curr_pos(const uint row, const uint col) {
-    cout << "Row: " << row << " Col: " << col << endl;
+void GameBase::print_curr_pos(const uint row, const uint col) {
+    // Highlight the cell and show its coordinates, drawn by the next flush
+    Renderer::Line text;
+    renderer.set_cursor(row * board_cols + col);
+    renderer.set_message(text.format("Row: %u Col: %u", row, col).c_str());
 }
 
-bool Game::is_valid_pos(const uint row, const uint col) {
+template <uint Rows, uint Cols, uint K>
+bool Game<Rows, Cols, K>::is_valid_pos(const uint row, const uint col) {
     // Returns true if both row and column are greater than or equal to 0 and 
-    // less than ROWS (3) and COLS (3) respectively
+    // less than ROWS and COLS respectively
     return (row < ROWS && col < COLS);
 }
 
-bool Game::is_empty_pos(uint const row, uint col, const char (*board)[COLS]) {
+template <uint Rows, uint Cols, uint K>
+bool Game<Rows, Cols, K>::is_empty_pos(uint const row, uint col, const Board &board) {
+    // Returns true if the cell's bit is set in neither player's mask
+    return ((board.x | board.o) & (static_cast<Mask>(1) << (row * COLS + col))) == 0;
+}
+
+template <uint Rows, uint Cols, uint K>
+bool Game<Rows, Cols, K>::is_empty_pos(uint const row, uint col, const char (*board)[COLS]) {
     // Returns true if cell is empty
     return (board[row][col] == EMPTY);
 }
 
-void Game::update_board(const char current_player, const uint moves, char (*board)[COLS]) {
+template <uint Rows, uint Cols, uint K>
+void Game<Rows, Cols, K>::update_board(const char current_player, const uint moves, Board *board) {
+    uint row = get_curr_row(moves);
+    uint col = get_curr_col(moves);
+    // Show current player's input being entered to the respective row column
+    show_move(current_player, row, col);
+
+    // Set the cell's bit in the current player's mask
+    // The cell number equals moves, i.e. row * COLS + col
+    Mask cell = static_cast<Mask>(static_cast<Mask>(1) << moves);
+    if (current_player == X) {
+        board->x |= cell;
+    } else {
+        board->o |= cell;
+    }
+    renderer.set_cell(moves, current_player);
+}
+
+template <uint Rows, uint Cols, uint K>
+void Game<Rows, Cols, K>::update_board(const char current_player, const uint moves, char (*board)[COLS]) {
     uint row = get_curr_row(moves);
     uint col = get_curr_col(moves);
-    // Print current player's input being entered to the respective row column
-    cout << "Entering player " << current_player << "input into row " << row << " col " << col << endl;
+    // Show current player's input being entered to the respective row column
+    show_move(current_player, row, col);
 
     // Update the board at the calculated row and col with the current player's input
     board[row][col] = current_player;
 }
 
-void Game::print_board(const char (*board)[COLS]) {
-    // ANSI escape coe to clear the terminal screen, effectively erasing all content, 
-    // and move the cursor to the top-left corner
-    cout << "\e[1;1H\e[2J";
+template <uint Rows, uint Cols, uint K>
+typename Game<Rows, Cols, K>::Mask Game<Rows, Cols, K>::get_player_mask(const char player, const Board &board) {
+    // Return the mask of player X or O, any other character owns no cells
+    if (player == X) {
+        return board.x;
+    } else if (player == O) {
+        return board.o;
+    }
+    return 0;
+}
 
-    // Print the vertical separators except for the last column
+template <uint Rows, uint Cols, uint K>
+char Game<Rows, Cols, K>::get_cell(const uint row, const uint col, const Board &board) {
+    Mask cell = static_cast<Mask>(static_cast<Mask>(1) << (row * COLS + col));
+    if (board.x & cell) {
+        return X;
+    } else if (board.o & cell) {
+        return O;
+    }
+    return EMPTY;
+}
+
+template <uint Rows, uint Cols, uint K>
+typename Game<Rows, Cols, K>::Board Game<Rows, Cols, K>::to_bitboard(const char (*board)[COLS]) {
+    Board bitboard = {0, 0};
     for (int i = 0; i < ROWS; i++) {
         for (int j = 0; j < COLS; j++) {
-            cout << " " << board[i][j] << " ";
-
-            if (j < COLS - 1) {
-                cout << "|";
+            // Set the cell's bit in the mask of the player occupying it
+            Mask cell = static_cast<Mask>(static_cast<Mask>(1) << (i * COLS + j));
+            if (board[i][j] == X) {
+                bitboard.x |= cell;
+            } else if (board[i][j] == O) {
+                bitboard.o |= cell;
             }
         }
+    }
+    return bitboard;
+}
 
-        // Print the horizontal separators except for the last row
-        if (i < ROWS - 1) {
-            cout << endl << "---+---+---" << endl;
-        } else {
-            cout << endl;
-        }
+template <uint Rows, uint Cols, uint K>
+void Game<Rows, Cols, K>::print_board(const Board &board) {
+    TRACE_SCOPE(TRACE_PRINT_BOARD);
+    // Copy every cell into the renderer's frame
+    for (uint cell = 0; cell < CELLS; cell++) {
+        renderer.set_cell(cell, get_cell(cell / COLS, cell % COLS, board));
     }
+
+    // Redraw only the cells, highlight and text lines that changed since the
+    // last frame, as cursor-addressed ANSI updates batched into one write
+    renderer.flush();
 }
 
-void Game::print_player_turn(const char current_player) {
-    // Print the "Player %c turn" message 
-    cout << "Player " << current_player << " turn" << endl;
+template <uint Rows, uint Cols, uint K>
+void Game<Rows, Cols, K>::print_board(const char (*board)[COLS]) {
+    print_board(to_bitboard(board));
 }
 
-void Game::update_player_led(const char current_player) {
-    if (current_player == X) {
-        gpio_put(LED1, HIGH);
-        gpio_put(LED2, LOW);
-    }
-    else if (current_player == O) {
-        gpio_put(LED1, LOW);
-        gpio_put(LED2, HIGH);
-    }
-    else {
-        gpio_put(LED1, LOW);
-        gpio_put(LED2, LOW);
+void GameBase::print_player_turn(const char current_player) {
+    // Show the "Player %c turn" status, drawn by the next flush
+    Renderer::Line text;
+    renderer.set_status(text.format("Player %c turn", current_player).c_str());
+}
+
+void GameBase::show_move(const char current_player, const uint row, const uint col) {
+    Renderer::Line text;
+    text.format("Player %c played row %u col %u", current_player, row, col);
+    renderer.set_message(text.c_str());
+}
+
+void GameBase::show_stats(const GameStats &stats) {
+    // W-L-D per player, the best run of wins and the average game length in tenths
+    const PlayerStats &x = stats.players[0];
+    const PlayerStats &o = stats.players[1];
+    uint tenths = (stats.games > 0) ? (10 * stats.total_moves + stats.games / 2) / stats.games : 0;
+    Renderer::Line text;
+    text.format("X %u-%u-%u best %u, O %u-%u-%u best %u, %u.%u moves/game",
+                static_cast<uint>(x.wins), static_cast<uint>(x.losses), static_cast<uint>(x.draws),
+                static_cast<uint>(x.best_streak), static_cast<uint>(o.wins),
+                static_cast<uint>(o.losses), static_cast<uint>(o.draws),
+                static_cast<uint>(o.best_streak), tenths / 10, tenths % 10);
+    renderer.set_message(text.c_str());
+    renderer.flush();
+}
+
+void GameBase::show_message(const char *text) {
+    renderer.set_message(text);
+    renderer.flush();
+}
+
+void GameBase::redraw() {
+    renderer.invalidate();
+    renderer.flush();
+}
+
+uint16_t GameBase::get_game_number() {
+    return game_number;
+}
+
+const RenderStats &GameBase::get_render_stats() {
+    return renderer.get_stats();
+}
+
+void GameBase::set_render_sink(Renderer::Sink sink) {
+    renderer.set_sink(sink);
+}
+
+void GameBase::set_record_sink(GameRecords::Sink sink) {
+    record_sink = (sink != nullptr) ? sink : write_record;
+}
+
+void GameBase::update_player_led(const char current_player) {
+    // Only called when the player changes, the PWM holds the levels in between
+    LedPatterns::show(LED1, (current_player == X) ? LedPatterns::on() : LedPatterns::off());
+    LedPatterns::show(LED2, (current_player == O) ? LedPatterns::on() : LedPatterns::off());
+}
+
+void GameBase::show_winner(const char winner) {
+    // The chase starts at the winner's LED
+    const uint leds[NUMBER_OF_LEDS] = {
+        (winner == X) ? LED1 : LED2,
+        (winner == X) ? LED2 : LED1,
+        ONBOARD_LED
+    };
+
+    for (uint i = 0; i < NUMBER_OF_LEDS; i++) {
+        LedPattern chase = LedPatterns::chase(i, NUMBER_OF_LEDS, CHASE_STEP, CHASE_CYCLES);
+        // Afterwards only the winner's LED keeps blinking, toggling every BLINK_LED_DELAY
+        LedPattern then = (i == 0) ? LedPatterns::blink(2 * BLINK_LED_DELAY) : LedPatterns::off();
+        LedPatterns::show(leds[i], chase, then);
     }
 }
 
-void Game::flash_winner_led(){
-    uint32_t winner = static_cast<uint32_t>(EMPTY);
-    uint led_pin = ONBOARD_LED;
+template <uint Rows, uint Cols, uint K>
+typename Game<Rows, Cols, K>::AiEngine *Game<Rows, Cols, K>::shared_engine = nullptr;
+
+template <uint Rows, uint Cols, uint K>
+void Game<Rows, Cols, K>::run_worker() {
+    EventLoop::reset_idle_stats();
+    Trace::init_core();
+
+    // From now on core 0 only queues its console output, this core writes it
+    Output::start_draining();
 
     while (true) {
-        if (multicore_fifo_rvalid()) {
-            // Pop a value from "multicore_fifo" and 
-            // store it in variable winner
-            winner = multicore_fifo_pop_blocking();
+        // Answer every request core 0 has sent
+        Message message;
+        while (Channel::receive(&message)) {
+            Message reply = {};
+            reply.id = message.id;
+
+            switch (message.type) {
+                case MSG_STATS_REQUEST:
+                    // Only this core writes its statistics, so its copy is consistent
+                    reply.type = MSG_STATS;
+                    reply.stats = EventLoop::get_idle_stats(1);
+                    Channel::send(reply);
+                    break;
+                case MSG_SEARCH_REQUEST:
+                    if (shared_engine != nullptr) {
+                        // Search alongside core 0 until its search ends, the
+                        // engine merges the results in shared SRAM
+                        Board board = {static_cast<Mask>(message.search.x),
+                                       static_cast<Mask>(message.search.o)};
+                        shared_engine->help(board, message.player, message.search.budget_us,
+                                            message.id);
+                        break;
+                    }
+                    // Without an engine, answer that there is no move
+                    reply.type = MSG_SEARCH_RESULT;
+                    reply.player = message.player;
+                    reply.result.cell = -1;
+                    Channel::send(reply);
+                    break;
+                case MSG_FLASH_PARK:
+                    // Returns once core 0 has saved the statistics
+                    StatsStore::park();
+                    break;
+                default:
+                    break;
+            }
         }
 
-        if ((char)winner == X) {
-            led_pin = LED1;
-        } else if ((char)winner == O) {
-            led_pin = LED2;
-        } else {
-            led_pin = ONBOARD_LED;
-        }
+        // Send the console output, the USB writes may block this core only
+        Output::drain();
 
-        gpio_put(led_pin, HIGH);
-        sleep_ms(BLINK_LED_DELAY);
-        gpio_put(led_pin, LOW);
-        sleep_ms(BLINK_LED_DELAY);
+        // Sleep until core 0 rings the doorbell or queues output (a FIFO
+        // push or a write signals SEV, which ends the WFE)
+        EventLoop::sleep_until_event(at_the_end_of_time);
     }
 }
 
-void Game::handle_btn1(uint *moves) {
-    // Update the position of moves
-    update_position(moves);
+template <uint Rows, uint Cols, uint K>
+GameEvent Game<Rows, Cols, K>::handle_btn1(State *state, const bool is_reverse) {
+    // Move the cursor to the next empty cell
+    uint cursor = state->cursor;
+    update_position(&cursor, state->board, is_reverse);
+    state->cursor = static_cast<uint8_t>(cursor);
 
-    uint curr_row = get_curr_row(*moves);
+    uint curr_row = get_curr_row(cursor);
 
-    uint curr_col = get_curr_col(*moves);
+    uint curr_col = get_curr_col(cursor);
 
     print_curr_pos(curr_row, curr_col);
+    return GAME_EVENT_NONE;
 }
 
-void Game::handle_btn2(char *current_player, uint *moves, char (*board)[COLS], 
-                       bool *is_game_over) {
-    uint row = get_curr_row(*moves);
-    uint col = get_curr_col(*moves);
+template <uint Rows, uint Cols, uint K>
+GameEvent Game<Rows, Cols, K>::handle_btn2(State *state) {
+    uint row = get_curr_row(state->cursor);
+    uint col = get_curr_col(state->cursor);
 
     // Check if position (row, col) is valid
     if (!is_valid_pos(row, col)) {
-        // If position is not valid, print below message
-        cout << "Invalid selection row " << row << " col " << col << endl;
+        // If position is not valid, show below message
+        Renderer::Line text;
+        renderer.set_message(text.format("Invalid selection row %u col %u", row, col).c_str());
         // Return from the function
-        return;
+        return get_unchanged_event(*state);
     }
 
     // Check if position (row, col) is empty
-    if (!is_empty_pos(row, col, board)) {
-        // If position is not empty, print below message
-        cout << "Row " << row << " Col " << col << " is not empty" << endl;
-        cout << "Please select another location" << endl;
+    if (!is_empty_pos(row, col, state->board)) {
+        // If position is not empty, show below message
+        Renderer::Line text;
+        text.format("Row %u Col %u is not empty, please select another location", row, col);
+        renderer.set_message(text.c_str());
         // Return from the function
-        return;
+        return get_unchanged_event(*state);
     }
 
-    // Update the board
-    update_board(*current_player, *moves, board);
-    // Print the board
-    print_board(board);
-
-    // Check if there's a win
-    if (is_win(*current_player, board)) {
-        cout << "Player " << *current_player << " wins!" << endl;
-    // Push the winner *current_player
-    multicore_fifo_push_blocking(*current_player);
-    // Set game over as true
-    *is_game_over = true;
-    cout << "Please press the reset button to start the game" << endl;
-    } else if (is_tie(board)) {
-        printf("Tie game! \n");
-        reset_board(current_player, moves, board, is_game_over);
+    // Place the human player's move
+    GameEvent outcome = place_move(state);
+
+    // In single-player mode the engine replies straight away, in the same frame
+    if (outcome == GAME_EVENT_NONE && engine != nullptr && state->player == ai_player) {
+        return GAME_EVENT_ENGINE_TURN;
+    }
+    return outcome;
+}
+
+template <uint Rows, uint Cols, uint K>
+GameEvent Game<Rows, Cols, K>::place_move(State *state) {
+    // Update the board, the dispatch draws it
+    update_board(state->player, state->cursor, &state->board);
+    history.push(state->cursor);
+
+    // Check if the move just made completes a line. Scanning every line is
+    // faster while there are few (8 on 3x3, 10 on 4x4), the larger boards
+    // only check the lines through the cell
+    bool is_won = false;
+    if constexpr (Geometry::NUMBER_OF_WIN_MASKS <= FULL_SCAN_WIN_MASKS) {
+        is_won = is_win(state->player, state->board);
     } else {
-        *moves = 0;
-        *current_player = get_new_player(*current_player);
-        print_player_turn(*current_player);
+        is_won = is_win_at(state->player, state->cursor, state->board);
+    }
+    if (is_won) {
+        return GAME_EVENT_WON;
     }
+    if (is_tie(state->board)) {
+        return GAME_EVENT_TIED;
+    }
+
+    // Park the cursor on the first empty cell
+    state->cursor = static_cast<uint8_t>(find_empty_cell(CELLS - 1, state->board, false));
+    state->player = get_new_player(state->player);
+    print_player_turn(state->player);
+    update_player_led(state->player);
+    renderer.set_cursor(state->cursor);
+    return GAME_EVENT_NONE;
 }
 
-char Game::get_new_player(char current_player) {
-    // Return the next player symbol
-    return (current_player == X) ? O : X;
+template <uint Rows, uint Cols, uint K>
+GameEvent Game<Rows, Cols, K>::celebrate_win(State *state) {
+    Renderer::Line text;
+    text.format("Player %c wins! Please press the reset button to start the game", 
+                state->player);
+    renderer.set_status(text.c_str());
+    // Celebrate with a chase over the LEDs, then keep flashing the winner's
+    show_winner(state->player);
+    send_record((state->player == X) ? RESULT_X_WIN : RESULT_O_WIN);
+    renderer.set_cursor(state->cursor);
+    return GAME_EVENT_NONE;
 }
 
- bool Game::is_win(const char player, const char (*board)[COLS]) {
-    for (int i = 0; i < ROWS; i++) {
-        // Check if all the element in the row are equal to the player
-        if (board[i][0] == player && board[i][1] == player && 
-            board[i][2] == player) {
-                // Player wins!
-                return true;
-            }
+template <uint Rows, uint Cols, uint K>
+GameEvent Game<Rows, Cols, K>::record_tie(State *state) {
+    (void)state;
+    send_record(RESULT_TIE);
+    // A tied board is reset straight away, through the TIE column
+    return GAME_EVENT_RESET_CONFIRMED;
+}
+
+template <uint Rows, uint Cols, uint K>
+GameEvent Game<Rows, Cols, K>::restart_after_tie(State *state) {
+    GameEvent next = reset_board(state);
+    renderer.set_message("Tie game! Board reset");
+    return next;
+}
+
+template <uint Rows, uint Cols, uint K>
+GameEvent Game<Rows, Cols, K>::ask_reset_confirmation(State *state) {
+    (void)state;
+    renderer.set_message("Press reset twice to start a new game");
+    return GAME_EVENT_NONE;
+}
+
+template <uint Rows, uint Cols, uint K>
+GameEvent Game<Rows, Cols, K>::show_game_over(State *state) {
+    // A decided game has been recorded, only a reset starts over
+    (void)state;
+    renderer.set_message("Game over, press reset to start a new game");
+    return GAME_EVENT_NONE;
+}
+
+template <uint Rows, uint Cols, uint K>
+GameEvent Game<Rows, Cols, K>::ignore_event(State *state) {
+    (void)state;
+    return GAME_EVENT_NONE;
+}
+
+template <uint Rows, uint Cols, uint K>
+GameEvent Game<Rows, Cols, K>::move_cursor_next(State *state) {
+    return handle_btn1(state, false);
+}
+
+template <uint Rows, uint Cols, uint K>
+GameEvent Game<Rows, Cols, K>::move_cursor_back(State *state) {
+    return handle_btn1(state, true);
+}
+
+template <uint Rows, uint Cols, uint K>
+GameEvent Game<Rows, Cols, K>::get_unchanged_event(const State &state) {
+    return ((state.board.x | state.board.o) == 0) ? GAME_EVENT_EMPTIED : GAME_EVENT_NONE;
+}
+
+template <uint Rows, uint Cols, uint K>
+GameEvent Game<Rows, Cols, K>::handle_undo(State *state) {
+    // Take back the last move, and in single-player mode the engine's reply
+    // along with the human move before it
+    uint cell = 0;
+    bool is_undone = false;
+    while (history.pop(&cell)) {
+        Mask mask = static_cast<Mask>(~(static_cast<Mask>(1) << cell));
+        state->board.x &= mask;
+        state->board.o &= mask;
+        state->player = get_new_player(state->player);
+        is_undone = true;
+        if (engine == nullptr || state->player != ai_player) {
+            break;
+        }
     }
 
-    for (int j = 0; j < COLS; j++) {
-        // Check if all the element in the column are equal to the player
-        if (board[0][j] == player && board[1][j] == player &&
-            board[2][j] == player) {
-                // Player wins!
-                return true;
-            }
+    if (!is_undone) {
+        renderer.set_message("Nothing to undo");
+        return get_unchanged_event(*state);
     }
 
-    // Check elements diagonally for winner
-    if (board[0][0] == player && board[1][1] == player && board[2][2] == player) {
-        return true;
+    // Put the cursor back on the cell that was freed
+    state->cursor = static_cast<uint8_t>(cell);
+    Renderer::Line text;
+    renderer.set_message(text.format("Undo row %u col %u", get_curr_row(cell), 
+                                     get_curr_col(cell)).c_str());
+    print_player_turn(state->player);
+    update_player_led(state->player);
+    renderer.set_cursor(state->cursor);
+
+    // If the engine opened the game, it plays its opening move again
+    if (engine != nullptr && state->player == ai_player) {
+        return GAME_EVENT_ENGINE_TURN;
     }
+    return get_unchanged_event(*state);
+}
 
-    if (board[0][2] == player && board[1][1] == player && board[2][0] == player) {
-        return true;
+template <uint Rows, uint Cols, uint K>
+void Game<Rows, Cols, K>::send_record(const GameResult result) {
+    GameRecord record;
+    record.rows = Rows;
+    record.cols = Cols;
+    record.win_length = K;
+    record.result = result;
+    record.game_number = game_number;
+    record.count = static_cast<uint8_t>(history.get_moves(record.cells));
+
+    uint8_t data[GameRecords::MAX_RECORD_SIZE];
+    record_sink(data, GameRecords::encode(record, data));
+    is_recorded = true;
+
+    // Only the RAM copy, the flash is written later from the main loop
+    StatsStore::record_game(result, record.count);
+
+    // The terminal may have shown the record's bytes, repaint it all
+    renderer.invalidate();
+}
+
+template <uint Rows, uint Cols, uint K>
+void Game<Rows, Cols, K>::set_engine(AiEngine *engine, const char ai_player) {
+    this->engine = engine;
+    this->ai_player = ai_player;
+    if (engine != nullptr) {
+        shared_engine = engine;
+    }
+}
+
+template <uint Rows, uint Cols, uint K>
+GameEvent Game<Rows, Cols, K>::handle_ai_turn(State *state) {
+    const Board &board = state->board;
+    int cell = -1;
+    Renderer::Line text;
+
+    // The classic game is solved at compile time, so its reply is a table lookup
+    if constexpr (Rows == 3 && Cols == 3 && K == 3) {
+        int value = Solved3::DRAW;
+        if (Solved3::probe(board, &value, &cell)) {
+            text.format("AI (solved table) expects a %s", 
+                        (value == Solved3::WIN) ? "win" : (value == Solved3::LOSS) ? "loss" : "draw");
+        }
+    }
+
+#if !PICO_ON_DEVICE
+    // The 4x4 game is solved on the host, its database is probed where
+    // mapped. The Pico can't attach one, so the firmware leaves Solved4 out
+    if constexpr (Rows == 4 && Cols == 4 && K == 4) {
+        int value = Solved4::DRAW;
+        if (Solved4::probe(board, &value, &cell)) {
+            text.format("AI (solved database) expects a %s",
+                        (value == Solved4::WIN) ? "win" : (value == Solved4::LOSS) ? "loss" : "draw");
+        }
+    }
+#endif
+
+    if (cell < 0) {
+        // Let core 1 search the position too; if the request is dropped the
+        // engine searches alone
+        Message request = {};
+        request.type = MSG_SEARCH_REQUEST;
+        request.player = ai_player;
+        request.id = engine->open_search();
+        request.search.x = board.x;
+        request.search.o = board.o;
+        request.search.budget_us = AI_BUDGET_US;
+        Channel::send(request);
+
+        // Search for the engine's move within the time budget
+        cell = engine->find_best_move(board, ai_player, AI_BUDGET_US);
+        if (cell < 0) {
+            return GAME_EVENT_MOVED;
+        }
+
+        const SearchStats &stats = engine->get_stats();
+        text.format("AI depth %u nodes %llu in %lluus (%lu nodes/s, TT hit %u%%)", 
+                    stats.depth, static_cast<unsigned long long>(stats.nodes), 
+                    static_cast<unsigned long long>(stats.elapsed_us), 
+                    static_cast<unsigned long>(engine->get_nodes_per_sec()), engine->get_tt_hit_rate());
+    }
+
+    // Place the engine's move at the chosen cell, the dispatch draws it
+    state->cursor = static_cast<uint8_t>(cell);
+    GameEvent outcome = place_move(state);
+
+    // Show how the engine chose its move, a tie replaces it
+    renderer.set_message(text.c_str());
+    return (outcome == GAME_EVENT_NONE) ? GAME_EVENT_MOVED : outcome;
+}
+
+char GameBase::get_new_player(char current_player) {
+    // Return the next player symbol
+    return (current_player == X) ? O : X;
+}
+
+template <uint Rows, uint Cols, uint K>
+bool Game<Rows, Cols, K>::is_win(const char player, const Board &board) {
+    TRACE_SCOPE(TRACE_IS_WIN);
+    Mask mask = get_player_mask(player, board);
+    for (uint i = 0; i < Geometry::NUMBER_OF_WIN_MASKS; i++) {
+        // Check if the player owns every cell of the winning line
+        if ((mask & Geometry::WIN_MASKS[i]) == Geometry::WIN_MASKS[i]) {
+            // Player wins!
+            return true;
+        }
     }
 
     // Player has not won
     return false;
- }
+}
 
-bool Game::is_tie(const char (*board)[COLS]) {
-    for (int i = 0; i < ROWS; i++) {
-        for (int j = 0; j < COLS; j++) {
-            if (board[i][j] == EMPTY) {
-                // Return no tie if the cell is empty
-                return false;
-            }
+template <uint Rows, uint Cols, uint K>
+bool Game<Rows, Cols, K>::is_win(const char player, const char (*board)[COLS]) {
+    return is_win(player, to_bitboard(board));
+}
+
+template <uint Rows, uint Cols, uint K>
+bool Game<Rows, Cols, K>::is_win_at(const char player, const uint cell, const Board &board) {
+    TRACE_SCOPE(TRACE_IS_WIN);
+    Mask mask = get_player_mask(player, board);
+    // Only the lines through the cell can have been completed by the move
+    // Their masks are grouped per cell at compile time in Geometry::CELL_LINES
+    const Mask *lines = Geometry::CELL_LINES[cell].data();
+    for (uint i = 0; i < Geometry::CELL_LINE_COUNT[cell]; i++) {
+        // Check if the player owns every cell of the winning line
+        if ((mask & lines[i]) == lines[i]) {
+            // Player wins!
+            return true;
         }
     }
+
+    // Player has not won
+    return false;
+}
+
+template <uint Rows, uint Cols, uint K>
+bool Game<Rows, Cols, K>::is_tie(const Board &board) {
     // Return tie if all cells are filled
-    return true;
-}
\ No newline at end of file
+    return (board.x | board.o) == Geometry::FULL_BOARD;
+}
+
+template <uint Rows, uint Cols, uint K>
+bool Game<Rows, Cols, K>::is_tie(const char (*board)[COLS]) {
+    return is_tie(to_bitboard(board));
+}
+
+// Board variants built into the firmware
+template class Game<3, 3, 3>;
+template class Game<4, 4, 4>;
+template class Game<5, 5, 4>;
+template class Game<7, 7, 5>;
@@ -1,6 +1,12 @@
 #ifndef __GAME_HPP__                                      
 #define __GAME_HPP__
 
+#include "ai.hpp"
+#include "bitboard.hpp"
+#include "game_state.hpp"
+#include "move_log.hpp"
+#include "renderer.hpp"
+#include "stats_store.hpp"
 #include "pico/multicore.h"
 #include "pico/stdlib.h"
 #include "pico/time.h"
@@ -14,23 +20,17 @@ typedef struct {
     // bool pull_down_enabled; 
 } GpioConfig;
 
-// Struct for storing button state info
-// @field but_pin The number of the button pin
-typedef struct {
-    uint but_pin;
-    bool prev_state;
-    bool curr_state;
-} BtnState;
-
-class Game {
+// Board-independent part of the game: symbols, pins, buttons and LEDs
+class GameBase {
     public: 
-        static const int ROWS = 3;
-        static const int COLS = 3;
         static const char EMPTY = ' ';
         static const char X = 'X';                 // Player 1 symbol
         static const char O = 'O';                 // Player 2 symbol
         static const int DEBOUNCE_DELAY = 30;     // Debounce delay
         static const int BLINK_LED_DELAY = 500;    // Blink LED delay
+        static const uint16_t HEARTBEAT_PERIOD = 2 * BLINK_LED_DELAY;  // Onboard LED blink while playing
+        static const uint16_t CHASE_STEP = 100;    // Step of the winning chase
+        static const uint16_t CHASE_CYCLES = 5;    // Rounds of the chase before the winner blinks
         static const int HIGH = 1;
         static const int LOW = 0;
         
@@ -42,40 +42,102 @@ class Game {
         static const uint BTN2 = 14; // Confirm Selection Button
         static const uint BTN3 = 12; // Reset Button
         static const size_t NUMBER_OF_GPIOS = 6;
+        static const uint NUMBER_OF_LEDS = 3;
 
         // Constructor
-        Game();                                         
+        // @param rows Number of board rows
+        // @param cols Number of board columns
+        GameBase(const uint rows, const uint cols);                                         
 
-        // Initializes the GPIOs
+        // Initializes the GPIOs, and the LEDs' PWM outputs
         // @param gpio Pointer to the GpioConfig struct
         // @param NUMBER_OF_GPIOS It's the length of the GpioConfig struct
         // void init_gpio(GpioConfig *gpio, size_t len);
         void init_gpio(GpioConfig (&gpio)[NUMBER_OF_GPIOS]);
 
-        // Debounce function to ensure the button state is stable
-        // @param btn Pointer to the BtnState structure
-        // @return true If button state is stable
-        // @return false If button state is not stable
-        bool debounce(const volatile BtnState &btn);
+        // Print the current position on the board by moving the highlight
+        // Like the other print_* texts, it is drawn by the next frame
+        // @param row Current row
+        // @param col Current column
+        void print_curr_pos(const uint row, const uint col);
+
+        // Print the current player's turn in the status line
+        void print_player_turn(const char current_player);
+
+        // Print the move just made in the message line
+        void show_move(const char current_player, const uint row, const uint col);
+
+        // Shows the text in the message line straight away
+        void show_message(const char *text);
+
+        // Repaints the whole screen, e.g. after other output
+        void redraw();
+
+        // Returns the number of the game in progress, as in its record
+        uint16_t get_game_number();
+
+        // Returns the renderer's bytes-per-frame and time-per-frame statistics
+        const RenderStats &get_render_stats();
+
+        // Sets where the board frames are written, nullptr for stdout
+        void set_render_sink(Renderer::Sink sink);
+
+        // Sets where the records of complete games are sent, nullptr for stdout
+        void set_record_sink(GameRecords::Sink sink);
 
-        // Returns true if button state is stable else returns false if not stable
-        // @param button Index of button
-        // @param prev_state Previous state of the button
-        bool is_stable(const uint button, const bool prev_state);
+        // Update the LED indicating the current player, on player changes only
+        void update_player_led(const char current_player);
+
+        // Chase over the LEDs, then keep flashing the winner's LED
+        void show_winner(const char winner);
+
+        // Shows the wins, losses and draws kept in flash in the message line
+        void show_stats(const GameStats &stats);
+
+        // Returns new player's character
+        char get_new_player(char current_player);
+
+    protected:
+        // Terminal frame of the board, cursor and text lines
+        Renderer renderer;
+        uint board_cols;
 
-        // Returns whether button state has changed or not
-        bool has_changed(bool prev_state, bool curr_state);
+        // Where the game records go, the number of the game in progress,
+        // and whether its record was already sent
+        GameRecords::Sink record_sink;
+        uint16_t game_number;
+        bool is_recorded;
+};
+
+// Rows x Cols game in which K marks in a row, column or diagonal win
+// Supported variants are explicitly instantiated in game.cpp:
+// 3x3 (K = 3), 4x4 (K = 4), 5x5 (K = 4) and 7x7 (K = 5)
+template <uint Rows, uint Cols, uint K>
+class Game : public GameBase {
+    public: 
+        static const int ROWS = Rows;
+        static const int COLS = Cols;
+        static const int WIN_LENGTH = K;
+        static const uint CELLS = Rows * Cols;
 
-        // Updates the button state
-        // @param btn Pointer to the BtnState struct
-        void update_btn_state(volatile BtnState *btn);
+        typedef BoardGeometry<Rows, Cols, K> Geometry;
+        typedef BasicBitboard<Rows * Cols> Board;
+        typedef typename Board::Mask Mask;
+        typedef Engine<Rows, Cols, K> AiEngine;
+        typedef BasicGameState<Rows * Cols> State;
 
-        // Resets the board and updates the current player, moves and is_game_over variables
-        // @param current_player Pointer to the current player
-        // @param moves Pointer to the number of moves
-        // @param board Pointer to the tic-tac-toe board
-        // @param is_game_over Pointer to the flag indicating whether the game is over or not
-        void reset_board(char *current_player, uint *moves, char (*board)[COLS], bool *is_game_over);
+        // Constructor
+        Game();
+
+        // Feeds an event to the game's state machine (see GameMachine)
+        // The event's transition in the state's phase sets the next phase and
+        // names the action, whose follow-up event (e.g. the engine's turn
+        // after a move, then its win) goes through the table in turn. The
+        // frame is drawn once, after the last one
+        // @param state The game, a zero-initialized state is IDLE and is set
+        //        up by a GAME_EVENT_RESET_CONFIRMED
+        // @param event What the player or remote client did
+        void dispatch(State *state, const GameEvent event);
 
         // Returns the current row based on the number of moves
         // @returns Current row
@@ -91,53 +153,155 @@ class Game {
         // Returns current column based on number of moves
         uint get_curr_col(const uint moves);
 
-        // Update the current position by incrementing the number of moves made
-        void update_position(uint *moves);
+        // Moves the cursor to the next empty cell in reading order, or the
+        // previous one in reverse, wrapping around; occupied cells are skipped
+        // @param moves Cell of the cursor
+        // @param board The current state of the board
+        // @param is_reverse Step backwards
+        void update_position(uint *moves, const Board &board, const bool is_reverse);
 
-        // Print the current position on the board 
-        // @param row Current row
-        // @param col Current column
-        void print_curr_pos(const uint row, const uint col);
+        // Returns the next empty cell after (or before, in reverse) the
+        // given one, wrapping around, or the cell itself if the board is full
+        // Found with one bit scan of the free cells' mask, O(1)
+        uint find_empty_cell(const uint cell, const Board &board, const bool is_reverse);
 
         // Checks if the position on the board is valid
         bool is_valid_pos(const uint row, const uint col);
 
         // Check if a position on the board is empty
+        bool is_empty_pos(uint const row, uint col, const Board &board);
         bool is_empty_pos(uint const row, uint col, const char (*board)[COLS]);
 
         // Update the board with the current player's move
         // @param moves Number of moves made
+        void update_board(const char current_player, const uint moves, Board *board);
         void update_board(const char current_player, const uint moves, char (*board)[COLS]);
 
-        // Print the board
+        // Print the board: redraws the changed parts of the frame in one write
+        void print_board(const Board &board);
         void print_board(const char (*board)[COLS]);
 
-        // Print the current player's turn
-        void print_player_turn(const char current_player);
-
-        // Update the LED indicating the current player
-        void update_player_led(const char current_player);
-
-        // Handle btn1 press
-        // @param moves The number of moves made
-        void handle_btn1(uint *moves);
+        // Returns the occupancy mask of the given player
+        // @param player The player's character (X or O)
+        // @param board The current state of the board
+        Mask get_player_mask(const char player, const Board &board);
 
-        // Handle btn2 press
-        void handle_btn2(char *current_player, uint *moves, char (*board)[COLS], bool *is_game_over);
+        // Returns the character (X, O or EMPTY) stored in the cell (row, col)
+        char get_cell(const uint row, const uint col, const Board &board);
 
-        // Returns new player's character
-        char get_new_player(char current_player);
+        // Converts a char board into a bitboard
+        // Used by the char board adapters below
+        Board to_bitboard(const char (*board)[COLS]);
 
         // Check if the given player has won the game, return true if player won else false
+        // Compares the player's mask against every precomputed winning line, O(R*C*K)
         // @param player The current player's character (X or O)
         // @param board The current state of the board
+        bool is_win(const char player, const Board &board);
         bool is_win(const char player, const char (*board)[COLS]);
 
-        // Check if the game is tied
+        // Check if the move the player just made at cell completes K in a row
+        // Only checks the lines through cell (at most 4 * K of them), O(K)
+        // @param player The character (X or O) of the player who moved
+        // @param cell The cell number (row * COLS + col) of the last move
+        // @param board The board with the last move already applied
+        bool is_win_at(const char player, const uint cell, const Board &board);
+
+        // Check if the game is tied, i.e. every cell is occupied
+        bool is_tie(const Board &board);
         bool is_tie(const char (*board)[COLS]);
 
-        // Flash the LED indicating the winner
-        static void flash_winner_led();
+        // Enables single-player mode, in which handle_btn2 hands the turn to
+        // the engine after every human move
+        // @param engine Pointer to a statically allocated engine, nullptr for two players
+        // @param ai_player The engine's character (X or O)
+        void set_engine(AiEngine *engine, const char ai_player);
+
+        // Core 1 entry: answers the Channel requests of core 0, helps the
+        // engine's searches and otherwise sleeps, the LEDs don't need it
+        static void run_worker();
+
+    private:
+        // Action of the state machine, returning its follow-up event or
+        // GAME_EVENT_NONE; the phase is already the transition's
+        typedef GameEvent (Game::*Action)(State *state);
+
+        // Actions indexed by GameAction
+        static const Action ACTIONS[NUMBER_OF_GAME_ACTIONS];
+
+        // Boards with at most this many lines check a move by scanning them
+        // all (is_win), larger ones only the lines through it (is_win_at)
+        static const uint FULL_SCAN_WIN_MASKS = 16;
+
+        AiEngine *engine = nullptr;
+        char ai_player = EMPTY;
+
+        // Engine last enabled by set_engine, whose searches core 1 helps
+        static AiEngine *shared_engine;
+
+        // Moves of the recent games, 4 bits each on the 3x3 board
+        MoveLog<Rows * Cols> history;
+
+        // Sends the record of the game in progress, ended with result
+        void send_record(const GameResult result);
+
+        // Resets the board, cursor and player for a new game
+        // @return GAME_EVENT_ENGINE_TURN if the engine opens the game
+        GameEvent reset_board(State *state);
+
+        // Handle btn1 press: a tap steps the cursor forward, a long press and
+        // its auto-repeats step it back
+        // @param is_reverse Step backwards
+        GameEvent handle_btn1(State *state, const bool is_reverse);
+
+        // Handle btn2 press: places the mark at the cursor if the cell is free
+        // @return The move's outcome, or GAME_EVENT_ENGINE_TURN in
+        //         single-player mode
+        GameEvent handle_btn2(State *state);
+
+        // Handle the undo gesture: takes back the last move of the game in
+        // progress, in single-player mode back to the human's last move
+        GameEvent handle_undo(State *state);
+
+        // Lets the engine play its move: a lookup in the compile-time solved
+        // table on the classic 3x3 board, or in the solved database on 4x4
+        // if one is attached, otherwise a search within AI_BUDGET_US which
+        // core 1 helps with
+        // @return The move's outcome, GAME_EVENT_MOVED if the game goes on
+        GameEvent handle_ai_turn(State *state);
+
+        // The other actions of the transition table
+        GameEvent ignore_event(State *state);
+        GameEvent move_cursor_next(State *state);
+        GameEvent move_cursor_back(State *state);
+        GameEvent celebrate_win(State *state);
+        GameEvent record_tie(State *state);
+        GameEvent restart_after_tie(State *state);
+        GameEvent ask_reset_confirmation(State *state);
+        GameEvent show_game_over(State *state);
+
+        // Places the player to move's mark at the cursor, then checks for a
+        // win or tie, or passes the turn to the other player
+        // @return GAME_EVENT_WON, GAME_EVENT_TIED or GAME_EVENT_NONE
+        GameEvent place_move(State *state);
+
+        // Follow-up of an action that placed nothing: an empty board takes
+        // the game back to IDLE
+        static GameEvent get_unchanged_event(const State &state);
 };
 
+// Board variant built into the firmware, selected by the BOARD_ROWS,
+// BOARD_COLS and WIN_LENGTH CMake cache variables
+#ifndef BOARD_ROWS
+#define BOARD_ROWS 3
+#endif
+#ifndef BOARD_COLS
+#define BOARD_COLS 3
+#endif
+#ifndef BOARD_WIN_LENGTH
+#define BOARD_WIN_LENGTH 3
+#endif
+
+typedef Game<BOARD_ROWS, BOARD_COLS, BOARD_WIN_LENGTH> TicTacToe;
+
 #endif  // __GAME_HPP__
\ No newline at end of file
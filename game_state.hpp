@@ -0,0 +1,173 @@
+#ifndef __GAME_STATE_HPP__
+#define __GAME_STATE_HPP__
+
+#include "bitboard.hpp"
+#include "gesture.hpp"
+#include "pico/stdlib.h"
+#include <stdint.h>
+#include <type_traits>
+
+// Phases of a game
+enum GamePhase : uint8_t {
+    GAME_PHASE_IDLE = 0,    // Empty board, a single reset press starts over
+    GAME_PHASE_PLAYING,     // Marks on the board, the game is in progress
+    GAME_PHASE_AI_THINKING, // The engine is choosing its move
+    GAME_PHASE_WON,         // A line is complete, only a reset starts over
+    GAME_PHASE_TIE,         // The board is full, it resets straight away
+    NUMBER_OF_GAME_PHASES
+};
+
+// Events fed to the state machine
+// The inputs come from the buttons and remote clients; the follow-ups are
+// returned by the actions and fed back in the same dispatch
+enum GameEvent : uint8_t {
+    GAME_EVENT_CURSOR_NEXT = 0,     // btn1 tap, on its release
+    GAME_EVENT_CURSOR_BACK,         // btn1 long press and repeats
+    GAME_EVENT_PLACE,               // btn2, a mark at the cursor
+    GAME_EVENT_RESET,               // btn3 press
+    GAME_EVENT_RESET_CONFIRMED,     // btn3 double click, or a remote reset
+    GAME_EVENT_UNDO,                // btn3 while btn1 is held
+    GAME_EVENT_ENGINE_TURN,         // Follow-up: the engine is to move
+    GAME_EVENT_MOVED,               // Follow-up: the engine moved, the game goes on
+    GAME_EVENT_WON,                 // Follow-up: the move completed a line
+    GAME_EVENT_TIED,                // Follow-up: the move filled the board
+    GAME_EVENT_EMPTIED,             // Follow-up: the board has no marks left
+    NUMBER_OF_GAME_EVENTS,
+    GAME_EVENT_NONE = NUMBER_OF_GAME_EVENTS
+};
+
+// What the game does on a transition, an index into Game's action table
+enum GameAction : uint8_t {
+    GAME_ACTION_NONE = 0,           // Ignore the event
+    GAME_ACTION_CURSOR_NEXT,        // Game::handle_btn1 forward
+    GAME_ACTION_CURSOR_BACK,        // Game::handle_btn1 in reverse
+    GAME_ACTION_PLACE,              // Game::handle_btn2
+    GAME_ACTION_ENGINE_MOVE,        // Game::handle_ai_turn
+    GAME_ACTION_WIN,                // Record the win and celebrate
+    GAME_ACTION_TIE,                // Record the tie
+    GAME_ACTION_RESET,              // Game::reset_board
+    GAME_ACTION_RESTART,            // Game::reset_board after a tie
+    GAME_ACTION_ASK_CONFIRMATION,   // Ask for a double click to reset
+    GAME_ACTION_UNDO,               // Game::handle_undo
+    GAME_ACTION_GAME_OVER,          // Tell that only a reset starts over
+    NUMBER_OF_GAME_ACTIONS
+};
+
+// Struct for storing one entry of the transition table (2 bytes)
+// @field action What the game does, with the new phase already set
+// @field next Phase entered
+typedef struct {
+    GameAction action;
+    GamePhase next;
+} GameTransition;
+
+// Struct for storing the whole state of a game in progress, the board,
+// cursor, player to move and phase, so that it can be copied and compared
+// as a value: 8 bytes on the 3x3 and 4x4 boards, 24 on 7x7
+// @field board Both players' masks
+// @field cursor Cell of the cursor
+// @field player Character (X or O) of the player to move, or of the winner
+// @field phase Where the game is, the column of the transition table
+template <unsigned int Cells>
+struct BasicGameState {
+    BasicBitboard<Cells> board;
+    uint8_t cursor;
+    char player;
+    GamePhase phase;
+};
+
+static_assert(std::is_trivially_copyable<BasicGameState<49>>::value,
+              "Game states are copied with plain assignments");
+
+// Transition table of the game, event by phase
+// Every event is one indexed load in TRANSITIONS, then one indexed call of
+// the action in Game::dispatch, in place of the branches on is_game_over
+// and the board that main() and the button handlers made before. The
+// table is built at compile time into flash, 110 bytes
+class GameMachine {
+    public:
+        // Returns the transition of the event in the phase
+        static constexpr GameTransition get_transition(const GameEvent event,
+                                                       const GamePhase phase) {
+            return TRANSITIONS[event][phase];
+        }
+
+        // Returns the event of a button gesture, GAME_EVENT_NONE if it has none
+        // btn1: a tap steps the cursor to the next empty cell on its
+        // release, holding it only steps back, with auto-repeat. btn2: places the mark. btn3: resets
+        // on a press (with CONFIRM_RESET, mid-game only on a double click). Chords act
+        // like a press, except btn3 while btn1 is held: undo
+        static constexpr GameEvent get_gesture_event(const Gesture &gesture) {
+            return (gesture.type == GESTURE_CHORD && gesture.button == 2 && gesture.modifier == 0)
+                   ? GAME_EVENT_UNDO : GESTURE_EVENTS[gesture.button][gesture.type];
+        }
+
+    private:
+        static constexpr GameTransition IGNORE_IDLE = {GAME_ACTION_NONE, GAME_PHASE_IDLE};
+        static constexpr GameTransition IGNORE_PLAYING = {GAME_ACTION_NONE, GAME_PHASE_PLAYING};
+        static constexpr GameTransition IGNORE_AI = {GAME_ACTION_NONE, GAME_PHASE_AI_THINKING};
+        static constexpr GameTransition IGNORE_WON = {GAME_ACTION_NONE, GAME_PHASE_WON};
+        static constexpr GameTransition IGNORE_TIE = {GAME_ACTION_NONE, GAME_PHASE_TIE};
+        static constexpr GameTransition RESET = {GAME_ACTION_RESET, GAME_PHASE_IDLE};
+
+        // Columns: PRESS, DOUBLE_CLICK, LONG_PRESS, REPEAT, TAP, CHORD
+        static constexpr GameEvent GESTURE_EVENTS[Input::NUMBER_OF_BUTTONS][GESTURE_CHORD + 1] = {
+            {GAME_EVENT_NONE, GAME_EVENT_NONE, GAME_EVENT_CURSOR_BACK, GAME_EVENT_CURSOR_BACK,
+             GAME_EVENT_CURSOR_NEXT, GAME_EVENT_CURSOR_NEXT},
+            {GAME_EVENT_PLACE, GAME_EVENT_PLACE, GAME_EVENT_NONE, GAME_EVENT_NONE, GAME_EVENT_NONE,
+             GAME_EVENT_PLACE},
+#ifdef CONFIRM_RESET
+            {GAME_EVENT_RESET, GAME_EVENT_RESET_CONFIRMED, GAME_EVENT_NONE, GAME_EVENT_NONE,
+             GAME_EVENT_NONE, GAME_EVENT_RESET},
+#else
+            // The double click's first press has reset the board already, a
+            // second reset would count another game and abandon the opening
+            // move of an engine playing X
+            {GAME_EVENT_RESET, GAME_EVENT_NONE, GAME_EVENT_NONE, GAME_EVENT_NONE,
+             GAME_EVENT_NONE, GAME_EVENT_RESET},
+#endif
+        };
+
+        // Columns: IDLE, PLAYING, AI_THINKING, WON, TIE
+        static constexpr GameTransition
+            TRANSITIONS[NUMBER_OF_GAME_EVENTS][NUMBER_OF_GAME_PHASES] = {
+            // CURSOR_NEXT
+            {{GAME_ACTION_CURSOR_NEXT, GAME_PHASE_IDLE},
+             {GAME_ACTION_CURSOR_NEXT, GAME_PHASE_PLAYING}, IGNORE_AI, IGNORE_WON, IGNORE_TIE},
+            // CURSOR_BACK
+            {{GAME_ACTION_CURSOR_BACK, GAME_PHASE_IDLE},
+             {GAME_ACTION_CURSOR_BACK, GAME_PHASE_PLAYING}, IGNORE_AI, IGNORE_WON, IGNORE_TIE},
+            // PLACE
+            {{GAME_ACTION_PLACE, GAME_PHASE_PLAYING},
+             {GAME_ACTION_PLACE, GAME_PHASE_PLAYING}, IGNORE_AI, IGNORE_WON, IGNORE_TIE},
+#ifdef CONFIRM_RESET
+            // RESET: a game in progress asks for a double click
+            {RESET, {GAME_ACTION_ASK_CONFIRMATION, GAME_PHASE_PLAYING}, IGNORE_AI, RESET,
+             {GAME_ACTION_RESTART, GAME_PHASE_IDLE}},
+#else
+            // RESET
+            {RESET, RESET, IGNORE_AI, RESET, {GAME_ACTION_RESTART, GAME_PHASE_IDLE}},
+#endif
+            // RESET_CONFIRMED
+            {RESET, RESET, RESET, RESET, {GAME_ACTION_RESTART, GAME_PHASE_IDLE}},
+            // UNDO
+            {{GAME_ACTION_UNDO, GAME_PHASE_IDLE}, {GAME_ACTION_UNDO, GAME_PHASE_PLAYING},
+             IGNORE_AI, {GAME_ACTION_GAME_OVER, GAME_PHASE_WON}, IGNORE_TIE},
+            // ENGINE_TURN
+            {{GAME_ACTION_ENGINE_MOVE, GAME_PHASE_AI_THINKING},
+             {GAME_ACTION_ENGINE_MOVE, GAME_PHASE_AI_THINKING}, IGNORE_AI, IGNORE_WON,
+             IGNORE_TIE},
+            // MOVED
+            {IGNORE_IDLE, IGNORE_PLAYING, IGNORE_PLAYING, IGNORE_WON, IGNORE_TIE},
+            // WON
+            {IGNORE_IDLE, {GAME_ACTION_WIN, GAME_PHASE_WON}, {GAME_ACTION_WIN, GAME_PHASE_WON},
+             IGNORE_WON, IGNORE_TIE},
+            // TIED: the tie action asks for the reset
+            {IGNORE_IDLE, {GAME_ACTION_TIE, GAME_PHASE_TIE}, {GAME_ACTION_TIE, GAME_PHASE_TIE},
+             IGNORE_WON, IGNORE_TIE},
+            // EMPTIED
+            {IGNORE_IDLE, IGNORE_IDLE, IGNORE_AI, IGNORE_WON, IGNORE_TIE},
+        };
+};
+
+#endif  // __GAME_STATE_HPP__
@@ -0,0 +1,82 @@
+#include "gesture.hpp"
+
+Gestures::Timing Gestures::buttons[Input::NUMBER_OF_BUTTONS];
+
+bool Gestures::feed(const BtnEvent &event, Gesture *gesture) {
+    Timing &button = buttons[event.button];
+
+    gesture->button = event.button;
+    gesture->modifier = event.button;
+    gesture->edge_us = event.edge_us;
+
+    if (!event.is_pressed) {
+        // Released before the long press: a tap. A chord or a long press
+        // already made its gesture
+        bool is_tap = (button.state == BUTTON_DOWN);
+        button.state = BUTTON_UP;
+        gesture->type = GESTURE_TAP;
+        return is_tap;
+    }
+
+    // A button still held turns this press into a chord, and neither
+    // repeats nor long-presses until both are released
+    for (uint8_t i = 0; i < Input::NUMBER_OF_BUTTONS; i++) {
+        if (i != event.button && buttons[i].state != BUTTON_UP) {
+            buttons[i].state = BUTTON_MODIFIER;
+            button.state = BUTTON_MODIFIER;
+            button.pressed_us = 0;
+            gesture->type = GESTURE_CHORD;
+            gesture->modifier = i;
+            return true;
+        }
+    }
+
+    // The first press after a double click starts over
+    bool is_double = button.pressed_us != 0 &&
+                     event.edge_us - button.pressed_us < 1000ull * DOUBLE_CLICK_MS;
+    gesture->type = is_double ? GESTURE_DOUBLE_CLICK : GESTURE_PRESS;
+    button.pressed_us = is_double ? 0 : event.edge_us;
+    button.state = BUTTON_DOWN;
+    button.due_us = event.edge_us + 1000ull * LONG_PRESS_MS;
+    return true;
+}
+
+bool Gestures::poll(Gesture *gesture) {
+    uint64_t now = time_us_64();
+
+    for (uint8_t i = 0; i < Input::NUMBER_OF_BUTTONS; i++) {
+        Timing &button = buttons[i];
+        if ((button.state != BUTTON_DOWN && button.state != BUTTON_REPEATING) ||
+            now < button.due_us) {
+            continue;
+        }
+
+        gesture->button = i;
+        gesture->modifier = i;
+        gesture->edge_us = button.due_us;
+        gesture->type = (button.state == BUTTON_DOWN) ? GESTURE_LONG_PRESS : GESTURE_REPEAT;
+
+        // A held button is never a double click, and a late loop doesn't
+        // make up for missed repeats
+        button.state = BUTTON_REPEATING;
+        button.pressed_us = 0;
+        button.due_us += 1000ull * REPEAT_MS;
+        if (button.due_us <= now) {
+            button.due_us = now + 1000ull * REPEAT_MS;
+        }
+        return true;
+    }
+    return false;
+}
+
+absolute_time_t Gestures::next_deadline(const absolute_time_t deadline) {
+    absolute_time_t next = deadline;
+    for (uint i = 0; i < Input::NUMBER_OF_BUTTONS; i++) {
+        const Timing &button = buttons[i];
+        if ((button.state == BUTTON_DOWN || button.state == BUTTON_REPEATING) &&
+            absolute_time_diff_us(from_us_since_boot(button.due_us), next) > 0) {
+            next = from_us_since_boot(button.due_us);
+        }
+    }
+    return next;
+}
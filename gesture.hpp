@@ -0,0 +1,84 @@
+#ifndef __GESTURE_HPP__
+#define __GESTURE_HPP__
+
+#include "input.hpp"
+#include "pico/stdlib.h"
+#include "pico/time.h"
+#include <stdint.h>
+
+// Kinds of gestures made from the debounced button events
+enum GestureType : uint8_t {
+    GESTURE_PRESS = 0,      // A press, reported straight away
+    GESTURE_DOUBLE_CLICK,   // A press soon after the button's previous press
+    GESTURE_LONG_PRESS,     // The button has been held for LONG_PRESS_MS
+    GESTURE_REPEAT,         // Every REPEAT_MS while it stays held after that
+    GESTURE_TAP,            // A release before the long press
+    GESTURE_CHORD,          // A press while another button is held
+};
+
+// Struct for storing one gesture
+// @field button Index of the button, as in BtnEvent
+// @field type What the button did
+// @field modifier Index of the button held down, for GESTURE_CHORD
+// @field edge_us Time of the press or release, or the time a timed gesture
+//        was due
+typedef struct {
+    uint8_t button;
+    GestureType type;
+    uint8_t modifier;
+    uint64_t edge_us;
+} Gesture;
+
+// Per-button timing state machine turning Input's debounced events into
+// gestures, without blocking
+// A press is reported on its event, so a tap costs no extra latency; a
+// second press within DOUBLE_CLICK_MS is reported as a double click
+// instead. Holding the button reports a long press, then repeats until it
+// is released. A release before the long press is also reported, as a
+// tap, for a button whose press and long press must exclude each other.
+// A press while another button is held is a chord, and the held button
+// stays silent until it is released. The main loop feeds the
+// events, polls for the timed gestures and sleeps until the next deadline
+class Gestures {
+    public:
+        static const uint32_t LONG_PRESS_MS = 400;
+        static const uint32_t REPEAT_MS = 150;
+        static const uint32_t DOUBLE_CLICK_MS = 300;
+
+        // Advances the button's state machine with a debounced event
+        // @param event The event, from Input::pop_event
+        // @param gesture Set to the gesture the event makes, if any
+        // @return true if gesture was set
+        static bool feed(const BtnEvent &event, Gesture *gesture);
+
+        // Takes the next due long press or repeat
+        // @param gesture Set to the due gesture
+        // @return false if none is due
+        static bool poll(Gesture *gesture);
+
+        // Returns the earlier of deadline and the next timed gesture
+        static absolute_time_t next_deadline(const absolute_time_t deadline);
+
+    private:
+        // States of one button
+        enum ButtonState : uint8_t {
+            BUTTON_UP = 0,
+            BUTTON_DOWN,        // Pressed, waiting for the long press
+            BUTTON_REPEATING,   // Held past the long press
+            BUTTON_MODIFIER,    // Part of a chord, silent until released
+        };
+
+        // Struct for storing the timing state of one button
+        // @field state ButtonState
+        // @field due_us Time of the next long press or repeat
+        // @field pressed_us Time of the last press, for double clicks
+        typedef struct {
+            uint8_t state;
+            uint64_t due_us;
+            uint64_t pressed_us;
+        } Timing;
+
+        static Timing buttons[Input::NUMBER_OF_BUTTONS];
+};
+
+#endif  // __GESTURE_HPP__
@@ -0,0 +1,253 @@
+#include "sim.hpp"
+#include "game.hpp"
+#include "remote.hpp"
+#include "solved4.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Firmware entry point, main() of main.cpp renamed by the host build
+int firmware_main();
+
+namespace {
+
+// Button press length and pause after the release of a tap
+const uint64_t TAP_PRESS_US = 100000;
+const uint64_t TAP_PAUSE_US = 150000;
+
+// Time between two bounces of the contacts
+const uint64_t BOUNCE_US = 200;
+
+// Struct for storing the state of the script reader
+// @field at_us Time of the next command
+// @field bounces Number of extra edges before the next press or release settles
+// @field sequence Sequence number of the next remote request
+typedef struct {
+    uint64_t at_us;
+    uint bounces;
+    uint8_t sequence;
+} Cursor;
+
+void usage() {
+    std::cerr << "Usage: tictactoe_host [--quiet] [--clock-step-ns N] [--flash FILE]\n"
+                 "                      [--database FILE] [script]\n"
+                 "\n"
+                 "Runs the firmware against simulated buttons, LEDs and cores. The script\n"
+                 "schedules the button edges, one command per line ('#' starts a comment):\n"
+                 "  wait <ms>               let time pass\n"
+                 "  press|release <button>  drive a button (btn1, btn2, btn3 or a GPIO)\n"
+                 "  tap <button>            press for 100 ms, release and wait 150 ms\n"
+                 "  bounce <n>              make the next edge bounce n times, 200 us apart\n"
+                 "  type <text>             send the text over USB serial, e.g. 't' for a\n"
+                 "                          trace dump in a TICTACTOE_TRACE build\n"
+                 "  remote <cmd> [n ...]    send a remote play request: place <cell ...>,\n"
+                 "                          reset, state, mode <0-2> or bench <iterations>\n"
+                 "  repeat <n> ... end      run the enclosed commands n times\n"
+                 "Buttons held by the first commands are held at power-up. The run\n"
+                 "ends once the script's time has passed. --flash keeps the flash (and\n"
+                 "with it the game statistics) in FILE between runs. --database maps\n"
+                 "the database of tictactoe_solve4, from which the engine plays on the\n"
+                 "4x4 board.\n";
+}
+
+// Returns the GPIO of a button name or number, -1 if unknown
+int parse_button(const std::string &name) {
+    if (name == "btn1") {
+        return TicTacToe::BTN1;
+    }
+    if (name == "btn2") {
+        return TicTacToe::BTN2;
+    }
+    if (name == "btn3") {
+        return TicTacToe::BTN3;
+    }
+    char *end = nullptr;
+    long gpio = strtol(name.c_str(), &end, 10);
+    return (*end == '\0' && gpio >= 0 && gpio < NUM_BANK0_GPIOS) ? static_cast<int>(gpio) : -1;
+}
+
+// Schedules a button edge, bouncing if asked to
+void drive(Cursor *cursor, const uint pin, const bool is_pressed) {
+    // Active-low buttons: pressed reads LOW
+    bool level = !is_pressed;
+    for (uint i = 0; i < cursor->bounces; i++) {
+        Sim::drive_at(cursor->at_us + 2 * i * BOUNCE_US, pin, level);
+        Sim::drive_at(cursor->at_us + (2 * i + 1) * BOUNCE_US, pin, !level);
+    }
+    Sim::drive_at(cursor->at_us + 2 * cursor->bounces * BOUNCE_US, pin, level);
+    cursor->bounces = 0;
+}
+
+// Schedules a remote play request made of the words, e.g. "place 4 0"
+// @return false if the command is unknown
+bool send_request(std::istringstream *words, const std::string &name, Cursor *cursor) {
+    RemoteRequest request = {};
+    request.sequence = cursor->sequence++;
+    request.command = static_cast<uint8_t>(Remote::parse_command(name.c_str()));
+    if (request.command == 0) {
+        return false;
+    }
+    long value = 0;
+    while (*words >> value && request.length + 2u <= sizeof(request.arguments)) {
+        request.arguments[request.length++] = static_cast<uint8_t>(value);
+        // The benchmark's iterations take 16 bits
+        if (request.command == REMOTE_RUN_BENCHMARK) {
+            request.arguments[request.length++] = static_cast<uint8_t>(value >> 8);
+        }
+    }
+    uint8_t data[Remote::MAX_REQUEST_SIZE];
+    Sim::send_at(cursor->at_us, data, Remote::encode_request(request, data));
+    return true;
+}
+
+// Schedules the commands in lines[first, last)
+// @return false on a syntax error
+bool run_script(const std::vector<std::string> &lines, size_t first, size_t last,
+                Cursor *cursor) {
+    for (size_t i = first; i < last; i++) {
+        std::istringstream words(lines[i]);
+        std::string command;
+        std::string argument;
+        if (!(words >> command)) {
+            continue;
+        }
+        words >> argument;
+
+        if (command == "wait") {
+            cursor->at_us += static_cast<uint64_t>(atof(argument.c_str()) * 1000);
+        } else if (command == "press" || command == "release" || command == "tap") {
+            int pin = parse_button(argument);
+            if (pin < 0) {
+                std::cerr << "line " << i + 1 << ": unknown button '" << argument << "'\n";
+                return false;
+            }
+            if (command == "tap") {
+                drive(cursor, pin, true);
+                cursor->at_us += TAP_PRESS_US;
+                drive(cursor, pin, false);
+                cursor->at_us += TAP_PAUSE_US;
+            } else {
+                drive(cursor, pin, command == "press");
+            }
+        } else if (command == "type") {
+            Sim::type_at(cursor->at_us, argument.c_str());
+        } else if (command == "remote") {
+            if (!send_request(&words, argument, cursor)) {
+                std::cerr << "line " << i + 1 << ": unknown remote command '" << argument << "'\n";
+                return false;
+            }
+        } else if (command == "bounce") {
+            cursor->bounces = static_cast<uint>(atoi(argument.c_str()));
+        } else if (command == "repeat") {
+            // Find the matching end
+            size_t end = i + 1;
+            for (int depth = 1; end < last; end++) {
+                std::istringstream inner(lines[end]);
+                std::string word;
+                inner >> word;
+                depth += (word == "repeat") ? 1 : (word == "end") ? -1 : 0;
+                if (depth == 0) {
+                    break;
+                }
+            }
+            if (end == last) {
+                std::cerr << "line " << i + 1 << ": repeat without end\n";
+                return false;
+            }
+            for (int n = atoi(argument.c_str()); n > 0; n--) {
+                if (!run_script(lines, i + 1, end, cursor)) {
+                    return false;
+                }
+            }
+            i = end;
+        } else {
+            std::cerr << "line " << i + 1 << ": unknown command '" << command << "'\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+// Prints what the run did to stderr, so it doesn't mix with the game's output
+void report() {
+    SimStats stats = Sim::get_stats();
+    fprintf(stderr, "sim: %.3f ms simulated in %llu us wall time\n", stats.virtual_us / 1000.0,
+            static_cast<unsigned long long>(stats.wall_us));
+    fprintf(stderr, "sim: %llu sleeps, %llu alarms, %llu input edges, %llu GPIO IRQs, %llu doorbells\n",
+            static_cast<unsigned long long>(stats.sleeps),
+            static_cast<unsigned long long>(stats.alarms),
+            static_cast<unsigned long long>(stats.edges),
+            static_cast<unsigned long long>(stats.gpio_irqs),
+            static_cast<unsigned long long>(stats.sio_irqs));
+    fprintf(stderr, "sim: flash %llu sector erases, %llu page programs\n",
+            static_cast<unsigned long long>(stats.flash_erases),
+            static_cast<unsigned long long>(stats.flash_programs));
+    fprintf(stderr, "sim: LED levels LED1 %u, LED2 %u, onboard %u\n",
+            Sim::get_pwm_level(TicTacToe::LED1), Sim::get_pwm_level(TicTacToe::LED2),
+            Sim::get_pwm_level(TicTacToe::ONBOARD_LED));
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    const char *script_path = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--quiet") == 0) {
+            // Keep only the report
+            if (freopen("/dev/null", "w", stdout) == nullptr) {
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--clock-step-ns") == 0 && i + 1 < argc) {
+            Sim::set_clock_step_ns(static_cast<uint32_t>(atoi(argv[++i])));
+        } else if (strcmp(argv[i], "--flash") == 0 && i + 1 < argc) {
+            if (!Sim::set_flash_file(argv[++i])) {
+                std::cerr << "Cannot open " << argv[i] << "\n";
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--database") == 0 && i + 1 < argc) {
+            if (!Solved4::open(argv[++i])) {
+                std::cerr << "Cannot map " << argv[i] << " as a solved 4x4 database\n";
+                return 1;
+            }
+        } else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+            usage();
+            return 1;
+        } else {
+            script_path = argv[i];
+        }
+    }
+
+    std::vector<std::string> lines;
+    if (script_path != nullptr) {
+        std::ifstream file;
+        std::istream *input = &std::cin;
+        if (strcmp(script_path, "-") != 0) {
+            file.open(script_path);
+            if (!file) {
+                std::cerr << "Cannot open " << script_path << "\n";
+                return 1;
+            }
+            input = &file;
+        }
+        std::string line;
+        while (std::getline(*input, line)) {
+            lines.push_back(line.substr(0, line.find('#')));
+        }
+    }
+
+    Cursor cursor = {0, 0, 0};
+    if (!run_script(lines, 0, lines.size(), &cursor)) {
+        return 1;
+    }
+
+    Sim::set_end_time(cursor.at_us);
+    Sim::on_finish(report);
+    Sim::run(firmware_main);
+    return 0;
+}
@@ -0,0 +1,26 @@
+#ifndef __HOST_HARDWARE_FLASH_H__
+#define __HOST_HARDWARE_FLASH_H__
+
+// Host stand-in for the Pico SDK's flash programming API, see host/sim.cpp
+// The flash is an image in memory, optionally backed by a file so it
+// survives between runs (Sim::set_flash_file). Like NOR flash, erasing sets
+// a sector to all ones and programming can only clear bits
+
+#include "pico/types.h"
+
+#define FLASH_PAGE_SIZE (1u << 8)
+#define FLASH_SECTOR_SIZE (1u << 12)
+#define PICO_FLASH_SIZE_BYTES (2 * 1024 * 1024)
+
+// Returns the flash image, standing in for the XIP-mapped flash
+const uint8_t *host_flash_contents(void);
+
+#define XIP_BASE ((uintptr_t)host_flash_contents())
+
+// Erases count bytes (whole sectors) at the offset from the start of flash
+void flash_range_erase(uint32_t flash_offs, size_t count);
+
+// Programs count bytes (whole pages) at the offset from the start of flash
+void flash_range_program(uint32_t flash_offs, const uint8_t *data, size_t count);
+
+#endif  // __HOST_HARDWARE_FLASH_H__
@@ -0,0 +1,46 @@
+#ifndef __HOST_HARDWARE_GPIO_H__
+#define __HOST_HARDWARE_GPIO_H__
+
+// Host stand-in for the Pico SDK's GPIO API, see host/sim.cpp
+// Inputs are driven by the simulation script, outputs are recorded
+
+#include "pico/types.h"
+
+#define NUM_BANK0_GPIOS 30
+
+#define GPIO_OUT 1
+#define GPIO_IN 0
+
+enum gpio_function {
+    GPIO_FUNC_SIO = 5,
+    GPIO_FUNC_PWM = 4,
+    GPIO_FUNC_NULL = 0x1f,
+};
+
+enum gpio_irq_level {
+    GPIO_IRQ_LEVEL_LOW = 0x1u,
+    GPIO_IRQ_LEVEL_HIGH = 0x2u,
+    GPIO_IRQ_EDGE_FALL = 0x4u,
+    GPIO_IRQ_EDGE_RISE = 0x8u,
+};
+
+typedef void (*gpio_irq_callback_t)(uint gpio, uint32_t event_mask);
+
+void gpio_init(uint gpio);
+void gpio_set_dir(uint gpio, bool out);
+void gpio_set_function(uint gpio, enum gpio_function fn);
+void gpio_set_pulls(uint gpio, bool up, bool down);
+bool gpio_get(uint gpio);
+void gpio_put(uint gpio, bool value);
+void gpio_set_irq_enabled_with_callback(uint gpio, uint32_t event_mask, bool enabled,
+                                        gpio_irq_callback_t callback);
+
+static inline void gpio_pull_up(uint gpio) {
+    gpio_set_pulls(gpio, true, false);
+}
+
+static inline void gpio_pull_down(uint gpio) {
+    gpio_set_pulls(gpio, false, true);
+}
+
+#endif  // __HOST_HARDWARE_GPIO_H__
@@ -0,0 +1,17 @@
+#ifndef __HOST_HARDWARE_IRQ_H__
+#define __HOST_HARDWARE_IRQ_H__
+
+// Host stand-in for the Pico SDK's IRQ API, only the SIO FIFO interrupt of
+// core 0 is modelled
+
+#include "pico/types.h"
+
+#define SIO_IRQ_PROC0 15
+#define SIO_IRQ_PROC1 16
+
+typedef void (*irq_handler_t)(void);
+
+void irq_set_exclusive_handler(uint num, irq_handler_t handler);
+void irq_set_enabled(uint num, bool enabled);
+
+#endif  // __HOST_HARDWARE_IRQ_H__
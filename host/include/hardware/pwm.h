@@ -0,0 +1,30 @@
+#ifndef __HOST_HARDWARE_PWM_H__
+#define __HOST_HARDWARE_PWM_H__
+
+// Host stand-in for the Pico SDK's PWM API, the levels are recorded per pin
+
+#include "pico/types.h"
+
+typedef struct {
+    uint32_t csr;
+    uint32_t div;
+    uint32_t top;
+} pwm_config;
+
+static inline uint pwm_gpio_to_slice_num(uint gpio) {
+    return (gpio >> 1u) & 7u;
+}
+
+static inline pwm_config pwm_get_default_config(void) {
+    pwm_config config = {0, 1u << 4, 0xffff};
+    return config;
+}
+
+static inline void pwm_config_set_wrap(pwm_config *config, uint16_t wrap) {
+    config->top = wrap;
+}
+
+void pwm_init(uint slice_num, pwm_config *config, bool start);
+void pwm_set_gpio_level(uint gpio, uint16_t level);
+
+#endif  // __HOST_HARDWARE_PWM_H__
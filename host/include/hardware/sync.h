@@ -0,0 +1,23 @@
+#ifndef __HOST_HARDWARE_SYNC_H__
+#define __HOST_HARDWARE_SYNC_H__
+
+// Host stand-in for the Pico SDK's interrupt masking and event instructions
+// Interrupts (alarms, GPIO edges, the SIO doorbell) run on core 0's thread
+// when it sleeps or re-enables interrupts, never in the middle of its code
+
+#include "pico/types.h"
+
+uint32_t save_and_disable_interrupts(void);
+void restore_interrupts(uint32_t status);
+
+// Core 0 waits for an interrupt: time jumps to the next alarm or scripted
+// input once core 1 is idle, and the simulation ends when there is none
+void __wfi(void);
+
+// Waits for an event from the other core
+void __wfe(void);
+
+// Signals an event to the other core
+void __sev(void);
+
+#endif  // __HOST_HARDWARE_SYNC_H__
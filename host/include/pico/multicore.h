@@ -0,0 +1,19 @@
+#ifndef __HOST_PICO_MULTICORE_H__
+#define __HOST_PICO_MULTICORE_H__
+
+// Host stand-in for the Pico SDK's pico_multicore, see host/sim.cpp
+// Core 1 is a thread. The inter-core FIFOs hold 8 words each, and a push
+// signals an event to the other core as on the RP2040
+
+#include "pico/types.h"
+
+void multicore_launch_core1(void (*entry)(void));
+
+bool multicore_fifo_rvalid(void);
+bool multicore_fifo_wready(void);
+void multicore_fifo_push_blocking(uint32_t data);
+uint32_t multicore_fifo_pop_blocking(void);
+void multicore_fifo_drain(void);
+void multicore_fifo_clear_irq(void);
+
+#endif  // __HOST_PICO_MULTICORE_H__
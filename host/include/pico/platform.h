@@ -0,0 +1,18 @@
+#ifndef __HOST_PICO_PLATFORM_H__
+#define __HOST_PICO_PLATFORM_H__
+
+// Host stand-in for the Pico SDK's platform functions, see host/sim.cpp
+
+#include "pico/types.h"
+
+// Returns 0 on the thread running main(), 1 on the one launched as core 1
+uint get_core_num(void);
+
+// Body of a busy-wait loop, lets the other core's thread run
+void tight_loop_contents(void);
+
+// Code is never executed from flash on the host
+#define __not_in_flash(group)
+#define __not_in_flash_func(func_name) func_name
+
+#endif  // __HOST_PICO_PLATFORM_H__
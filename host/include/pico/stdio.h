@@ -0,0 +1,18 @@
+#ifndef __HOST_PICO_STDIO_H__
+#define __HOST_PICO_STDIO_H__
+
+// Host stand-in for the Pico SDK's stdio, which is the host's stdout here
+// Input comes from the script (Sim::type_at), not from the host's stdin
+
+#include "pico/types.h"
+#include <stdio.h>
+
+static inline bool stdio_init_all(void) {
+    return true;
+}
+
+// Returns the next character typed, or PICO_ERROR_TIMEOUT if there is none
+// The timeout is ignored, as time only moves while core 0 sleeps
+int getchar_timeout_us(uint32_t timeout_us);
+
+#endif  // __HOST_PICO_STDIO_H__
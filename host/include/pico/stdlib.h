@@ -0,0 +1,13 @@
+#ifndef __HOST_PICO_STDLIB_H__
+#define __HOST_PICO_STDLIB_H__
+
+// Host stand-in for the Pico SDK's pico_stdlib, see host/sim.cpp
+
+#include "pico/types.h"
+#include "pico/platform.h"
+#include "pico/stdio.h"
+#include "pico/time.h"
+#include "hardware/gpio.h"
+#include <stdlib.h>
+
+#endif  // __HOST_PICO_STDLIB_H__
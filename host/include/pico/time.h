@@ -0,0 +1,86 @@
+#ifndef __HOST_PICO_TIME_H__
+#define __HOST_PICO_TIME_H__
+
+// Host stand-in for the Pico SDK's timer and alarm API, see host/sim.cpp
+// Time is virtual: it only moves when a core sleeps (jumping straight to the
+// next alarm, scripted input or deadline) and by a fixed step per clock read
+// on core 0, so runs are repeatable and idle time costs no wall time
+
+#include "pico/types.h"
+
+typedef int32_t alarm_id_t;
+typedef int64_t (*alarm_callback_t)(alarm_id_t id, void *user_data);
+
+#define nil_time ((absolute_time_t)0)
+#define at_the_end_of_time ((absolute_time_t)INT64_MAX)
+
+uint64_t time_us_64(void);
+
+static inline uint32_t time_us_32(void) {
+    return (uint32_t)time_us_64();
+}
+
+static inline absolute_time_t get_absolute_time(void) {
+    return time_us_64();
+}
+
+static inline uint64_t to_us_since_boot(absolute_time_t t) {
+    return t;
+}
+
+static inline absolute_time_t from_us_since_boot(uint64_t us) {
+    return us;
+}
+
+static inline absolute_time_t delayed_by_us(const absolute_time_t t, uint64_t us) {
+    uint64_t delayed = t + us;
+    return (delayed < t || delayed > at_the_end_of_time) ? at_the_end_of_time : delayed;
+}
+
+static inline absolute_time_t delayed_by_ms(const absolute_time_t t, uint32_t ms) {
+    return delayed_by_us(t, 1000ull * ms);
+}
+
+static inline absolute_time_t make_timeout_time_us(uint64_t us) {
+    return delayed_by_us(get_absolute_time(), us);
+}
+
+static inline absolute_time_t make_timeout_time_ms(uint32_t ms) {
+    return delayed_by_ms(get_absolute_time(), ms);
+}
+
+static inline int64_t absolute_time_diff_us(absolute_time_t from, absolute_time_t to) {
+    return (int64_t)(to - from);
+}
+
+static inline bool time_reached(absolute_time_t t) {
+    return time_us_64() >= t;
+}
+
+static inline bool is_nil_time(absolute_time_t t) {
+    return t == nil_time;
+}
+
+static inline bool is_at_the_end_of_time(absolute_time_t t) {
+    return t == at_the_end_of_time;
+}
+
+// Sleeps advance the virtual clock, running the alarms and inputs due meanwhile
+void sleep_until(absolute_time_t target);
+void sleep_us(uint64_t us);
+void sleep_ms(uint32_t ms);
+void busy_wait_us(uint64_t us);
+
+// Core 1 waits for an event (SEV) or the deadline
+// @return true if the deadline was reached
+bool best_effort_wfe_or_timeout(absolute_time_t timeout_timestamp);
+
+alarm_id_t add_alarm_at(absolute_time_t time, alarm_callback_t callback, void *user_data,
+                        bool fire_if_past);
+alarm_id_t add_alarm_in_us(uint64_t us, alarm_callback_t callback, void *user_data,
+                           bool fire_if_past);
+alarm_id_t add_alarm_in_ms(uint32_t ms, alarm_callback_t callback, void *user_data,
+                           bool fire_if_past);
+bool cancel_alarm(alarm_id_t alarm_id);
+
+#endif  // __HOST_PICO_TIME_H__
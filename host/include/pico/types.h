@@ -0,0 +1,17 @@
+#ifndef __HOST_PICO_TYPES_H__
+#define __HOST_PICO_TYPES_H__
+
+// Host stand-in for the Pico SDK's basic types, see host/sim.cpp
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef unsigned int uint;
+
+// Microseconds since boot of the virtual clock
+typedef uint64_t absolute_time_t;
+
+#define PICO_ERROR_TIMEOUT -1
+
+#endif  // __HOST_PICO_TYPES_H__
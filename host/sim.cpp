@@ -0,0 +1,748 @@
+#include "sim.hpp"
+#include "pico/multicore.h"
+#include "pico/stdlib.h"
+#include "pico/time.h"
+#include "hardware/flash.h"
+#include "hardware/gpio.h"
+#include "hardware/irq.h"
+#include "hardware/pwm.h"
+#include "hardware/sync.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const uint NUMBER_OF_CORES = 2;
+const size_t FIFO_DEPTH = 8;
+
+// Struct for storing a pending alarm
+typedef struct {
+    alarm_id_t id;
+    uint64_t at_us;
+    alarm_callback_t callback;
+    void *user_data;
+} Alarm;
+
+// Struct for storing a scheduled input edge
+typedef struct {
+    uint64_t at_us;
+    uint pin;
+    bool level;
+} Edge;
+
+// Struct for storing a byte scheduled to arrive over USB
+typedef struct {
+    uint64_t at_us;
+    uint8_t byte;
+} Typed;
+
+// Struct for storing a GPIO interrupt waiting to be handled
+typedef struct {
+    uint pin;
+    uint32_t events;
+} GpioIrq;
+
+// Struct for storing the state of one GPIO
+typedef struct {
+    bool is_out;
+    bool out;
+    bool is_driven;         // Driven from outside (the script)
+    bool driven;
+    bool pull_up;
+    bool pull_down;
+    uint function;
+    uint32_t irq_mask;
+    uint16_t pwm_level;
+} Pin;
+
+// Virtual time, in nanoseconds so that clock reads can cost less than 1 us
+std::atomic<uint64_t> now_ns(0);
+uint64_t clock_step_ns = 1000;
+uint64_t end_us = at_the_end_of_time;
+std::chrono::steady_clock::time_point wall_start;
+
+thread_local uint core_num = 0;
+
+// Core 0 state, only touched from core 0's thread
+std::vector<Alarm> alarms;
+alarm_id_t next_alarm_id = 1;
+std::vector<Edge> edges;
+size_t next_edge = 0;
+std::vector<Typed> typed;
+size_t next_typed = 0;
+std::deque<uint8_t> serial_rx;
+bool is_usb_irq_pending = false;
+Pin pins[NUM_BANK0_GPIOS];
+gpio_irq_callback_t gpio_callback = nullptr;
+std::deque<GpioIrq> gpio_irqs;
+bool interrupts_enabled = true;
+bool in_interrupt = false;
+irq_handler_t sio_handler = nullptr;
+bool sio_irq_enabled = false;
+std::vector<Sim::FinishHook> finish_hooks;
+SimStats stats = {};
+
+// Flash image, erased, and the file it is kept in
+std::vector<uint8_t> flash_image(PICO_FLASH_SIZE_BYTES, 0xff);
+FILE *flash_file = nullptr;
+
+// State shared by the cores
+std::mutex mutex;
+std::condition_variable changed;
+std::deque<uint32_t> fifos[NUMBER_OF_CORES];    // fifos[c] holds the words for core c
+bool events[NUMBER_OF_CORES] = {false, false};
+bool is_core1_launched = false;
+bool is_core1_idle = false;
+uint64_t core1_deadline_us = at_the_end_of_time;
+
+uint64_t now_us() {
+    return now_ns.load() / 1000;
+}
+
+bool read_level(const Pin &pin) {
+    if (pin.is_out) {
+        return pin.out;
+    }
+    if (pin.is_driven) {
+        return pin.driven;
+    }
+    return pin.pull_up && !pin.pull_down;
+}
+
+[[noreturn]] void finish() {
+    stats.virtual_us = now_us();
+    stats.wall_us = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - wall_start).count());
+    fflush(stdout);
+
+    for (Sim::FinishHook hook : finish_hooks) {
+        hook();
+    }
+    fflush(stdout);
+    fflush(stderr);
+
+    // Core 1 may be blocked for ever, so skip the static destructors
+    _Exit(0);
+}
+
+// Sets the virtual clock, waking core 1 if its deadline passed
+void set_now(const uint64_t us) {
+    if (us * 1000 > now_ns.load()) {
+        now_ns.store(us * 1000);
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    if (is_core1_idle && now_us() >= core1_deadline_us) {
+        // Core 1 is busy again until it next waits
+        is_core1_idle = false;
+        changed.notify_all();
+    }
+}
+
+// Applies every scripted edge that is due, queueing the GPIO interrupts,
+// and receives the characters typed by then, raising the USB interrupt
+void apply_edges() {
+    while (next_typed < typed.size() && typed[next_typed].at_us <= now_us()) {
+        serial_rx.push_back(typed[next_typed++].byte);
+        is_usb_irq_pending = true;
+    }
+
+    while (next_edge < edges.size() && edges[next_edge].at_us <= now_us()) {
+        const Edge &edge = edges[next_edge++];
+        Pin &pin = pins[edge.pin];
+        bool was_high = read_level(pin);
+        pin.is_driven = true;
+        pin.driven = edge.level;
+        bool is_high = read_level(pin);
+        stats.edges++;
+
+        if (is_high != was_high) {
+            uint32_t event = is_high ? GPIO_IRQ_EDGE_RISE : GPIO_IRQ_EDGE_FALL;
+            if (pin.irq_mask & event) {
+                gpio_irqs.push_back({edge.pin, event});
+            }
+        }
+    }
+}
+
+// Returns the index of the alarm due first, -1 if there is none
+int find_first_alarm() {
+    int first = -1;
+    for (size_t i = 0; i < alarms.size(); i++) {
+        if (first < 0 || alarms[i].at_us < alarms[first].at_us) {
+            first = static_cast<int>(i);
+        }
+    }
+    return first;
+}
+
+bool is_doorbell_pending() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return sio_irq_enabled && sio_handler != nullptr && !fifos[0].empty();
+}
+
+// Returns true if an interrupt is waiting to be handled on core 0
+bool is_interrupt_pending() {
+    int first = find_first_alarm();
+    return !gpio_irqs.empty() || (first >= 0 && alarms[first].at_us <= now_us()) ||
+           is_usb_irq_pending || is_doorbell_pending();
+}
+
+// Runs the handlers of every pending interrupt, as if core 0 took them
+void run_interrupts() {
+    if (!interrupts_enabled || in_interrupt) {
+        return;
+    }
+    in_interrupt = true;
+
+    // The USB stack's interrupt only wakes the core, stdio reads the data
+    is_usb_irq_pending = false;
+
+    bool is_handled = true;
+    while (is_handled) {
+        is_handled = false;
+
+        while (!gpio_irqs.empty()) {
+            GpioIrq irq = gpio_irqs.front();
+            gpio_irqs.pop_front();
+            if (gpio_callback != nullptr) {
+                stats.gpio_irqs++;
+                gpio_callback(irq.pin, irq.events);
+            }
+            is_handled = true;
+        }
+
+        int first = find_first_alarm();
+        if (first >= 0 && alarms[first].at_us <= now_us()) {
+            Alarm alarm = alarms[first];
+            alarms.erase(alarms.begin() + first);
+            stats.alarms++;
+            int64_t reschedule = alarm.callback(alarm.id, alarm.user_data);
+            // >0: that long from now, <0: that long after the time it was due
+            if (reschedule != 0) {
+                alarm.at_us = (reschedule > 0) ? now_us() + static_cast<uint64_t>(reschedule)
+                                               : alarm.at_us + static_cast<uint64_t>(-reschedule);
+                alarms.push_back(alarm);
+            }
+            is_handled = true;
+        }
+
+        if (is_doorbell_pending()) {
+            stats.sio_irqs++;
+            sio_handler();
+            is_handled = true;
+        }
+    }
+
+    in_interrupt = false;
+}
+
+// Waits until core 1 can't do anything more without core 0, so that time
+// only moves on once it has caught up
+void wait_for_core1() {
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait(lock, [] {
+        return !is_core1_launched || is_core1_idle || fifos[0].size() == FIFO_DEPTH;
+    });
+}
+
+// Returns the time of the next alarm, input edge or core 1 deadline
+uint64_t find_next_event() {
+    uint64_t next = at_the_end_of_time;
+    int first = find_first_alarm();
+    if (first >= 0) {
+        next = alarms[first].at_us;
+    }
+    if (next_edge < edges.size() && edges[next_edge].at_us < next) {
+        next = edges[next_edge].at_us;
+    }
+    if (next_typed < typed.size() && typed[next_typed].at_us < next) {
+        next = typed[next_typed].at_us;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    if (core1_deadline_us < next) {
+        next = core1_deadline_us;
+    }
+    return next;
+}
+
+// Moves core 0's time on to target, handling the interrupts due on the way
+void advance_to(const uint64_t target_us) {
+    stats.sleeps++;
+    while (true) {
+        wait_for_core1();
+        apply_edges();
+        run_interrupts();
+
+        // Stop at the target, or if what is due can't run (interrupts masked)
+        uint64_t next = find_next_event();
+        if (next <= now_us() || next > target_us) {
+            break;
+        }
+        if (next > end_us) {
+            set_now(end_us);
+            finish();
+        }
+        set_now(next);
+    }
+    if (target_us > end_us) {
+        set_now(end_us);
+        finish();
+    }
+    set_now(target_us);
+    apply_edges();
+    run_interrupts();
+}
+
+// Core 1 waits for an event or its deadline
+// @return true if the deadline was reached
+bool wait_for_event(const uint64_t deadline_us) {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (events[1]) {
+        events[1] = false;
+        return false;
+    }
+    core1_deadline_us = deadline_us;
+    is_core1_idle = true;
+    changed.notify_all();
+    changed.wait(lock, [deadline_us] { return events[1] || now_us() >= deadline_us; });
+    is_core1_idle = false;
+    core1_deadline_us = at_the_end_of_time;
+    bool is_reached = !events[1];
+    events[1] = false;
+    return is_reached;
+}
+
+// Signals an event to the given core, must hold the mutex
+void signal_event(const uint core) {
+    events[core] = true;
+    if (core == 1) {
+        // Core 1 is busy again until it next waits
+        is_core1_idle = false;
+    }
+    changed.notify_all();
+}
+
+// Checks a flash operation the way the hardware would fail it
+void check_flash_range(const char *operation, const uint32_t offset, const size_t count,
+                       const uint32_t alignment) {
+    if (offset % alignment != 0 || count % alignment != 0 ||
+        offset + count > flash_image.size()) {
+        fprintf(stderr, "sim: %s of %zu bytes at 0x%x is not aligned to %u or out of range\n",
+                operation, count, static_cast<unsigned>(offset), static_cast<unsigned>(alignment));
+        abort();
+    }
+    if (core_num == 0 && interrupts_enabled) {
+        // An interrupt handler in flash would crash the Pico
+        fprintf(stderr, "sim: %s with interrupts enabled\n", operation);
+    }
+}
+
+// Writes the changed part of the image back to its file
+void write_flash_file(const uint32_t offset, const size_t count) {
+    if (flash_file == nullptr) {
+        return;
+    }
+    if (fseek(flash_file, offset, SEEK_SET) != 0 ||
+        fwrite(flash_image.data() + offset, 1, count, flash_file) != count ||
+        fflush(flash_file) != 0) {
+        fprintf(stderr, "sim: cannot write the flash file\n");
+    }
+}
+
+}  // namespace
+
+// Sim
+
+void Sim::drive_at(const uint64_t at_us, const uint pin, const bool level) {
+    if (pin < NUM_BANK0_GPIOS) {
+        edges.push_back({at_us, pin, level});
+    }
+}
+
+void Sim::type_at(const uint64_t at_us, const char *text) {
+    send_at(at_us, reinterpret_cast<const uint8_t *>(text), strlen(text));
+}
+
+void Sim::send_at(const uint64_t at_us, const uint8_t *data, const size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        typed.push_back({at_us, data[i]});
+    }
+}
+
+void Sim::set_end_time(const uint64_t us) {
+    end_us = us;
+}
+
+void Sim::set_clock_step_ns(const uint32_t step_ns) {
+    clock_step_ns = step_ns;
+}
+
+void Sim::on_finish(FinishHook hook) {
+    finish_hooks.push_back(hook);
+}
+
+void Sim::run(int (*firmware_main)(void)) {
+    std::stable_sort(edges.begin(), edges.end(),
+                     [](const Edge &a, const Edge &b) { return a.at_us < b.at_us; });
+    std::stable_sort(typed.begin(), typed.end(),
+                     [](const Typed &a, const Typed &b) { return a.at_us < b.at_us; });
+    wall_start = std::chrono::steady_clock::now();
+
+    // Levels held at power-up, e.g. a button held to pick a mode
+    apply_edges();
+    gpio_irqs.clear();
+
+    firmware_main();
+    finish();
+}
+
+bool Sim::set_flash_file(const char *path) {
+    flash_file = fopen(path, "r+b");
+    if (flash_file == nullptr) {
+        // A new file starts as erased flash
+        flash_file = fopen(path, "w+b");
+        if (flash_file == nullptr) {
+            return false;
+        }
+        std::fill(flash_image.begin(), flash_image.end(), 0xff);
+        write_flash_file(0, flash_image.size());
+        return true;
+    }
+    size_t length = fread(flash_image.data(), 1, flash_image.size(), flash_file);
+    std::fill(flash_image.begin() + length, flash_image.end(), 0xff);
+    return true;
+}
+
+SimStats Sim::get_stats() {
+    SimStats current = stats;
+    current.virtual_us = now_us();
+    return current;
+}
+
+bool Sim::get_level(const uint pin) {
+    return (pin < NUM_BANK0_GPIOS) && read_level(pins[pin]);
+}
+
+uint16_t Sim::get_pwm_level(const uint pin) {
+    return (pin < NUM_BANK0_GPIOS) ? pins[pin].pwm_level : 0;
+}
+
+bool Sim::is_pwm(const uint pin) {
+    return (pin < NUM_BANK0_GPIOS) && pins[pin].function == GPIO_FUNC_PWM;
+}
+
+// pico/platform.h
+
+uint get_core_num(void) {
+    return core_num;
+}
+
+void tight_loop_contents(void) {
+    std::this_thread::yield();
+}
+
+// pico/time.h
+
+uint64_t time_us_64(void) {
+    if (core_num == 0) {
+        // The code between clock reads takes time too
+        return (now_ns.fetch_add(clock_step_ns) + clock_step_ns) / 1000;
+    }
+    return now_us();
+}
+
+void sleep_until(absolute_time_t target) {
+    if (core_num == 0 && is_at_the_end_of_time(target)) {
+        // Only interrupts are left to wake up for
+        while (true) {
+            __wfi();
+        }
+    }
+    if (core_num == 0) {
+        advance_to(target);
+        return;
+    }
+    while (now_us() < target) {
+        wait_for_event(target);
+    }
+}
+
+void sleep_us(uint64_t us) {
+    sleep_until(delayed_by_us(get_absolute_time(), us));
+}
+
+void sleep_ms(uint32_t ms) {
+    sleep_us(1000ull * ms);
+}
+
+void busy_wait_us(uint64_t us) {
+    sleep_us(us);
+}
+
+bool best_effort_wfe_or_timeout(absolute_time_t timeout_timestamp) {
+    if (core_num == 0) {
+        __wfi();
+        return time_reached(timeout_timestamp);
+    }
+    return wait_for_event(timeout_timestamp);
+}
+
+alarm_id_t add_alarm_at(absolute_time_t time, alarm_callback_t callback, void *user_data,
+                        bool fire_if_past) {
+    if (time <= now_us()) {
+        if (!fire_if_past) {
+            return 0;
+        }
+        int64_t reschedule = callback(next_alarm_id, user_data);
+        if (reschedule == 0) {
+            return 0;
+        }
+        time = (reschedule > 0) ? now_us() + static_cast<uint64_t>(reschedule)
+                                : time + static_cast<uint64_t>(-reschedule);
+    }
+    Alarm alarm = {next_alarm_id++, time, callback, user_data};
+    alarms.push_back(alarm);
+    return alarm.id;
+}
+
+alarm_id_t add_alarm_in_us(uint64_t us, alarm_callback_t callback, void *user_data,
+                           bool fire_if_past) {
+    return add_alarm_at(delayed_by_us(now_us(), us), callback, user_data, fire_if_past);
+}
+
+alarm_id_t add_alarm_in_ms(uint32_t ms, alarm_callback_t callback, void *user_data,
+                           bool fire_if_past) {
+    return add_alarm_in_us(1000ull * ms, callback, user_data, fire_if_past);
+}
+
+bool cancel_alarm(alarm_id_t alarm_id) {
+    for (size_t i = 0; i < alarms.size(); i++) {
+        if (alarms[i].id == alarm_id) {
+            alarms.erase(alarms.begin() + i);
+            return true;
+        }
+    }
+    return false;
+}
+
+// pico/stdio.h
+
+int getchar_timeout_us(uint32_t timeout_us) {
+    (void)timeout_us;
+    if (core_num != 0 || serial_rx.empty()) {
+        return PICO_ERROR_TIMEOUT;
+    }
+    uint8_t byte = serial_rx.front();
+    serial_rx.pop_front();
+    return byte;
+}
+
+// hardware/flash.h
+
+const uint8_t *host_flash_contents(void) {
+    return flash_image.data();
+}
+
+void flash_range_erase(uint32_t flash_offs, size_t count) {
+    check_flash_range("flash erase", flash_offs, count, FLASH_SECTOR_SIZE);
+    std::fill(flash_image.begin() + flash_offs, flash_image.begin() + flash_offs + count, 0xff);
+    stats.flash_erases += count / FLASH_SECTOR_SIZE;
+    write_flash_file(flash_offs, count);
+}
+
+void flash_range_program(uint32_t flash_offs, const uint8_t *data, size_t count) {
+    check_flash_range("flash program", flash_offs, count, FLASH_PAGE_SIZE);
+    // Programming can only clear bits
+    for (size_t i = 0; i < count; i++) {
+        flash_image[flash_offs + i] &= data[i];
+    }
+    stats.flash_programs += count / FLASH_PAGE_SIZE;
+    write_flash_file(flash_offs, count);
+}
+
+// hardware/sync.h
+
+uint32_t save_and_disable_interrupts(void) {
+    if (core_num != 0) {
+        return 0;
+    }
+    uint32_t status = interrupts_enabled ? 1 : 0;
+    interrupts_enabled = false;
+    return status;
+}
+
+void restore_interrupts(uint32_t status) {
+    if (core_num != 0) {
+        return;
+    }
+    interrupts_enabled = (status != 0);
+    run_interrupts();
+}
+
+void __wfi(void) {
+    if (core_num != 0) {
+        wait_for_event(at_the_end_of_time);
+        return;
+    }
+
+    // A pending interrupt ends the WFI straight away, even while masked
+    wait_for_core1();
+    apply_edges();
+    if (is_interrupt_pending()) {
+        run_interrupts();
+        return;
+    }
+
+    // Otherwise sleep until the next thing happens, or stop if nothing will
+    stats.sleeps++;
+    uint64_t next = find_next_event();
+    if (next == at_the_end_of_time || next > end_us) {
+        set_now(std::max(end_us, now_us()));
+        finish();
+    }
+    set_now(next);
+    apply_edges();
+    run_interrupts();
+}
+
+void __wfe(void) {
+    if (core_num == 0) {
+        __wfi();
+        return;
+    }
+    wait_for_event(at_the_end_of_time);
+}
+
+void __sev(void) {
+    std::lock_guard<std::mutex> lock(mutex);
+    signal_event(1 - core_num);
+}
+
+// hardware/irq.h
+
+void irq_set_exclusive_handler(uint num, irq_handler_t handler) {
+    if (num == SIO_IRQ_PROC0) {
+        std::lock_guard<std::mutex> lock(mutex);
+        sio_handler = handler;
+    }
+}
+
+void irq_set_enabled(uint num, bool enabled) {
+    if (num == SIO_IRQ_PROC0) {
+        std::lock_guard<std::mutex> lock(mutex);
+        sio_irq_enabled = enabled;
+    }
+}
+
+// hardware/gpio.h
+
+void gpio_init(uint gpio) {
+    Pin &pin = pins[gpio];
+    pin.is_out = false;
+    pin.out = false;
+    pin.function = GPIO_FUNC_SIO;
+}
+
+void gpio_set_dir(uint gpio, bool out) {
+    pins[gpio].is_out = out;
+}
+
+void gpio_set_function(uint gpio, enum gpio_function fn) {
+    pins[gpio].function = fn;
+}
+
+void gpio_set_pulls(uint gpio, bool up, bool down) {
+    pins[gpio].pull_up = up;
+    pins[gpio].pull_down = down;
+}
+
+bool gpio_get(uint gpio) {
+    return read_level(pins[gpio]);
+}
+
+void gpio_put(uint gpio, bool value) {
+    pins[gpio].out = value;
+}
+
+void gpio_set_irq_enabled_with_callback(uint gpio, uint32_t event_mask, bool enabled,
+                                        gpio_irq_callback_t callback) {
+    if (enabled) {
+        pins[gpio].irq_mask |= event_mask;
+    } else {
+        pins[gpio].irq_mask &= ~event_mask;
+    }
+    gpio_callback = callback;
+}
+
+// hardware/pwm.h
+
+void pwm_init(uint slice_num, pwm_config *config, bool start) {
+    (void)slice_num;
+    (void)config;
+    (void)start;
+}
+
+void pwm_set_gpio_level(uint gpio, uint16_t level) {
+    pins[gpio].pwm_level = level;
+}
+
+// pico/multicore.h
+
+void multicore_launch_core1(void (*entry)(void)) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        is_core1_launched = true;
+        is_core1_idle = false;
+    }
+    std::thread core1([entry] {
+        core_num = 1;
+        entry();
+    });
+    core1.detach();
+}
+
+bool multicore_fifo_rvalid(void) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return !fifos[core_num].empty();
+}
+
+bool multicore_fifo_wready(void) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return fifos[1 - core_num].size() < FIFO_DEPTH;
+}
+
+void multicore_fifo_push_blocking(uint32_t data) {
+    uint other = 1 - core_num;
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait(lock, [other] { return fifos[other].size() < FIFO_DEPTH; });
+    fifos[other].push_back(data);
+    // A FIFO write signals an event to the other core
+    signal_event(other);
+}
+
+uint32_t multicore_fifo_pop_blocking(void) {
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait(lock, [] { return !fifos[core_num].empty(); });
+    uint32_t data = fifos[core_num].front();
+    fifos[core_num].pop_front();
+    changed.notify_all();
+    return data;
+}
+
+void multicore_fifo_drain(void) {
+    std::lock_guard<std::mutex> lock(mutex);
+    fifos[core_num].clear();
+    changed.notify_all();
+}
+
+void multicore_fifo_clear_irq(void) {
+}
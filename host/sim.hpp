@@ -0,0 +1,84 @@
+#ifndef __SIM_HPP__
+#define __SIM_HPP__
+
+#include "pico/types.h"
+
+// Struct for storing what a simulation run did
+// @field virtual_us Simulated time at the end of the run
+// @field wall_us Host time the run took
+// @field sleeps Number of times core 0 slept (WFI or sleep_*)
+// @field alarms Number of alarm callbacks run
+// @field edges Number of scripted input edges applied
+// @field gpio_irqs Number of GPIO interrupt callbacks run
+// @field sio_irqs Number of inter-core doorbell interrupts run
+// @field flash_erases Number of flash sectors erased
+// @field flash_programs Number of flash pages programmed
+typedef struct {
+    uint64_t virtual_us;
+    uint64_t wall_us;
+    uint64_t sleeps;
+    uint64_t alarms;
+    uint64_t edges;
+    uint64_t gpio_irqs;
+    uint64_t sio_irqs;
+    uint64_t flash_erases;
+    uint64_t flash_programs;
+} SimStats;
+
+// Host simulation of the parts of the RP2040 the game uses
+// Implements the stand-in Pico SDK headers in host/include: a virtual clock,
+// GPIOs driven by scheduled input edges, alarms, PWM levels, the flash, and
+// the two cores as threads linked by the inter-core FIFOs. Interrupt
+// handlers run on core 0's thread whenever it sleeps or re-enables
+// interrupts. When core 0 waits for an interrupt, time jumps to the next
+// alarm or input edge, so a game with 30 ms debounces runs in microseconds
+// of wall time
+class Sim {
+    public:
+        // Function to call when the run ends
+        typedef void (*FinishHook)(void);
+
+        // Drives an input pin to level at the given time, e.g. a button edge
+        // Edges must be scheduled before run(), in any order
+        static void drive_at(const uint64_t at_us, const uint pin, const bool level);
+
+        // Sends the text over the simulated USB serial port at the given time
+        // Like drive_at, must be called before run()
+        static void type_at(const uint64_t at_us, const char *text);
+
+        // Sends the bytes over the simulated USB serial port at the given time
+        static void send_at(const uint64_t at_us, const uint8_t *data, const size_t length);
+
+        // Sets the virtual time after which the run ends
+        static void set_end_time(const uint64_t end_us);
+
+        // Sets how far every clock read on core 0 advances time, standing in
+        // for the code that runs between reads (default 1000 ns)
+        static void set_clock_step_ns(const uint32_t step_ns);
+
+        // Keeps the flash in the file, so it survives between runs
+        // A missing file is created as erased flash
+        // @return false if the file can't be opened or created
+        static bool set_flash_file(const char *path);
+
+        // Registers a function to call when the run ends, before the exit
+        static void on_finish(FinishHook hook);
+
+        // Runs the firmware's main() on this thread as core 0 until the end
+        // time passes or nothing is left to happen, then exits the process
+        static void run(int (*firmware_main)(void));
+
+        // Returns the statistics of the run so far
+        static SimStats get_stats();
+
+        // Returns the level of a GPIO as the firmware would read it
+        static bool get_level(const uint pin);
+
+        // Returns the PWM level last set for a GPIO
+        static uint16_t get_pwm_level(const uint pin);
+
+        // Returns true if the GPIO is switched to its PWM slice
+        static bool is_pwm(const uint pin);
+};
+
+#endif  // __SIM_HPP__
@@ -0,0 +1,109 @@
+#include "input.hpp"
+#include "trace.hpp"
+#include "hardware/gpio.h"
+#include "pico/time.h"
+
+Input::Debouncer Input::buttons[NUMBER_OF_BUTTONS];
+uint Input::debounce_delay_ms = 0;
+SpscQueue<BtnEvent, Input::EVENT_QUEUE_SIZE> Input::events;
+LatencyStats Input::latency = {0, 0, 0, 0};
+
+void Input::init(const uint (&pins)[NUMBER_OF_BUTTONS], const uint debounce_ms) {
+    debounce_delay_ms = debounce_ms;
+
+    for (uint i = 0; i < NUMBER_OF_BUTTONS; i++) {
+        buttons[i].pin = pins[i];
+        buttons[i].state = IDLE;
+        // Buttons are active-low, a pin reading LOW is pressed
+        buttons[i].is_pressed = !gpio_get(pins[i]);
+
+        // Interrupt on both edges; all GPIOs share one callback per core
+        gpio_set_irq_enabled_with_callback(pins[i], GPIO_IRQ_EDGE_FALL | GPIO_IRQ_EDGE_RISE,
+                                           true, &Input::on_edge);
+    }
+}
+
+bool Input::pop_event(BtnEvent *event) {
+    return events.try_pop(event);
+}
+
+bool Input::has_events() {
+    return !events.is_empty();
+}
+
+void Input::record_latency(const BtnEvent &event) {
+    uint32_t elapsed = static_cast<uint32_t>(time_us_64() - event.edge_us);
+    latency.count++;
+    latency.last_us = elapsed;
+    latency.total_us += elapsed;
+    if (elapsed > latency.max_us) {
+        latency.max_us = elapsed;
+    }
+}
+
+const LatencyStats &Input::get_latency_stats() {
+    return latency;
+}
+
+uint32_t Input::get_dropped_events() {
+    return events.get_dropped();
+}
+
+void Input::accept(const uint8_t button, const bool is_pressed, const uint64_t edge_us) {
+    buttons[button].is_pressed = is_pressed;
+    buttons[button].state = LOCKED_OUT;
+
+    // Never blocks: if the main loop falls 16 events behind, the event is dropped and counted
+    BtnEvent event = {button, is_pressed, edge_us};
+    events.try_push(event);
+
+    // Ignore further edges of this button until the contacts have settled
+    alarm_id_t alarm = add_alarm_in_ms(debounce_delay_ms, &Input::on_lockout_end,
+                                       reinterpret_cast<void *>(static_cast<uintptr_t>(button)),
+                                       true);
+    if (alarm < 0) {
+        // No alarm slot was free and nothing would end the lockout: take
+        // edges again straight away, letting this press's bounce through
+        // rather than ignoring the button for good
+        buttons[button].state = IDLE;
+    }
+}
+
+void Input::on_edge(uint gpio, uint32_t event_mask) {
+    TRACE_SCOPE(TRACE_DEBOUNCE);
+    (void)event_mask;
+    uint64_t now = time_us_64();
+
+    for (uint8_t i = 0; i < NUMBER_OF_BUTTONS; i++) {
+        if (buttons[i].pin != gpio) {
+            continue;
+        }
+        // Bounce while locked out is ignored, the alarm re-checks the level
+        if (buttons[i].state == IDLE) {
+            bool is_pressed = !gpio_get(gpio);
+            // Report the first edge of a real change straight away
+            if (is_pressed != buttons[i].is_pressed) {
+                accept(i, is_pressed, now);
+            }
+        }
+        return;
+    }
+}
+
+int64_t Input::on_lockout_end(alarm_id_t id, void *user_data) {
+    TRACE_SCOPE(TRACE_DEBOUNCE);
+    (void)id;
+    uint8_t button = static_cast<uint8_t>(reinterpret_cast<uintptr_t>(user_data));
+    bool is_pressed = !gpio_get(buttons[button].pin);
+
+    if (is_pressed != buttons[button].is_pressed) {
+        // The button changed state during the lockout (e.g. a short tap was
+        // released), report it now and lock out again
+        accept(button, is_pressed, time_us_64());
+    } else {
+        buttons[button].state = IDLE;
+    }
+
+    // Don't reschedule the alarm
+    return 0;
+}
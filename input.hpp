@@ -0,0 +1,91 @@
+#ifndef __INPUT_HPP__
+#define __INPUT_HPP__
+
+#include "pico/stdlib.h"
+#include "spsc_queue.hpp"
+#include <stdint.h>
+
+// Struct for storing one debounced button event
+// @field button Index of the button in the pins passed to Input::init
+// @field is_pressed true for a press, false for a release
+// @field edge_us Time of the first edge of the press or release
+typedef struct {
+    uint8_t button;
+    bool is_pressed;
+    uint64_t edge_us;
+} BtnEvent;
+
+// Struct for storing press-to-handled latency statistics
+// @field count Number of recorded events
+// @field last_us Latency of the last event
+// @field max_us Largest latency seen
+// @field total_us Sum of all latencies, for the average
+typedef struct {
+    uint32_t count;
+    uint32_t last_us;
+    uint32_t max_us;
+    uint64_t total_us;
+} LatencyStats;
+
+// Interrupt-driven button input
+// GPIO edge IRQs feed a per-button debounce state machine timed by alarms.
+// A state change is reported on its first edge, after which the button is
+// locked out for the debounce delay so contact bounce is ignored. Debounced
+// events go into a lock-free queue that the main loop drains without blocking.
+class Input {
+    public:
+        static const uint NUMBER_OF_BUTTONS = 3;
+        static const uint32_t EVENT_QUEUE_SIZE = 16;
+
+        // Enables edge IRQs on the (active-low, pulled-up) button pins
+        // @param pins The button pins, the event's button field indexes this array
+        // @param debounce_ms Lockout time after each accepted edge
+        static void init(const uint (&pins)[NUMBER_OF_BUTTONS], const uint debounce_ms);
+
+        // Pops the oldest debounced event, returns false if there is none
+        static bool pop_event(BtnEvent *event);
+
+        // Returns true if debounced events are waiting
+        static bool has_events();
+
+        // Records the latency from the event's first edge until now
+        // Call once the event has been fully handled
+        static void record_latency(const BtnEvent &event);
+
+        // Returns the recorded latency statistics
+        static const LatencyStats &get_latency_stats();
+
+        // Returns the number of events lost because the queue was full
+        static uint32_t get_dropped_events();
+
+    private:
+        // Debounce states of one button
+        static const uint8_t IDLE = 0;          // Waiting for an edge
+        static const uint8_t LOCKED_OUT = 1;    // Ignoring bounce until the alarm fires
+
+        // Struct for storing the debounce state of one button
+        // @field pin GPIO pin of the button
+        // @field state IDLE or LOCKED_OUT
+        // @field is_pressed Last reported (debounced) state
+        typedef struct {
+            uint pin;
+            volatile uint8_t state;
+            volatile bool is_pressed;
+        } Debouncer;
+
+        static Debouncer buttons[NUMBER_OF_BUTTONS];
+        static uint debounce_delay_ms;
+        static SpscQueue<BtnEvent, EVENT_QUEUE_SIZE> events;
+        static LatencyStats latency;
+
+        // Reports a state change of the button and starts its lockout
+        static void accept(const uint8_t button, const bool is_pressed, const uint64_t edge_us);
+
+        // GPIO IRQ callback, runs on every edge of every button
+        static void on_edge(uint gpio, uint32_t event_mask);
+
+        // Alarm callback, ends a button's lockout
+        static int64_t on_lockout_end(alarm_id_t id, void *user_data);
+};
+
+#endif  // __INPUT_HPP__
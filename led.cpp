@@ -0,0 +1,155 @@
+#include "led.hpp"
+#include "hardware/gpio.h"
+#include "hardware/pwm.h"
+#include "hardware/sync.h"
+
+LedPatterns::Led LedPatterns::leds[MAX_LEDS];
+uint LedPatterns::number_of_leds = 0;
+alarm_id_t LedPatterns::alarm = 0;
+
+void LedPatterns::init(const uint *pins, const uint count) {
+    number_of_leds = (count < MAX_LEDS) ? count : MAX_LEDS;
+
+    for (uint i = 0; i < number_of_leds; i++) {
+        leds[i].pin = pins[i];
+        leds[i].pattern = off();
+        leds[i].then = off();
+        leds[i].start_us = 0;
+
+        // 125 MHz / 256 steps is a ~490 kHz PWM, far too fast to flicker
+        gpio_set_function(pins[i], GPIO_FUNC_PWM);
+        uint slice = pwm_gpio_to_slice_num(pins[i]);
+        pwm_config config = pwm_get_default_config();
+        pwm_config_set_wrap(&config, PWM_WRAP);
+        pwm_init(slice, &config, true);
+        pwm_set_gpio_level(pins[i], 0);
+    }
+}
+
+bool LedPatterns::show(const uint pin, const LedPattern &pattern, const LedPattern &then) {
+    for (uint i = 0; i < number_of_leds; i++) {
+        if (leds[i].pin != pin) {
+            continue;
+        }
+
+        // The alarm callback reads the patterns, keep it out while they change
+        uint32_t status = save_and_disable_interrupts();
+        uint64_t now = time_us_64();
+        leds[i].pattern = pattern;
+        leds[i].then = then;
+        leds[i].start_us = now;
+
+        // Re-arm the alarm for the next change of any LED, if there is one
+        if (alarm > 0) {
+            cancel_alarm(alarm);
+            alarm = 0;
+        }
+        int64_t next_us = update(now);
+        if (next_us > 0) {
+            alarm = add_alarm_in_us(next_us, &LedPatterns::on_alarm, NULL, true);
+        }
+        restore_interrupts(status);
+        return true;
+    }
+    return false;
+}
+
+LedPattern LedPatterns::off() {
+    LedPattern pattern = {LED_OFF, 0, 0, 0, 0};
+    return pattern;
+}
+
+LedPattern LedPatterns::on() {
+    LedPattern pattern = {LED_ON, 0, 0, 0, 0};
+    return pattern;
+}
+
+LedPattern LedPatterns::blink(const uint16_t period_ms, const uint16_t cycles) {
+    LedPattern pattern = {LED_BLINK, period_ms, static_cast<uint16_t>(period_ms / 2), 0, cycles};
+    return pattern;
+}
+
+LedPattern LedPatterns::breathe(const uint16_t period_ms, const uint16_t cycles) {
+    LedPattern pattern = {LED_BREATHE, period_ms, 0, 0, cycles};
+    return pattern;
+}
+
+LedPattern LedPatterns::chase(const uint index, const uint count, const uint16_t step_ms,
+                              const uint16_t cycles) {
+    uint16_t period_ms = static_cast<uint16_t>(count * step_ms);
+    // Shift the cycle so this LED's step comes after those of the LEDs before it
+    uint16_t phase_ms = static_cast<uint16_t>((count - index % count) % count * step_ms);
+    LedPattern pattern = {LED_BLINK, period_ms, step_ms, phase_ms, cycles};
+    return pattern;
+}
+
+int64_t LedPatterns::update(const uint64_t now_us) {
+    int64_t next_us = 0;
+    for (uint i = 0; i < number_of_leds; i++) {
+        int64_t led_next_us = update_led(leds[i], now_us);
+        if (led_next_us > 0 && (next_us == 0 || led_next_us < next_us)) {
+            next_us = led_next_us;
+        }
+    }
+    return next_us;
+}
+
+int64_t LedPatterns::update_led(Led &led, const uint64_t now_us) {
+    uint64_t period_us = 1000ull * led.pattern.period_ms;
+
+    // Move on to the follow-up pattern once the cycles are over
+    uint64_t end_us = 0;
+    if (led.pattern.cycles > 0 && period_us > 0) {
+        end_us = led.start_us + led.pattern.cycles * period_us;
+        if (now_us >= end_us) {
+            led.start_us = end_us;
+            led.pattern = led.then;
+            led.then = off();
+            return update_led(led, now_us);
+        }
+    }
+
+    uint16_t level = 0;
+    int64_t next_us = 0;
+
+    if (led.pattern.kind == LED_ON || 
+        (led.pattern.kind != LED_OFF && period_us == 0)) {
+        level = PWM_FULL;
+    } else if (led.pattern.kind == LED_BLINK) {
+        uint64_t on_us = 1000ull * led.pattern.on_ms;
+        uint64_t position = (now_us - led.start_us + 1000ull * led.pattern.phase_ms) % period_us;
+        if (position < on_us) {
+            level = PWM_FULL;
+            next_us = static_cast<int64_t>(on_us - position);
+        } else {
+            next_us = static_cast<int64_t>(period_us - position);
+        }
+    } else if (led.pattern.kind == LED_BREATHE) {
+        // Triangle wave, squared so the fade looks even to the eye
+        uint64_t half_us = period_us / 2;
+        uint64_t position = (now_us - led.start_us + 1000ull * led.pattern.phase_ms) % period_us;
+        uint64_t distance = (position < half_us) ? position : period_us - position;
+        uint32_t brightness = static_cast<uint32_t>((distance * PWM_WRAP) / (half_us ? half_us : 1));
+        level = static_cast<uint16_t>((brightness * brightness) / PWM_WRAP);
+        next_us = 1000 * BREATHE_TICK_MS;
+    }
+
+    pwm_set_gpio_level(led.pin, level);
+
+    // Wake up for the end of the cycles too
+    if (end_us > 0 && (next_us == 0 || static_cast<int64_t>(end_us - now_us) < next_us)) {
+        next_us = static_cast<int64_t>(end_us - now_us);
+    }
+    return next_us;
+}
+
+int64_t LedPatterns::on_alarm(alarm_id_t id, void *user_data) {
+    (void)id;
+    (void)user_data;
+    int64_t next_us = update(time_us_64());
+    if (next_us == 0) {
+        alarm = 0;
+    }
+    // Rescheduled next_us from now, or not at all if every LED is steady
+    return next_us;
+}
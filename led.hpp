@@ -0,0 +1,91 @@
+#ifndef __LED_HPP__
+#define __LED_HPP__
+
+#include "pico/stdlib.h"
+#include "pico/time.h"
+#include <stdint.h>
+
+// Kinds of LED patterns
+enum LedKind : uint8_t {
+    LED_OFF = 0,
+    LED_ON,
+    LED_BLINK,      // On for on_ms of every period_ms, shifted by phase_ms
+    LED_BREATHE,    // Fades in and out once every period_ms
+};
+
+// Struct describing what an LED shows, see the LedPatterns helpers
+// @field kind LedKind
+// @field period_ms Length of one cycle
+// @field on_ms Time the LED is on per cycle (LED_BLINK)
+// @field phase_ms Offset into the cycle at the start, e.g. for chases
+// @field cycles Cycles to show before switching to the next pattern, 0 for ever
+typedef struct {
+    uint8_t kind;
+    uint16_t period_ms;
+    uint16_t on_ms;
+    uint16_t phase_ms;
+    uint16_t cycles;
+} LedPattern;
+
+// Declarative LED pattern engine
+// Each LED runs on its RP2040 PWM slice, so brightness needs no CPU time.
+// A single alarm updates the levels only when a pattern changes them (a blink
+// edge, a chase step, a breathe tick) and is not armed at all while every LED
+// is steadily on or off. No core busy-waits or sleeps for the LEDs
+class LedPatterns {
+    public:
+        static const uint MAX_LEDS = 4;
+        static const uint32_t BREATHE_TICK_MS = 20;     // Fade step, 50 Hz
+
+        // Sets the pins up as PWM outputs, all off
+        // @param pins GPIOs of the LEDs
+        // @param count Number of LEDs, at most MAX_LEDS
+        static void init(const uint *pins, const uint count);
+
+        // Shows the pattern on the LED, restarting its cycle
+        // @param pin GPIO of the LED, one of those passed to init()
+        // @param pattern Pattern to show
+        // @param then Pattern shown once pattern.cycles have passed
+        // @return false if the pin isn't an LED
+        static bool show(const uint pin, const LedPattern &pattern,
+                         const LedPattern &then = off());
+
+        // Pattern helpers
+        static LedPattern off();
+        static LedPattern on();
+        static LedPattern blink(const uint16_t period_ms, const uint16_t cycles = 0);
+        static LedPattern breathe(const uint16_t period_ms, const uint16_t cycles = 0);
+
+        // One step of a chase over count LEDs: the LED at index lights up for
+        // step_ms after the ones before it, and the chase repeats
+        static LedPattern chase(const uint index, const uint count, const uint16_t step_ms,
+                                const uint16_t cycles = 0);
+
+    private:
+        static const uint16_t PWM_WRAP = 255;
+        static const uint16_t PWM_FULL = PWM_WRAP + 1;  // Above the wrap, always high
+
+        // Struct for storing the state of one LED
+        typedef struct {
+            uint pin;
+            LedPattern pattern;
+            LedPattern then;
+            uint64_t start_us;      // Start of the pattern's first cycle
+        } Led;
+
+        static Led leds[MAX_LEDS];
+        static uint number_of_leds;
+        static alarm_id_t alarm;
+
+        // Sets every LED's level for the time now
+        // @return Microseconds until a level changes next, 0 if none will
+        static int64_t update(const uint64_t now_us);
+
+        // Sets the LED's level and returns the time until it changes, 0 if never
+        static int64_t update_led(Led &led, const uint64_t now_us);
+
+        // Alarm callback, reschedules itself for the next change
+        static int64_t on_alarm(alarm_id_t id, void *user_data);
+};
+
+#endif  // __LED_HPP__
@@ -1,101 +1,326 @@
+#include "channel.hpp"
+#include "event_loop.hpp"
 #include "game.hpp"
+#include "gesture.hpp"
+#include "input.hpp"
+#include "output.hpp"
+#include "remote.hpp"
+#include "stats_store.hpp"
+#include "text.hpp"
+#include "trace.hpp"
 #include "hardware/gpio.h"
 #include "pico/stdio.h"
 
-int main() {
+// Engine for single-player mode, statically allocated with its transposition table
+static TicTacToe::AiEngine engine;
 
-    // Set the board values (3x3 board) to EMPTY
-    char board[Game::ROWS][Game::COLS] = {
-        {Game::EMPTY, Game::EMPTY, Game::EMPTY},
-        {Game::EMPTY, Game::EMPTY, Game::EMPTY},
-        {Game::EMPTY, Game::EMPTY, Game::EMPTY}
-    };
+// The game, statically allocated as its renderer's frame buffers don't fit
+// on core 0's 2 KB stack
+static TicTacToe game;
 
-    // Set current player to X
-    char current_player = Game::X;
+// Who the engine plays, chosen at power-up or by a remote client
+static RemoteMode mode = REMOTE_MODE_TWO_PLAYERS;
 
-    // Set current number of moves initialized to 0
-    uint moves = 0;
+#ifdef VERBOSE
+// Period of the idle report
+static const uint32_t IDLE_REPORT_PERIOD_MS = 10000;
 
-    bool is_game_over = false;
+// Prints the share of time a core spent asleep and how often it woke up
+static void print_idle(const uint core, const IdleStats &stats) {
+    TextBuffer<64> text;
+    uint64_t elapsed = time_us_64() - stats.since_us;
+    text.format("Core %u idle %u%% (%u wakeups)" TEXT_NEWLINE, core, 
+                static_cast<uint>((100 * stats.asleep_us) / (elapsed ? elapsed : 1)), 
+                static_cast<uint>(stats.wakeups));
+    text.write();
+}
 
-    // Set the array of structs of GPIO configuration
-    GpioConfig my_gpio[Game::NUMBER_OF_GPIOS] = {
-        {Game::LED1, GPIO_OUT}, 
-        {Game::LED2, GPIO_OUT}, 
-        {Game::BTN1, GPIO_IN}, 
-        {Game::BTN2, GPIO_IN}, 
-        {Game::BTN3, GPIO_IN}, 
-        {Game::ONBOARD_LED, GPIO_OUT}, 
-    };
+// Prints core 0's idle statistics, the channel and output counters and how
+// long after reset the first frame was drawn, and asks core 1 for its idle
+// statistics
+static void report_idle() {
+    print_idle(0, EventLoop::get_idle_stats(0));
 
-    // Struct for button 1 state
-    volatile BtnState btn1 = {
-        .but_pin = Game::BTN1,
-        .prev_state = false,
-        .curr_state = false
-    };
+    TextBuffer<512> text;
+    for (uint core = 0; core < EventLoop::NUMBER_OF_CORES; core++) {
+        ChannelStats stats = Channel::get_stats(core);
+        text.append("To core %u: %u sent, %u received, %u dropped, %u doorbells skipped" TEXT_NEWLINE, 
+                    core, static_cast<uint>(stats.sent), static_cast<uint>(stats.received), 
+                    static_cast<uint>(stats.dropped), static_cast<uint>(stats.doorbells_skipped));
+    }
+    text.append("Boot to first frame %u us" TEXT_NEWLINE, 
+                static_cast<uint>(game.get_render_stats().first_frame_us));
+    const StoreStats &store = StatsStore::get_store_stats();
+    text.append("Stats store: %u saves, %u sector erases, next slot %u" TEXT_NEWLINE, 
+                static_cast<uint>(store.saves), static_cast<uint>(store.erases), 
+                static_cast<uint>(store.slot));
+    OutputStats output = Output::get_stats();
+    text.append("Output: %u bytes queued, %u sent, %u dropped, %u frames coalesced, "
+                "%u overruns, high water %u" TEXT_NEWLINE, static_cast<uint>(output.written),
+                static_cast<uint>(output.drained), static_cast<uint>(output.dropped),
+                static_cast<uint>(output.coalesced), static_cast<uint>(output.overruns),
+                static_cast<uint>(output.high_water));
+    text.write();
+
+    // Core 1 replies with a consistent copy, printed when it arrives
+    Message request = {};
+    request.type = MSG_STATS_REQUEST;
+    Channel::send(request);
+}
+#endif
+
+// Sends a remote reply between the frames, through the output ring
+static void write_reply(const uint8_t *reply, size_t length) {
+    Output::write(reinterpret_cast<const char *>(reply), length);
+}
+
+#ifdef TRACE
+// Sends a part of the trace dump over USB, waiting for room in the output ring
+static void write_trace(const uint8_t *data, size_t length) {
+    Output::write_all(reinterpret_cast<const char *>(data), length);
+}
+#endif
+
+// Returns true while button events or messages from core 1 are waiting
+static bool has_work() {
+    return Input::has_events() || Channel::has_messages();
+}
+
+// Acts on a button gesture
+static void handle_gesture(const Gesture &gesture, TicTacToe::State *state) {
+    GameEvent event = GameMachine::get_gesture_event(gesture);
+    if (event != GAME_EVENT_NONE) {
+        game.dispatch(state, event);
+    }
+}
+
+// Acts on a request of a remote client and replies with the game state
+// The moves go through the state machine like button presses, so they are
+// drawn, recorded and answered by the engine the same way
+static void handle_request(const RemoteRequest &request, TicTacToe::State *state) {
+    RemoteReply reply = {};
+    reply.sequence = request.sequence;
+    reply.command = request.command;
+    reply.status = REMOTE_OK;
+    uint8_t placed = 0;
+
+    switch (request.command) {
+        case REMOTE_PLACE:
+            // Up to the first move that can't be placed
+            for (uint i = 0; i < request.length && reply.status == REMOTE_OK; i++) {
+                uint cell = request.arguments[i];
+                if (state->phase == GAME_PHASE_WON) {
+                    reply.status = REMOTE_GAME_OVER;
+                } else if (cell >= TicTacToe::CELLS) {
+                    reply.status = REMOTE_BAD_ARGUMENT;
+                } else if (!game.is_empty_pos(game.get_curr_row(cell), game.get_curr_col(cell), 
+                                              state->board)) {
+                    reply.status = REMOTE_OCCUPIED;
+                } else {
+                    state->cursor = static_cast<uint8_t>(cell);
+                    game.dispatch(state, GAME_EVENT_PLACE);
+                    placed++;
+                }
+            }
+            break;
+
+        case REMOTE_RESET:
+            game.dispatch(state, GAME_EVENT_RESET_CONFIRMED);
+            break;
+
+        case REMOTE_QUERY_STATE:
+            break;
+
+        case REMOTE_SET_MODE:
+            if (request.length != 1 || request.arguments[0] >= NUMBER_OF_REMOTE_MODES) {
+                reply.status = REMOTE_BAD_ARGUMENT;
+                break;
+            }
+            mode = static_cast<RemoteMode>(request.arguments[0]);
+            game.set_engine((mode == REMOTE_MODE_TWO_PLAYERS) ? nullptr : &engine, 
+                            (mode == REMOTE_MODE_ENGINE_X) ? TicTacToe::X : TicTacToe::O);
+            game.dispatch(state, GAME_EVENT_RESET_CONFIRMED);
+            break;
+
+        case REMOTE_RUN_BENCHMARK: {
+            uint iterations = (request.length == 2) ? 
+                              request.arguments[0] | (request.arguments[1] << 8) : 0;
+            if (iterations == 0 || iterations > Remote::MAX_BENCHMARK_ITERATIONS) {
+                reply.status = REMOTE_BAD_ARGUMENT;
+                break;
+            }
+            // The win check of both players on the current board, bounded so
+            // the buttons wait at most a few milliseconds
+            volatile uint wins = 0;
+            uint64_t start = time_us_64();
+            for (uint i = 0; i < iterations; i++) {
+                wins = wins + game.is_win(TicTacToe::X, state->board) + 
+                       game.is_win(TicTacToe::O, state->board);
+            }
+            uint32_t elapsed_us = static_cast<uint32_t>(time_us_64() - start);
+            reply.data[0] = static_cast<uint8_t>(iterations);
+            reply.data[1] = static_cast<uint8_t>(iterations >> 8);
+            for (uint i = 0; i < 4; i++) {
+                reply.data[2 + i] = static_cast<uint8_t>(elapsed_us >> (8 * i));
+            }
+            reply.length = 6;
+            Remote::send(reply);
+            return;
+        }
+
+        default:
+            reply.status = REMOTE_UNKNOWN_COMMAND;
+            break;
+    }
+
+    RemoteState remote;
+    remote.rows = TicTacToe::ROWS;
+    remote.cols = TicTacToe::COLS;
+    remote.win_length = TicTacToe::WIN_LENGTH;
+    remote.mode = mode;
+    remote.is_game_over = (state->phase == GAME_PHASE_WON);
+    remote.current_player = state->player;
+    remote.cursor = state->cursor;
+    remote.placed = placed;
+    remote.game_number = game.get_game_number();
+    remote.x = state->board.x;
+    remote.o = state->board.o;
+    Remote::encode_state(remote, &reply);
+    Remote::send(reply);
+}
 
-    // Struct for button 2 state
-    volatile BtnState btn2 = {
-        .but_pin = Game::BTN2,
-        .prev_state = false,
-        .curr_state = false
-    };   
+int main() {
 
-    // Struct for button 3 state
-    volatile BtnState btn3 = {
-        .but_pin = Game::BTN3,
-        .prev_state = false,
-        .curr_state = false
-    }; 
+    // The board (one bitboard per player), cursor, player to move and
+    // phase, set up by the first reset
+    TicTacToe::State state = {};
 
-    // Create an instance of the Game class
-    Game game; 
+    // Set the array of structs of GPIO configuration
+    GpioConfig my_gpio[TicTacToe::NUMBER_OF_GPIOS] = {
+        {TicTacToe::LED1, GPIO_OUT}, 
+        {TicTacToe::LED2, GPIO_OUT}, 
+        {TicTacToe::BTN1, GPIO_IN}, 
+        {TicTacToe::BTN2, GPIO_IN}, 
+        {TicTacToe::BTN3, GPIO_IN}, 
+        {TicTacToe::ONBOARD_LED, GPIO_OUT}, 
+    };
+
+    // Button pins in the order of the Input event indexes
+    const uint buttons[Input::NUMBER_OF_BUTTONS] = {
+        TicTacToe::BTN1,
+        TicTacToe::BTN2,
+        TicTacToe::BTN3
+    };
 
     // Initialize the standard input/output library
     stdio_init_all();   
+    Remote::set_reply_sink(write_reply);
+
+    // Start this core's cycle counter for the trace points
+    Trace::init_core();
+
+    // Load the statistics before core 1 runs, reading the flash needs no parking
+    StatsStore::init();
 
     // Run code on core1 
-    multicore_launch_core1(Game::flash_winner_led); 
+    multicore_launch_core1(TicTacToe::run_worker); 
+
+    // Wake core 0 when core 1 replies
+    Channel::enable_doorbell_irq();
 
     game.init_gpio(my_gpio);
+
+    // Holding btn1 (active-low) at power-up selects single-player mode,
+    // in which the engine plays O against the human X
+    if (!gpio_get(TicTacToe::BTN1)) {
+        mode = REMOTE_MODE_ENGINE_O;
+        game.set_engine(&engine, TicTacToe::O);
+    }
     
-    game.reset_board(&current_player, &moves, board, &is_game_over);
+    game.dispatch(&state, GAME_EVENT_RESET_CONFIRMED);
+    game.show_stats(StatsStore::get_stats());
+
+    // Start interrupt-driven, non-blocking debouncing of the buttons
+    Input::init(buttons, TicTacToe::DEBOUNCE_DELAY);
+
+    // Core 0 sleeps between inputs, woken by the button, alarm and USB IRQs
+    EventLoop loop;
+    EventLoop::reset_idle_stats();
+
+    #ifdef VERBOSE
+        loop.add_timer(IDLE_REPORT_PERIOD_MS, report_idle);
+    #endif
 
     while (true) {
-        // Update player status led if game is not over
-        if (!is_game_over) {
-            game.update_player_led(current_player);
-
-            // Pull-down, active-low for btn1
-            if (!gpio_get(Game::BTN1)) {
-                // Check and handle button 1 press event
-                game.update_btn_state(&btn1);
-                if (game.debounce(btn1)) {
-                    game.handle_btn1(&moves);
-                }
-            }
-            
-            // Pull-down, active-low for btn2
-            if (!gpio_get(Game::BTN2)) {
-                // Check and handle button 2 press event
-                game.update_btn_state(&btn2);
-                if (game.debounce(btn2)) {
-                    game.handle_btn2(&current_player, &moves, board, &is_game_over);
-                }
+        // Handle the debounced button events queued by the GPIO and alarm IRQs
+        BtnEvent event;
+        Gesture gesture;
+        while (Input::pop_event(&event)) {
+            // Presses make gestures straight away, releases end them or tap
+            if (!Gestures::feed(event, &gesture)) {
+                continue;
             }
+            handle_gesture(gesture, &state);
+
+            // Measure the time from the physical press to the updated board
+            Input::record_latency(event);
+
+            #ifdef VERBOSE
+                const LatencyStats &latency = Input::get_latency_stats();
+                TextBuffer<64> text;
+                text.format("Press latency %u us (max %u us, avg %u us)" TEXT_NEWLINE, 
+                            static_cast<uint>(latency.last_us), static_cast<uint>(latency.max_us), 
+                            static_cast<uint>(latency.total_us / latency.count));
+                text.write();
+            #endif
         }
 
-        // Pull-down, active-low for btn3
-        if (!gpio_get(Game::BTN3)) {
-            // Check and handle button 3 press event 
-            game.update_btn_state(&btn3);
-            if (game.debounce(btn3)) {
-                game.reset_board(&current_player, &moves, board, &is_game_over);
+        // Requests of remote clients over USB, a byte at a time as far as
+        // they have arrived
+        int input = 0;
+        while ((input = getchar_timeout_us(0)) != PICO_ERROR_TIMEOUT) {
+            RemoteRequest request;
+            RemoteInput parsed = Remote::feed(static_cast<uint8_t>(input), time_us_64(), &request);
+            if (parsed == REMOTE_INPUT_REQUEST) {
+                handle_request(request, &state);
+            } else if (parsed == REMOTE_INPUT_CORRUPT) {
+                RemoteReply reply = {};
+                reply.sequence = request.sequence;
+                reply.command = request.command;
+                reply.status = REMOTE_BAD_FRAME;
+                Remote::send(reply);
             }
+            #ifdef TRACE
+                // 't' outside a frame dumps the trace data, then the screen
+                // is repainted over the binary
+                if (parsed == REMOTE_INPUT_BYTE && input == Trace::COMMAND) {
+                    Trace::dump(write_trace);
+                    game.redraw();
+                }
+            #endif
+        }
+
+        // Long presses and auto-repeats of held buttons
+        while (Gestures::poll(&gesture)) {
+            handle_gesture(gesture, &state);
+        }
+
+        // Handle the replies of core 1
+        Message message;
+        while (Channel::receive(&message)) {
+            #ifdef VERBOSE
+                if (message.type == MSG_STATS) {
+                    print_idle(1, message.stats);
+                }
+            #endif
         }
 
+        // Run due timers, then sleep until the next one or the next interrupt
+        absolute_time_t next_timer = loop.run_timers();
+        // Save the statistics once a finished game has settled
+        next_timer = StatsStore::save_if_due(next_timer);
+        next_timer = Gestures::next_deadline(next_timer);
+        EventLoop::sleep_until_irq(next_timer, has_work);
     }
 
     return 0;
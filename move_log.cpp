@@ -0,0 +1,164 @@
+#include "move_log.hpp"
+#include <cassert>
+#include <cstring>
+
+uint GameRecords::get_move_bits(const uint cells) {
+    return (cells < 15) ? 4 : 8;
+}
+
+uint8_t GameRecords::crc8(const uint8_t *data, const size_t length, uint8_t crc) {
+    for (size_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (uint bit = 0; bit < 8; bit++) {
+            crc = static_cast<uint8_t>((crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1);
+        }
+    }
+    return crc;
+}
+
+size_t GameRecords::encode(const GameRecord &record, uint8_t *data) {
+    uint bits = get_move_bits(record.rows * record.cols);
+    size_t moves_size = (bits == 4) ? (record.count + 1u) / 2 : record.count;
+
+    data[0] = SYNC1;
+    data[1] = SYNC2;
+    data[2] = static_cast<uint8_t>(PAYLOAD_HEADER_SIZE + moves_size);
+
+    uint8_t *payload = data + HEADER_SIZE;
+    payload[0] = VERSION;
+    payload[1] = static_cast<uint8_t>((record.rows << 4) | record.cols);
+    payload[2] = record.win_length;
+    payload[3] = record.result;
+    payload[4] = static_cast<uint8_t>(record.game_number);
+    payload[5] = static_cast<uint8_t>(record.game_number >> 8);
+    payload[6] = record.count;
+
+    uint8_t *moves = payload + PAYLOAD_HEADER_SIZE;
+    memset(moves, 0, moves_size);
+    for (uint i = 0; i < record.count; i++) {
+        if (bits == 4) {
+            moves[i / 2] |= static_cast<uint8_t>(record.cells[i] << (4 * (i % 2)));
+        } else {
+            moves[i] = record.cells[i];
+        }
+    }
+
+    // The CRC covers the length and the payload
+    size_t length = HEADER_SIZE + data[2];
+    data[length] = crc8(data + 2, 1 + data[2]);
+    return length + 1;
+}
+
+int GameRecords::decode(const uint8_t *data, const size_t length, GameRecord *record,
+                        size_t *used) {
+    // Find the sync bytes
+    size_t start = 0;
+    while (start + 1 < length && !(data[start] == SYNC1 && data[start + 1] == SYNC2)) {
+        start++;
+    }
+    if (start + HEADER_SIZE > length || start + HEADER_SIZE + data[start + 2] + 1 > length) {
+        // Keep the start of a record that may be completed by more data
+        *used = start;
+        return 0;
+    }
+
+    const uint8_t *payload = data + start + HEADER_SIZE;
+    size_t payload_size = data[start + 2];
+    if (crc8(data + start + 2, 1 + payload_size) != payload[payload_size] ||
+        payload_size < PAYLOAD_HEADER_SIZE || payload[0] != VERSION) {
+        // Not a record after all, search again after the sync bytes
+        *used = start + 2;
+        return -1;
+    }
+
+    record->rows = payload[1] >> 4;
+    record->cols = payload[1] & 0x0f;
+    record->win_length = payload[2];
+    record->result = static_cast<GameResult>(payload[3]);
+    record->game_number = static_cast<uint16_t>(payload[4] | (payload[5] << 8));
+    record->count = payload[6];
+
+    uint cells = record->rows * record->cols;
+    uint bits = get_move_bits(cells);
+    size_t moves_size = (bits == 4) ? (record->count + 1u) / 2 : record->count;
+    if (record->count > cells || record->count > sizeof(record->cells) ||
+        PAYLOAD_HEADER_SIZE + moves_size != payload_size || record->result > RESULT_ABANDONED) {
+        *used = start + 2;
+        return -1;
+    }
+
+    const uint8_t *moves = payload + PAYLOAD_HEADER_SIZE;
+    for (uint i = 0; i < record->count; i++) {
+        record->cells[i] = (bits == 4) ? (moves[i / 2] >> (4 * (i % 2))) & 0x0f : moves[i];
+    }
+
+    *used = start + HEADER_SIZE + payload_size + 1;
+    return 1;
+}
+
+template <uint Cells>
+MoveLog<Cells>::MoveLog() : head(0), game_start(0) {
+    memset(data, 0, sizeof(data));
+}
+
+template <uint Cells>
+void MoveLog<Cells>::write(const uint32_t index, const uint value) {
+    uint32_t slot = index % CAPACITY;
+    if (MOVE_BITS == 4) {
+        uint shift = 4 * (slot % 2);
+        data[slot / 2] = static_cast<uint8_t>((data[slot / 2] & ~(0x0f << shift)) | (value << shift));
+    } else {
+        data[slot] = static_cast<uint8_t>(value);
+    }
+}
+
+template <uint Cells>
+uint MoveLog<Cells>::read(const uint32_t index) {
+    uint32_t slot = index % CAPACITY;
+    if (MOVE_BITS == 4) {
+        return (data[slot / 2] >> (4 * (slot % 2))) & 0x0f;
+    }
+    return data[slot];
+}
+
+template <uint Cells>
+void MoveLog<Cells>::start_game() {
+    write(head++, MARKER);
+    game_start = head;
+}
+
+template <uint Cells>
+void MoveLog<Cells>::push(const uint cell) {
+    // No game has more moves than cells, the caller must start a new one
+    assert(get_count() < Cells);
+    write(head++, cell);
+}
+
+template <uint Cells>
+bool MoveLog<Cells>::pop(uint *cell) {
+    if (head == game_start) {
+        return false;
+    }
+    *cell = read(--head);
+    return true;
+}
+
+template <uint Cells>
+uint MoveLog<Cells>::get_count() {
+    return head - game_start;
+}
+
+template <uint Cells>
+uint MoveLog<Cells>::get_moves(uint8_t *cells) {
+    uint count = get_count();
+    for (uint i = 0; i < count; i++) {
+        cells[i] = static_cast<uint8_t>(read(game_start + i));
+    }
+    return count;
+}
+
+// Supported board variants, see game.cpp
+template class MoveLog<9>;
+template class MoveLog<16>;
+template class MoveLog<25>;
+template class MoveLog<49>;
@@ -0,0 +1,129 @@
+#ifndef __MOVE_LOG_HPP__
+#define __MOVE_LOG_HPP__
+
+#include "pico/stdlib.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// How a recorded game ended
+enum GameResult : uint8_t {
+    RESULT_TIE = 0,
+    RESULT_X_WIN,
+    RESULT_O_WIN,
+    RESULT_ABANDONED    // Reset before it was decided
+};
+
+// Struct for storing a complete game, as sent in a record
+// @field rows Number of board rows
+// @field cols Number of board columns
+// @field win_length Marks in a row needed to win
+// @field result How the game ended
+// @field game_number Number of the game since power-up, wrapping at 65536
+// @field count Number of moves
+// @field cells The cells played in turn, starting with X
+typedef struct {
+    uint8_t rows;
+    uint8_t cols;
+    uint8_t win_length;
+    GameResult result;
+    uint16_t game_number;
+    uint8_t count;
+    uint8_t cells[64];
+} GameRecord;
+
+// Binary records of complete games, streamed over USB stdio
+// A record is 2 sync bytes, the payload length, the payload and a CRC-8 of
+// the length and payload:
+//   A5 5A | length | version, rows << 4 | cols, K, result, game number (LE 16),
+//   count, moves | CRC-8
+// The moves are packed like in the MoveLog, two to a byte (low nibble first)
+// on the 3x3 board and a byte each on larger ones, so a 3x3 game takes at
+// most 17 bytes. The sync bytes are never sent by the renderer, whose
+// output is ASCII, so a reader finds the records in the captured terminal
+// stream.
+class GameRecords {
+    public:
+        static const uint8_t SYNC1 = 0xa5;
+        static const uint8_t SYNC2 = 0x5a;
+        static const uint8_t VERSION = 1;
+        static const size_t HEADER_SIZE = 3;    // Sync bytes and length
+        static const size_t PAYLOAD_HEADER_SIZE = 7;
+        static const size_t MAX_RECORD_SIZE = HEADER_SIZE + PAYLOAD_HEADER_SIZE + 64 + 1;
+
+        // Function that sends out an encoded record
+        typedef void (*Sink)(const uint8_t *record, size_t length);
+
+        // Returns the bits a move takes on a board of that many cells: 4 if
+        // the cell numbers and the marker fit into a nibble, else 8
+        static uint get_move_bits(const uint cells);
+
+        // Encodes the game into a record
+        // @param record The game
+        // @param data Buffer of at least MAX_RECORD_SIZE bytes
+        // @return Length of the record in bytes
+        static size_t encode(const GameRecord &record, uint8_t *data);
+
+        // Decodes the first record in data, skipping anything before its sync bytes
+        // @param data Bytes to search, e.g. a capture of the USB serial port
+        // @param length Number of bytes in data
+        // @param record Set to the decoded game
+        // @param used Set to the number of bytes up to the end of the record,
+        //        or up to where the search stopped
+        // @return 1 if a record was decoded, 0 if there is none (or only the
+        //         start of one), -1 if one was found but failed its CRC or checks
+        static int decode(const uint8_t *data, const size_t length, GameRecord *record,
+                          size_t *used);
+
+        // Returns the CRC-8 (polynomial 0x07) of the bytes
+        // @param crc CRC of the bytes before these, to continue it
+        static uint8_t crc8(const uint8_t *data, const size_t length, uint8_t crc = 0);
+};
+
+// Fixed-capacity ring of the moves of the recent games
+// Each move is stored as its cell number in GameRecords::get_move_bits()
+// bits, and a game boundary as the all-ones marker. When the ring is full
+// the oldest entries are overwritten, but the game in progress always fits
+template <uint Cells>
+class MoveLog {
+    public:
+        static const size_t CAPACITY_BYTES = 128;
+        static const uint MOVE_BITS = (Cells < 15) ? 4 : 8;
+        static const uint MARKER = (1u << MOVE_BITS) - 1;
+        static const uint32_t CAPACITY = CAPACITY_BYTES * 8 / MOVE_BITS;
+
+        static_assert(Cells < MARKER, "Cell numbers must not collide with the marker");
+        static_assert(Cells < CAPACITY, "A whole game must fit");
+
+        // Constructor
+        MoveLog();
+
+        // Marks the start of a new game
+        void start_game();
+
+        // Appends a move of the game in progress
+        void push(const uint cell);
+
+        // Removes the last move of the game in progress, for undo
+        // @param cell Set to the cell of the removed move
+        // @return false if the game has no moves
+        bool pop(uint *cell);
+
+        // Returns the number of moves of the game in progress
+        uint get_count();
+
+        // Copies the moves of the game in progress, oldest first
+        // @param cells Buffer of at least Cells entries
+        // @return Number of moves
+        uint get_moves(uint8_t *cells);
+
+    private:
+        uint8_t data[CAPACITY_BYTES];
+        // Number of entries ever written, and where the game in progress starts
+        uint32_t head;
+        uint32_t game_start;
+
+        void write(const uint32_t index, const uint value);
+        uint read(const uint32_t index);
+};
+
+#endif  // __MOVE_LOG_HPP__
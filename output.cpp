@@ -0,0 +1,160 @@
+#include "output.hpp"
+#include "hardware/sync.h"
+#include "pico/platform.h"
+#include <cstdio>
+#include <cstring>
+
+// Bytes core 1 copies out of the ring per sink call
+static const uint32_t CHUNK_SIZE = 256;
+
+// Default sink: the USB stdio write, which may block, flushed once per drain
+static void write_stdout(const char *data, size_t length) {
+    fwrite(data, 1, length, stdout);
+}
+
+char Output::ring[RING_SIZE];
+std::atomic<uint32_t> Output::head(0);
+std::atomic<uint32_t> Output::tail(0);
+std::atomic<uint32_t> Output::reserved(0);
+std::atomic<bool> Output::is_draining(false);
+OutputPolicy Output::policy = static_cast<OutputPolicy>(OUTPUT_POLICY);
+Output::Sink Output::sink = write_stdout;
+
+volatile uint32_t Output::written = 0;
+volatile uint32_t Output::refused = 0;
+volatile uint32_t Output::coalesced = 0;
+volatile uint32_t Output::high_water = 0;
+uint32_t Output::overruns_seen = 0;
+volatile uint32_t Output::drained = 0;
+volatile uint32_t Output::overwritten = 0;
+volatile uint32_t Output::overruns = 0;
+
+bool Output::write(const char *data, const size_t length, const bool is_frame) {
+    if (!is_draining.load(std::memory_order_acquire)) {
+        sink(data, length);
+        if (sink == write_stdout) {
+            fflush(stdout);
+        }
+        return true;
+    }
+
+    const uint32_t start = head.load(std::memory_order_relaxed);
+    const uint32_t waiting = start - tail.load(std::memory_order_acquire);
+    if (length > RING_SIZE || (policy == OUTPUT_COALESCE && waiting + length > RING_SIZE)) {
+        if (is_frame) {
+            coalesced++;
+        } else {
+            refused += static_cast<uint32_t>(length);
+        }
+        return false;
+    }
+
+    // Reserve the bytes before they are overwritten, so core 1 can tell
+    // that a copy it made of the unsent bytes there may be torn
+    reserved.store(start + static_cast<uint32_t>(length), std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    // At most two copies, around the end of the ring
+    const uint32_t at = start & (RING_SIZE - 1);
+    const size_t first = (length < RING_SIZE - at) ? length : RING_SIZE - at;
+    memcpy(&ring[at], data, first);
+    memcpy(ring, data + first, length - first);
+
+    // Publish the bytes, then wake core 1 from WFE
+    head.store(start + static_cast<uint32_t>(length), std::memory_order_release);
+    __sev();
+
+    written += static_cast<uint32_t>(length);
+    const uint32_t level = waiting + static_cast<uint32_t>(length);
+    if (level > high_water) {
+        high_water = (level < RING_SIZE) ? level : RING_SIZE;
+    }
+    return true;
+}
+
+void Output::write_all(const char *data, size_t length) {
+    while (length > 0) {
+        // The same pieces fit under either policy once core 1 has caught up
+        size_t piece = (length < RING_SIZE / 2) ? length : RING_SIZE / 2;
+        if (is_draining.load(std::memory_order_acquire) &&
+            head.load(std::memory_order_relaxed) - tail.load(std::memory_order_acquire) + piece >
+                RING_SIZE) {
+            tight_loop_contents();
+            continue;
+        }
+        write(data, piece);
+        data += piece;
+        length -= piece;
+    }
+}
+
+void Output::drain() {
+    char chunk[CHUNK_SIZE];
+    uint32_t start = tail.load(std::memory_order_relaxed);
+    bool is_sent = false;
+
+    while (true) {
+        const uint32_t end = head.load(std::memory_order_acquire);
+        // Reserved past the unsent bytes: core 0 went round the ring and is
+        // overwriting them, or has
+        const uint32_t limit = reserved.load(std::memory_order_relaxed);
+        if (limit - start > RING_SIZE) {
+            overwritten += limit - RING_SIZE - start;
+            overruns++;
+            start = limit - RING_SIZE;
+        }
+        if (start == end) {
+            break;
+        }
+
+        uint32_t length = (end - start < CHUNK_SIZE) ? end - start : CHUNK_SIZE;
+        for (uint32_t i = 0; i < length; i++) {
+            chunk[i] = ring[(start + i) & (RING_SIZE - 1)];
+        }
+
+        // Bytes reserved by a write during the copy may be torn, check the
+        // reservation again before trusting it. The copy's first byte is
+        // the first a write overwrites
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (reserved.load(std::memory_order_relaxed) - start > RING_SIZE) {
+            continue;
+        }
+
+        start += length;
+        tail.store(start, std::memory_order_release);
+        sink(chunk, length);
+        drained += length;
+        is_sent = true;
+    }
+
+    if (is_sent && sink == write_stdout) {
+        fflush(stdout);
+    }
+}
+
+void Output::start_draining() {
+    is_draining.store(true, std::memory_order_release);
+}
+
+bool Output::take_overrun() {
+    uint32_t now = overruns;
+    if (now == overruns_seen) {
+        return false;
+    }
+    overruns_seen = now;
+    return true;
+}
+
+void Output::set_policy(const OutputPolicy policy) {
+    Output::policy = policy;
+}
+
+void Output::set_sink(Sink sink) {
+    Output::sink = (sink != nullptr) ? sink : write_stdout;
+}
+
+OutputStats Output::get_stats() {
+    OutputStats stats = {written, drained, refused + overwritten, coalesced, overruns,
+                         high_water};
+    return stats;
+}
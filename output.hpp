@@ -0,0 +1,122 @@
+#ifndef __OUTPUT_HPP__
+#define __OUTPUT_HPP__
+
+#include "pico/stdlib.h"
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+// Bytes of console output buffered for core 1, a power of two holding at
+// least two full frames of the renderer
+#ifndef OUTPUT_RING_SIZE
+#define OUTPUT_RING_SIZE 4096
+#endif
+
+// OutputPolicy at power-up: 0 coalesces frames, 1 drops the oldest bytes
+#ifndef OUTPUT_POLICY
+#define OUTPUT_POLICY 0
+#endif
+
+// What a write does when the ring has no room for it
+enum OutputPolicy : uint8_t {
+    // The write is refused. The renderer then keeps the frame unshown, so
+    // its next frame carries the changes of both: frames coalesce into the
+    // latest one. Other writes are dropped whole
+    OUTPUT_COALESCE = 0,
+    // The write always goes in, over the oldest bytes not yet sent. The
+    // terminal may see the end of a cut frame, then the renderer repaints,
+    // but never bytes of two writes mixed up
+    OUTPUT_DROP_OLDEST
+};
+
+// Struct for storing the output statistics
+// @field written Bytes queued by writes
+// @field drained Bytes sent by core 1
+// @field dropped Bytes lost: refused writes other than frames, or with
+//        OUTPUT_DROP_OLDEST, bytes overwritten before they were sent
+// @field coalesced Frames refused under OUTPUT_COALESCE, shown by a later one
+// @field overruns Number of times core 1 found bytes overwritten
+// @field high_water Most bytes waiting at once
+typedef struct {
+    uint32_t written;
+    uint32_t drained;
+    uint32_t dropped;
+    uint32_t coalesced;
+    uint32_t overruns;
+    uint32_t high_water;
+} OutputStats;
+
+// Console output that never blocks the game loop
+// Core 0 copies its frames, records and replies into a lock-free ring in
+// shared SRAM and raises an event; core 1 wakes from WFE and does the
+// blocking USB stdio writes. A write costs a copy of its bytes whether a
+// terminal is attached, slow or gone. Until core 1 starts draining, and in
+// programs without it, writes go straight to stdout
+class Output {
+    public:
+        static const uint32_t RING_SIZE = OUTPUT_RING_SIZE;
+
+        static_assert((RING_SIZE & (RING_SIZE - 1)) == 0, "The ring size must be a power of two");
+
+        // Function that sends drained bytes, e.g. a null sink for benchmarks
+        typedef void (*Sink)(const char *data, size_t length);
+
+        // Queues the bytes, on core 0
+        // @param is_frame Whether the bytes are a renderer frame, which can be coalesced
+        // @return false if the ring had no room under OUTPUT_COALESCE and
+        //         nothing was queued
+        static bool write(const char *data, const size_t length, const bool is_frame = false);
+
+        // Queues all the bytes, waiting for core 1 to make room, for output
+        // larger than the ring off the move path (e.g. the trace dump)
+        static void write_all(const char *data, size_t length);
+
+        // Sends the queued bytes to the sink, on core 1 (or the one consumer)
+        static void drain();
+
+        // Called by core 1 before its first drain: from then on writes are queued
+        static void start_draining();
+
+        // Returns true once if bytes were overwritten before they were sent
+        // since the last call, so the renderer repaints the whole screen
+        static bool take_overrun();
+
+        // Sets the overflow policy
+        static void set_policy(const OutputPolicy policy);
+
+        // Sets where drained bytes go, nullptr for stdout
+        static void set_sink(Sink sink);
+
+        // Returns the output statistics
+        static OutputStats get_stats();
+
+    private:
+        static char ring[RING_SIZE];
+
+        // Bytes ever queued and ever sent; the ring holds head - tail bytes
+        static std::atomic<uint32_t> head;
+        static std::atomic<uint32_t> tail;
+
+        // End of the bytes core 0 has started to copy, moved before the copy
+        // and head after it. Like a seqlock's sequence, core 1 checks it after
+        // copying bytes out: any byte it may have overwritten is not sent
+        static std::atomic<uint32_t> reserved;
+
+        static std::atomic<bool> is_draining;
+        static OutputPolicy policy;
+        static Sink sink;
+
+        // Written by core 0 only
+        static volatile uint32_t written;
+        static volatile uint32_t refused;
+        static volatile uint32_t coalesced;
+        static volatile uint32_t high_water;
+        static uint32_t overruns_seen;
+
+        // Written by core 1 only
+        static volatile uint32_t drained;
+        static volatile uint32_t overwritten;
+        static volatile uint32_t overruns;
+};
+
+#endif  // __OUTPUT_HPP__
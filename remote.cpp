@@ -0,0 +1,236 @@
+#include "remote.hpp"
+#include "move_log.hpp"
+#include <stdio.h>
+#include <string.h>
+
+static const char *COMMAND_NAMES[NUMBER_OF_REMOTE_COMMANDS] = {
+    "?",
+    "place",
+    "reset",
+    "state",
+    "mode",
+    "bench",
+};
+
+static const char *STATUS_NAMES[NUMBER_OF_REMOTE_STATUSES] = {
+    "ok",
+    "bad frame",
+    "unknown command",
+    "bad argument",
+    "occupied",
+    "game over",
+};
+
+static const char *MODE_NAMES[NUMBER_OF_REMOTE_MODES] = {
+    "two players",
+    "engine plays O",
+    "engine plays X",
+};
+
+// Default reply sink: the reply goes out between the frames, like a record
+static void write_reply(const uint8_t *reply, size_t length) {
+    fwrite(reply, 1, length, stdout);
+    fflush(stdout);
+}
+
+Remote::Sink Remote::sink = write_reply;
+uint8_t Remote::state = PARSER_SYNC1;
+uint8_t Remote::length = 0;
+uint8_t Remote::received = 0;
+uint8_t Remote::payload[REQUEST_HEADER_SIZE + 64];
+uint64_t Remote::last_us = 0;
+
+void Remote::set_reply_sink(Sink sink) {
+    Remote::sink = (sink != nullptr) ? sink : write_reply;
+}
+
+RemoteInput Remote::feed(const uint8_t byte, const uint64_t now_us, RemoteRequest *request) {
+    // A client that stopped mid-frame doesn't swallow what comes next
+    if (state != PARSER_SYNC1 && now_us - last_us > FRAME_TIMEOUT_US) {
+        state = PARSER_SYNC1;
+    }
+    last_us = now_us;
+
+    switch (state) {
+        case PARSER_SYNC1:
+            if (byte == REQUEST_SYNC1) {
+                state = PARSER_SYNC2;
+                return REMOTE_INPUT_NONE;
+            }
+            return REMOTE_INPUT_BYTE;
+
+        case PARSER_SYNC2:
+            if (byte == REQUEST_SYNC2) {
+                state = PARSER_LENGTH;
+                return REMOTE_INPUT_NONE;
+            }
+            // Not a frame after all, the first sync byte is dropped
+            state = (byte == REQUEST_SYNC1) ? PARSER_SYNC2 : PARSER_SYNC1;
+            return (state == PARSER_SYNC1) ? REMOTE_INPUT_BYTE : REMOTE_INPUT_NONE;
+
+        case PARSER_LENGTH:
+            if (byte < REQUEST_HEADER_SIZE || byte > sizeof(payload)) {
+                state = PARSER_SYNC1;
+                return REMOTE_INPUT_NONE;
+            }
+            length = byte;
+            received = 0;
+            state = PARSER_PAYLOAD;
+            return REMOTE_INPUT_NONE;
+
+        case PARSER_PAYLOAD:
+            payload[received++] = byte;
+            if (received == length) {
+                state = PARSER_CRC;
+            }
+            return REMOTE_INPUT_NONE;
+
+        default: {
+            state = PARSER_SYNC1;
+            uint8_t crc = GameRecords::crc8(&length, 1);
+            crc = GameRecords::crc8(payload, length, crc);
+            request->sequence = payload[0];
+            request->command = payload[1];
+            if (crc != byte) {
+                request->length = 0;
+                return REMOTE_INPUT_CORRUPT;
+            }
+            request->length = static_cast<uint8_t>(length - REQUEST_HEADER_SIZE);
+            memcpy(request->arguments, payload + REQUEST_HEADER_SIZE, request->length);
+            return REMOTE_INPUT_REQUEST;
+        }
+    }
+}
+
+void Remote::send(const RemoteReply &reply) {
+    uint8_t data[MAX_REPLY_SIZE];
+    sink(data, encode_reply(reply, data));
+}
+
+size_t Remote::encode_request(const RemoteRequest &request, uint8_t *data) {
+    data[0] = REQUEST_SYNC1;
+    data[1] = REQUEST_SYNC2;
+    data[2] = static_cast<uint8_t>(REQUEST_HEADER_SIZE + request.length);
+    data[3] = request.sequence;
+    data[4] = request.command;
+    memcpy(data + HEADER_SIZE + REQUEST_HEADER_SIZE, request.arguments, request.length);
+
+    size_t length = HEADER_SIZE + data[2];
+    data[length] = GameRecords::crc8(data + 2, 1 + data[2]);
+    return length + 1;
+}
+
+size_t Remote::encode_reply(const RemoteReply &reply, uint8_t *data) {
+    data[0] = REPLY_SYNC1;
+    data[1] = REPLY_SYNC2;
+    data[2] = static_cast<uint8_t>(REPLY_HEADER_SIZE + reply.length);
+    data[3] = reply.sequence;
+    data[4] = reply.command;
+    data[5] = reply.status;
+    memcpy(data + HEADER_SIZE + REPLY_HEADER_SIZE, reply.data, reply.length);
+
+    size_t length = HEADER_SIZE + data[2];
+    data[length] = GameRecords::crc8(data + 2, 1 + data[2]);
+    return length + 1;
+}
+
+int Remote::decode_reply(const uint8_t *data, const size_t length, RemoteReply *reply,
+                         size_t *used) {
+    // Find the sync bytes
+    size_t start = 0;
+    while (start + 1 < length && !(data[start] == REPLY_SYNC1 && data[start + 1] == REPLY_SYNC2)) {
+        start++;
+    }
+    if (start + HEADER_SIZE > length || start + HEADER_SIZE + data[start + 2] + 1 > length) {
+        // Keep the start of a reply that may be completed by more data
+        *used = start;
+        return 0;
+    }
+
+    const uint8_t *payload = data + start + HEADER_SIZE;
+    size_t payload_size = data[start + 2];
+    if (GameRecords::crc8(data + start + 2, 1 + payload_size) != payload[payload_size] ||
+        payload_size < REPLY_HEADER_SIZE || payload_size > REPLY_HEADER_SIZE + sizeof(reply->data)) {
+        // Not a reply after all, search again after the sync bytes
+        *used = start + 2;
+        return -1;
+    }
+
+    reply->sequence = payload[0];
+    reply->command = payload[1];
+    reply->status = payload[2];
+    reply->length = static_cast<uint8_t>(payload_size - REPLY_HEADER_SIZE);
+    memcpy(reply->data, payload + REPLY_HEADER_SIZE, reply->length);
+    *used = start + HEADER_SIZE + payload_size + 1;
+    return 1;
+}
+
+void Remote::encode_state(const RemoteState &state, RemoteReply *reply) {
+    uint8_t *data = reply->data;
+    data[0] = static_cast<uint8_t>((state.rows << 4) | state.cols);
+    data[1] = state.win_length;
+    data[2] = state.mode;
+    data[3] = state.is_game_over ? 1 : 0;
+    data[4] = static_cast<uint8_t>(state.current_player);
+    data[5] = state.cursor;
+    data[6] = state.placed;
+    data[7] = static_cast<uint8_t>(state.game_number);
+    data[8] = static_cast<uint8_t>(state.game_number >> 8);
+
+    // Only the bytes the board needs, two on the 3x3 board
+    uint bytes = (state.rows * state.cols + 7) / 8;
+    for (uint i = 0; i < bytes; i++) {
+        data[STATE_SIZE + i] = static_cast<uint8_t>(state.x >> (8 * i));
+        data[STATE_SIZE + bytes + i] = static_cast<uint8_t>(state.o >> (8 * i));
+    }
+    reply->length = static_cast<uint8_t>(STATE_SIZE + 2 * bytes);
+}
+
+bool Remote::decode_state(const RemoteReply &reply, RemoteState *state) {
+    const uint8_t *data = reply.data;
+    if (reply.length < STATE_SIZE) {
+        return false;
+    }
+    state->rows = data[0] >> 4;
+    state->cols = data[0] & 0x0f;
+    state->win_length = data[1];
+    state->mode = data[2];
+    state->is_game_over = (data[3] & 1) != 0;
+    state->current_player = static_cast<char>(data[4]);
+    state->cursor = data[5];
+    state->placed = data[6];
+    state->game_number = static_cast<uint16_t>(data[7] | (data[8] << 8));
+
+    uint bytes = (state->rows * state->cols + 7) / 8;
+    if (bytes > 8 || reply.length < STATE_SIZE + 2 * bytes) {
+        return false;
+    }
+    state->x = 0;
+    state->o = 0;
+    for (uint i = 0; i < bytes; i++) {
+        state->x |= static_cast<uint64_t>(data[STATE_SIZE + i]) << (8 * i);
+        state->o |= static_cast<uint64_t>(data[STATE_SIZE + bytes + i]) << (8 * i);
+    }
+    return true;
+}
+
+const char *Remote::get_command_name(const uint command) {
+    return (command < NUMBER_OF_REMOTE_COMMANDS) ? COMMAND_NAMES[command] : "?";
+}
+
+const char *Remote::get_status_name(const uint status) {
+    return (status < NUMBER_OF_REMOTE_STATUSES) ? STATUS_NAMES[status] : "?";
+}
+
+const char *Remote::get_mode_name(const uint mode) {
+    return (mode < NUMBER_OF_REMOTE_MODES) ? MODE_NAMES[mode] : "?";
+}
+
+uint Remote::parse_command(const char *name) {
+    for (uint command = REMOTE_PLACE; command < NUMBER_OF_REMOTE_COMMANDS; command++) {
+        if (strcmp(name, COMMAND_NAMES[command]) == 0) {
+            return command;
+        }
+    }
+    return 0;
+}
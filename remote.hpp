@@ -0,0 +1,196 @@
+#ifndef __REMOTE_HPP__
+#define __REMOTE_HPP__
+
+#include "pico/stdlib.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// Commands of the remote play protocol
+enum RemoteCommand : uint8_t {
+    REMOTE_PLACE = 1,       // Place marks at the cells given, one per argument byte
+    REMOTE_RESET,           // Start a new game
+    REMOTE_QUERY_STATE,     // Only reply with the state
+    REMOTE_SET_MODE,        // Set the RemoteMode given, then start a new game
+    REMOTE_RUN_BENCHMARK,   // Time the win check (iterations, LE 16) on the board
+    NUMBER_OF_REMOTE_COMMANDS
+};
+
+// Who the engine plays, for REMOTE_SET_MODE
+enum RemoteMode : uint8_t {
+    REMOTE_MODE_TWO_PLAYERS = 0,
+    REMOTE_MODE_ENGINE_O,       // The human plays X, as selected at power-up
+    REMOTE_MODE_ENGINE_X,       // The engine opens every game
+    NUMBER_OF_REMOTE_MODES
+};
+
+// Status of a reply
+enum RemoteStatus : uint8_t {
+    REMOTE_OK = 0,
+    REMOTE_BAD_FRAME,           // The request failed its CRC, its sequence may be wrong
+    REMOTE_UNKNOWN_COMMAND,
+    REMOTE_BAD_ARGUMENT,        // Wrong number of arguments or a value out of range
+    REMOTE_OCCUPIED,            // A cell to place at is taken, the moves before it are placed
+    REMOTE_GAME_OVER,           // The game is won, only a reset starts a new one
+    NUMBER_OF_REMOTE_STATUSES
+};
+
+// Struct for storing a request
+// @field sequence Number chosen by the client, returned in the reply
+// @field command RemoteCommand
+// @field length Number of argument bytes
+// @field arguments Arguments of the command
+typedef struct {
+    uint8_t sequence;
+    uint8_t command;
+    uint8_t length;
+    uint8_t arguments[64];
+} RemoteRequest;
+
+// Struct for storing a reply
+// @field sequence Sequence number of the request
+// @field command Command of the request
+// @field status RemoteStatus
+// @field length Number of data bytes
+// @field data The game state (see RemoteState), or the benchmark result
+typedef struct {
+    uint8_t sequence;
+    uint8_t command;
+    uint8_t status;
+    uint8_t length;
+    uint8_t data[32];
+} RemoteReply;
+
+// Struct for storing the game state carried by a reply
+// @field rows Number of board rows
+// @field cols Number of board columns
+// @field win_length Marks in a row needed to win
+// @field mode RemoteMode
+// @field is_game_over The game is won and waits for a reset
+// @field current_player Character (X or O) of the player to move
+// @field cursor Cell of the cursor
+// @field placed Number of the request's moves that were placed
+// @field game_number Number of the game since power-up, as in its record
+// @field x Cells of X, bit n for cell n
+// @field o Cells of O
+typedef struct {
+    uint8_t rows;
+    uint8_t cols;
+    uint8_t win_length;
+    uint8_t mode;
+    bool is_game_over;
+    char current_player;
+    uint8_t cursor;
+    uint8_t placed;
+    uint16_t game_number;
+    uint64_t x;
+    uint64_t o;
+} RemoteState;
+
+// What a received byte completed
+enum RemoteInput : uint8_t {
+    REMOTE_INPUT_NONE = 0,      // Part of a frame
+    REMOTE_INPUT_BYTE,          // Not in a frame, e.g. a typed command
+    REMOTE_INPUT_REQUEST,       // The last byte of a valid request
+    REMOTE_INPUT_CORRUPT,       // The last byte of a request that failed its CRC
+};
+
+// Framed binary protocol for remote play over USB stdio
+// A client sends requests, the game answers each with one reply carrying
+// its state, between the board frames and game records:
+//   request: B5 5B | length | sequence, command, arguments | CRC-8
+//   reply:   C5 5C | length | sequence, command, status, data | CRC-8
+// As in the game records, the CRC-8 covers the length and the payload. The
+// state is rows << 4 | cols, K, mode, flags (bit 0 game over), player,
+// cursor, placed, game number (LE 16), then the X and the O cells packed
+// 8 to a byte, cell 0 in bit 0 of the first. The benchmark's data is the
+// iterations (LE 16) and the microseconds they took (LE 32).
+//
+// Requests are parsed a byte at a time from the USB input, so the main loop
+// handles them between the button events without waiting for the rest of
+// a frame. Bytes outside a frame are passed on, and a frame stalled for
+// FRAME_TIMEOUT_US is dropped. Encoding and decoding are shared with the
+// host client (remote/)
+class Remote {
+    public:
+        static const uint8_t REQUEST_SYNC1 = 0xb5;
+        static const uint8_t REQUEST_SYNC2 = 0x5b;
+        static const uint8_t REPLY_SYNC1 = 0xc5;
+        static const uint8_t REPLY_SYNC2 = 0x5c;
+        static const size_t HEADER_SIZE = 3;            // Sync bytes and length
+        static const size_t REQUEST_HEADER_SIZE = 2;    // Sequence and command
+        static const size_t REPLY_HEADER_SIZE = 3;      // Sequence, command and status
+        static const size_t MAX_REQUEST_SIZE = HEADER_SIZE + REQUEST_HEADER_SIZE + 64 + 1;
+        static const size_t MAX_REPLY_SIZE = HEADER_SIZE + REPLY_HEADER_SIZE + 32 + 1;
+        static const size_t STATE_SIZE = 9;             // Before the cells
+        static const uint64_t FRAME_TIMEOUT_US = 100000;
+        static const uint16_t MAX_BENCHMARK_ITERATIONS = 10000;
+
+        // Function that sends out an encoded reply
+        typedef void (*Sink)(const uint8_t *reply, size_t length);
+
+        // Sets where the replies are sent, nullptr for stdout
+        static void set_reply_sink(Sink sink);
+
+        // Passes a byte received over USB to the request parser
+        // @param byte The byte
+        // @param now_us Time of its arrival
+        // @param request Set to the request completed by the byte
+        // @return What the byte completed; request is set for
+        //         REMOTE_INPUT_REQUEST, and its sequence and command for
+        //         REMOTE_INPUT_CORRUPT
+        static RemoteInput feed(const uint8_t byte, const uint64_t now_us, RemoteRequest *request);
+
+        // Encodes and sends the reply
+        static void send(const RemoteReply &reply);
+
+        // Encodes the request, e.g. in a client
+        // @param data Buffer of at least MAX_REQUEST_SIZE bytes
+        // @return Length of the frame in bytes
+        static size_t encode_request(const RemoteRequest &request, uint8_t *data);
+
+        // Encodes the reply
+        // @param data Buffer of at least MAX_REPLY_SIZE bytes
+        // @return Length of the frame in bytes
+        static size_t encode_reply(const RemoteReply &reply, uint8_t *data);
+
+        // Decodes the first reply in data, skipping anything before its sync
+        // bytes, like GameRecords::decode
+        // @return 1 if a reply was decoded, 0 if there is none (or only the
+        //         start of one), -1 if one was found but failed its CRC
+        static int decode_reply(const uint8_t *data, const size_t length, RemoteReply *reply,
+                                size_t *used);
+
+        // Packs the state into the reply's data
+        static void encode_state(const RemoteState &state, RemoteReply *reply);
+
+        // Unpacks the state from the reply's data
+        // @return false if the data is too short for the board in it
+        static bool decode_state(const RemoteReply &reply, RemoteState *state);
+
+        // Returns the name of the command, status or mode
+        static const char *get_command_name(const uint command);
+        static const char *get_status_name(const uint status);
+        static const char *get_mode_name(const uint mode);
+
+        // Returns the command with the name, 0 if there is none
+        static uint parse_command(const char *name);
+
+    private:
+        // States of the request parser
+        enum ParserState : uint8_t {
+            PARSER_SYNC1 = 0,
+            PARSER_SYNC2,
+            PARSER_LENGTH,
+            PARSER_PAYLOAD,
+            PARSER_CRC,
+        };
+
+        static Sink sink;
+        static uint8_t state;
+        static uint8_t length;
+        static uint8_t received;
+        static uint8_t payload[REQUEST_HEADER_SIZE + 64];
+        static uint64_t last_us;
+};
+
+#endif  // __REMOTE_HPP__
@@ -0,0 +1,237 @@
+#include "remote_client.hpp"
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+// Remote play client
+// Sends one request to the game over its USB serial port and prints the
+// reply, plays random games through it as a test rig, or prints the replies
+// found in a capture, e.g. of tictactoe_host running a script with remote
+// commands
+
+namespace {
+
+void print_state(const RemoteState &state) {
+    printf("game %u, %ux%u (K = %u), %s, %s, cursor %u, %u placed\n",
+           static_cast<uint>(state.game_number), static_cast<uint>(state.rows),
+           static_cast<uint>(state.cols), static_cast<uint>(state.win_length),
+           Remote::get_mode_name(state.mode),
+           state.is_game_over ? "game over" : (state.current_player == 'X') ? "X to move" : "O to move",
+           static_cast<uint>(state.cursor), static_cast<uint>(state.placed));
+    for (uint row = 0; row < state.rows; row++) {
+        printf("  ");
+        for (uint col = 0; col < state.cols; col++) {
+            uint64_t bit = 1ull << (row * state.cols + col);
+            putchar((state.x & bit) ? 'X' : (state.o & bit) ? 'O' : '.');
+        }
+        putchar('\n');
+    }
+}
+
+void print_reply(const RemoteReply &reply) {
+    printf("#%u %s: %s\n", static_cast<uint>(reply.sequence), Remote::get_command_name(reply.command),
+           Remote::get_status_name(reply.status));
+    if (reply.command == REMOTE_RUN_BENCHMARK && reply.status == REMOTE_OK && reply.length >= 6) {
+        uint iterations = reply.data[0] | (reply.data[1] << 8);
+        uint32_t elapsed_us = static_cast<uint32_t>(reply.data[2]) |
+                              (static_cast<uint32_t>(reply.data[3]) << 8) |
+                              (static_cast<uint32_t>(reply.data[4]) << 16) |
+                              (static_cast<uint32_t>(reply.data[5]) << 24);
+        printf("  %u iterations in %u us (%.3f us each)\n", iterations,
+               static_cast<uint>(elapsed_us), static_cast<double>(elapsed_us) / iterations);
+        return;
+    }
+    RemoteState state;
+    if (Remote::decode_state(reply, &state)) {
+        print_state(state);
+    }
+}
+
+// Prints the replies in the captures
+// @return 1 if a reply is corrupt
+int decode(const std::vector<const char *> &paths) {
+    uint replies = 0;
+    uint corrupt = 0;
+    for (const char *path : paths) {
+        FILE *file = (strcmp(path, "-") == 0) ? stdin : fopen(path, "rb");
+        if (file == nullptr) {
+            fprintf(stderr, "Cannot read %s\n", path);
+            return 1;
+        }
+        std::vector<uint8_t> data;
+        uint8_t buffer[4096];
+        size_t length = 0;
+        while ((length = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+            data.insert(data.end(), buffer, buffer + length);
+        }
+        if (file != stdin) {
+            fclose(file);
+        }
+
+        size_t offset = 0;
+        while (offset < data.size()) {
+            RemoteReply reply;
+            size_t used = 0;
+            int found = Remote::decode_reply(data.data() + offset, data.size() - offset, &reply, &used);
+            offset += used;
+            if (found == 0) {
+                break;
+            }
+            if (found < 0) {
+                corrupt++;
+                continue;
+            }
+            replies++;
+            print_reply(reply);
+        }
+    }
+    printf("%u replies, %u corrupt\n", replies, corrupt);
+    return (corrupt > 0) ? 1 : 0;
+}
+
+// Plays random two-player games, a move per request or a game per request
+// @return 1 if a request failed
+int play(RemoteClient *client, const uint games, const bool is_batched, const uint seed) {
+    RemoteState state;
+    if (client->set_mode(REMOTE_MODE_TWO_PLAYERS, &state) != REMOTE_OK) {
+        fprintf(stderr, "No reply to the mode request\n");
+        return 1;
+    }
+    std::mt19937 rng(seed);
+    uint cells = state.rows * state.cols;
+    uint64_t moves = 0;
+    uint64_t requests = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    for (uint game = 0; game < games; game++) {
+        if (client->reset(&state) != REMOTE_OK) {
+            fprintf(stderr, "No reply to the reset\n");
+            return 1;
+        }
+        requests++;
+
+        // A random order of all the cells: the game ends on a win, or on
+        // the tie after the last one
+        std::vector<uint8_t> order(cells);
+        for (uint i = 0; i < cells; i++) {
+            order[i] = static_cast<uint8_t>(i);
+        }
+        std::shuffle(order.begin(), order.end(), rng);
+
+        if (is_batched && cells <= sizeof(RemoteRequest::arguments)) {
+            int status = client->place(order.data(), order.size(), &state);
+            if (status < 0 || (status != REMOTE_OK && status != REMOTE_GAME_OVER)) {
+                fprintf(stderr, "Game %u: %s\n", game, Remote::get_status_name(status));
+                return 1;
+            }
+            moves += state.placed;
+            requests++;
+            continue;
+        }
+        for (uint i = 0; i < cells && !state.is_game_over; i++) {
+            int status = client->place(&order[i], 1, &state);
+            if (status != REMOTE_OK) {
+                fprintf(stderr, "Game %u: %s\n", game, Remote::get_status_name(status));
+                return 1;
+            }
+            moves++;
+            requests++;
+        }
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("%u games, %llu moves in %llu requests, %.3f s: %.0f moves/s, %.0f requests/s\n", games,
+           static_cast<unsigned long long>(moves), static_cast<unsigned long long>(requests),
+           seconds, seconds > 0 ? moves / seconds : 0.0, seconds > 0 ? requests / seconds : 0.0);
+    return 0;
+}
+
+void usage() {
+    fputs("Usage: tictactoe_remote --device PATH <command> [n ...]\n"
+          "       tictactoe_remote --device PATH --play GAMES [--batch] [--seed N]\n"
+          "       tictactoe_remote --decode [capture ...]\n"
+          "\n"
+          "Talks to the game over its USB serial port (e.g. /dev/ttyACM0) with the\n"
+          "remote play protocol. Commands: place <cell ...>, reset, state,\n"
+          "mode <0 two players, 1 engine plays O, 2 engine plays X> and\n"
+          "bench <iterations>. --play plays random two-player games, one move per\n"
+          "request, or with --batch a whole game per request, and prints the moves/s.\n"
+          "--decode prints the replies in captures, or stdin, such as the output of\n"
+          "tictactoe_host running remote commands from its script.\n",
+          stderr);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    const char *device = nullptr;
+    bool is_decode = false;
+    bool is_batched = false;
+    uint games = 0;
+    uint seed = 1;
+    std::vector<const char *> words;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--device") == 0 && i + 1 < argc) {
+            device = argv[++i];
+        } else if (strcmp(argv[i], "--play") == 0 && i + 1 < argc) {
+            games = static_cast<uint>(atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = static_cast<uint>(atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--batch") == 0) {
+            is_batched = true;
+        } else if (strcmp(argv[i], "--decode") == 0) {
+            is_decode = true;
+        } else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+            usage();
+            return 1;
+        } else {
+            words.push_back(argv[i]);
+        }
+    }
+
+    if (is_decode) {
+        if (words.empty()) {
+            words.push_back("-");
+        }
+        return decode(words);
+    }
+    if (device == nullptr || (games == 0 && words.empty())) {
+        usage();
+        return 1;
+    }
+
+    RemoteClient client;
+    if (!client.open(device)) {
+        fprintf(stderr, "Cannot open %s\n", device);
+        return 1;
+    }
+    if (games > 0) {
+        return play(&client, games, is_batched, seed);
+    }
+
+    uint command = Remote::parse_command(words[0]);
+    if (command == 0) {
+        usage();
+        return 1;
+    }
+    std::vector<uint8_t> arguments;
+    for (size_t i = 1; i < words.size(); i++) {
+        long value = strtol(words[i], nullptr, 0);
+        arguments.push_back(static_cast<uint8_t>(value));
+        // The benchmark's iterations take 16 bits
+        if (command == REMOTE_RUN_BENCHMARK) {
+            arguments.push_back(static_cast<uint8_t>(value >> 8));
+        }
+    }
+    RemoteReply reply;
+    if (!client.request(static_cast<uint8_t>(command), arguments.data(), arguments.size(), &reply)) {
+        fprintf(stderr, "No reply\n");
+        return 1;
+    }
+    print_reply(reply);
+    return (reply.status == REMOTE_OK) ? 0 : 1;
+}
@@ -0,0 +1,152 @@
+#include "remote_client.hpp"
+#include <chrono>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+RemoteClient::RemoteClient()
+    : read_fd(-1), write_fd(-1), is_owner(false), timeout_ms(DEFAULT_TIMEOUT_MS), sequence(0),
+      skipped(0) {}
+
+RemoteClient::~RemoteClient() {
+    if (is_owner && read_fd >= 0) {
+        close(read_fd);
+    }
+}
+
+bool RemoteClient::open(const char *path) {
+    int fd = ::open(path, O_RDWR | O_NOCTTY);
+    if (fd < 0) {
+        return false;
+    }
+    // The protocol is binary: no echo, no line editing, no CR LF mapping.
+    // The baud rate means nothing to USB CDC
+    struct termios options;
+    if (tcgetattr(fd, &options) == 0) {
+        cfmakeraw(&options);
+        tcsetattr(fd, TCSANOW, &options);
+    }
+    attach(fd, fd);
+    is_owner = true;
+    return true;
+}
+
+void RemoteClient::attach(const int read_fd, const int write_fd) {
+    this->read_fd = read_fd;
+    this->write_fd = write_fd;
+    is_owner = false;
+    input.clear();
+}
+
+bool RemoteClient::request(const uint8_t command, const uint8_t *arguments, const size_t length,
+                           RemoteReply *reply) {
+    RemoteRequest request;
+    request.sequence = ++sequence;
+    request.command = command;
+    request.length = static_cast<uint8_t>((length < sizeof(request.arguments)) ?
+                                          length : sizeof(request.arguments));
+    for (size_t i = 0; i < request.length; i++) {
+        request.arguments[i] = arguments[i];
+    }
+
+    uint8_t frame[Remote::MAX_REQUEST_SIZE];
+    size_t frame_length = Remote::encode_request(request, frame);
+    for (size_t written = 0; written < frame_length;) {
+        ssize_t n = write(write_fd, frame + written, frame_length - written);
+        if (n <= 0) {
+            return false;
+        }
+        written += static_cast<size_t>(n);
+    }
+
+    // Replies to earlier, timed out requests are dropped on the way
+    std::chrono::steady_clock::time_point deadline =
+        std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (true) {
+        size_t used = 0;
+        int found = Remote::decode_reply(input.data(), input.size(), reply, &used);
+        skipped += (found == 1) ? used - (Remote::HEADER_SIZE + Remote::REPLY_HEADER_SIZE +
+                                          reply->length + 1) : used;
+        input.erase(input.begin(), input.begin() + static_cast<long>(used));
+        if (found == 1 && reply->sequence == request.sequence) {
+            return true;
+        }
+        if (found != 0) {
+            continue;
+        }
+
+        int left_ms = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now()).count());
+        struct pollfd ready = {read_fd, POLLIN, 0};
+        if (left_ms <= 0 || poll(&ready, 1, left_ms) <= 0) {
+            return false;
+        }
+        uint8_t buffer[4096];
+        ssize_t n = read(read_fd, buffer, sizeof(buffer));
+        if (n <= 0) {
+            return false;
+        }
+        input.insert(input.end(), buffer, buffer + n);
+    }
+}
+
+int RemoteClient::finish(const bool is_replied, const RemoteReply &reply, RemoteState *state) {
+    if (!is_replied) {
+        return -1;
+    }
+    if (state != nullptr && reply.status != REMOTE_BAD_FRAME &&
+        !Remote::decode_state(reply, state)) {
+        return -1;
+    }
+    return reply.status;
+}
+
+int RemoteClient::place(const uint8_t *cells, const size_t count, RemoteState *state) {
+    RemoteReply reply;
+    bool is_replied = request(REMOTE_PLACE, cells, count, &reply);
+    return finish(is_replied, reply, state);
+}
+
+int RemoteClient::reset(RemoteState *state) {
+    RemoteReply reply;
+    bool is_replied = request(REMOTE_RESET, nullptr, 0, &reply);
+    return finish(is_replied, reply, state);
+}
+
+int RemoteClient::query_state(RemoteState *state) {
+    RemoteReply reply;
+    bool is_replied = request(REMOTE_QUERY_STATE, nullptr, 0, &reply);
+    return finish(is_replied, reply, state);
+}
+
+int RemoteClient::set_mode(const RemoteMode mode, RemoteState *state) {
+    RemoteReply reply;
+    uint8_t argument = mode;
+    bool is_replied = request(REMOTE_SET_MODE, &argument, 1, &reply);
+    return finish(is_replied, reply, state);
+}
+
+int RemoteClient::run_benchmark(const uint16_t iterations, uint32_t *elapsed_us) {
+    RemoteReply reply;
+    uint8_t arguments[2] = {static_cast<uint8_t>(iterations),
+                            static_cast<uint8_t>(iterations >> 8)};
+    if (!request(REMOTE_RUN_BENCHMARK, arguments, sizeof(arguments), &reply)) {
+        return -1;
+    }
+    if (reply.status == REMOTE_OK && reply.length >= 6) {
+        *elapsed_us = static_cast<uint32_t>(reply.data[2]) |
+                      (static_cast<uint32_t>(reply.data[3]) << 8) |
+                      (static_cast<uint32_t>(reply.data[4]) << 16) |
+                      (static_cast<uint32_t>(reply.data[5]) << 24);
+    }
+    return reply.status;
+}
+
+void RemoteClient::set_timeout_ms(const int timeout_ms) {
+    this->timeout_ms = timeout_ms;
+}
+
+uint64_t RemoteClient::get_skipped_bytes() {
+    return skipped;
+}
@@ -0,0 +1,77 @@
+#ifndef __REMOTE_CLIENT_HPP__
+#define __REMOTE_CLIENT_HPP__
+
+#include "remote.hpp"
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+// Host side of the remote play protocol (remote.hpp)
+// Sends requests to the game over its USB serial port, or any pair of file
+// descriptors, and waits for the reply with the same sequence number. The
+// board frames and game records in between are skipped
+class RemoteClient {
+    public:
+        static const int DEFAULT_TIMEOUT_MS = 1000;
+
+        // Constructor
+        RemoteClient();
+
+        // Destructor, closes the port it opened
+        ~RemoteClient();
+
+        // Opens the serial port, e.g. /dev/ttyACM0, in raw mode
+        // @return false if it can't be opened
+        bool open(const char *path);
+
+        // Talks over already open file descriptors instead, e.g. pipes
+        void attach(const int read_fd, const int write_fd);
+
+        // Sends the request and waits for its reply
+        // @param command RemoteCommand
+        // @param arguments The command's arguments
+        // @param length Number of argument bytes
+        // @param reply Set to the reply
+        // @return false on a timeout or an I/O error
+        bool request(const uint8_t command, const uint8_t *arguments, const size_t length,
+                     RemoteReply *reply);
+
+        // Places marks at the cells, in one request of up to 64 moves
+        // @param state Set to the state after them
+        // @return The reply's RemoteStatus, -1 if there was none
+        int place(const uint8_t *cells, const size_t count, RemoteState *state);
+
+        // Starts a new game
+        int reset(RemoteState *state);
+
+        // Reads the state
+        int query_state(RemoteState *state);
+
+        // Sets who the engine plays, and starts a new game
+        int set_mode(const RemoteMode mode, RemoteState *state);
+
+        // Times the game's win check on its board
+        // @param elapsed_us Set to the time the iterations took on the device
+        int run_benchmark(const uint16_t iterations, uint32_t *elapsed_us);
+
+        // Sets the time to wait for a reply
+        void set_timeout_ms(const int timeout_ms);
+
+        // Returns the number of bytes skipped between the replies
+        uint64_t get_skipped_bytes();
+
+    private:
+        int read_fd;
+        int write_fd;
+        bool is_owner;
+        int timeout_ms;
+        uint8_t sequence;
+        uint64_t skipped;
+        // Received bytes not yet decoded
+        std::vector<uint8_t> input;
+
+        // Turns a reply into the status, and its state
+        int finish(const bool is_replied, const RemoteReply &reply, RemoteState *state);
+};
+
+#endif  // __REMOTE_CLIENT_HPP__
@@ -0,0 +1,193 @@
+#include "renderer.hpp"
+#include "output.hpp"
+#include "pico/time.h"
+#include <cstdio>
+#include <cstring>
+
+// ANSI escape sequences
+static const char CLEAR_SCREEN[] = "\e[1;1H\e[2J\e[?25l";   // Home, clear, hide the cursor
+static const char INVERT[] = "\e[7m";
+static const char NORMAL[] = "\e[m";
+static const char CLEAR_TO_EOL[] = "\e[K";
+
+// A frame is queued whole, the ring must hold the largest one
+static_assert(Output::RING_SIZE >= Renderer::BUFFER_SIZE, "The output ring can't hold a frame");
+
+Renderer::Renderer(const uint rows, const uint cols)
+    : rows(rows), cols(cols), cursor(0), shown_cursor(0), is_shown(false), length(0),
+      sink(nullptr) {
+    memset(cells, ' ', sizeof(cells));
+    memset(shown_cells, ' ', sizeof(shown_cells));
+    status[0] = '\0';
+    shown_status[0] = '\0';
+    message[0] = '\0';
+    shown_message[0] = '\0';
+    memset(&stats, 0, sizeof(stats));
+}
+
+void Renderer::set_cell(const uint cell, const char symbol) {
+    cells[cell] = symbol;
+}
+
+void Renderer::set_cursor(const uint cell) {
+    cursor = cell;
+}
+
+void Renderer::set_status(const char *text) {
+    strncpy(status, text, MAX_LINE - 1);
+    status[MAX_LINE - 1] = '\0';
+}
+
+void Renderer::set_message(const char *text) {
+    strncpy(message, text, MAX_LINE - 1);
+    message[MAX_LINE - 1] = '\0';
+}
+
+void Renderer::invalidate() {
+    is_shown = false;
+}
+
+void Renderer::set_sink(Sink sink) {
+    this->sink = sink;
+}
+
+const RenderStats &Renderer::get_stats() {
+    return stats;
+}
+
+void Renderer::append(const char *text) {
+    size_t n = strlen(text);
+    if (length + n > BUFFER_SIZE) {
+        n = BUFFER_SIZE - length;
+    }
+    memcpy(buffer + length, text, n);
+    length += n;
+}
+
+void Renderer::append_goto(const uint line, const uint column) {
+    TextBuffer<16> sequence;
+    append(sequence.format("\e[%u;%uH", line, column).c_str());
+}
+
+void Renderer::append_cell(const uint cell) {
+    char text[4] = {' ', cells[cell], ' ', '\0'};
+    if (cell == cursor) {
+        append(INVERT);
+        append(text);
+        append(NORMAL);
+    } else {
+        append(text);
+    }
+}
+
+void Renderer::append_line(const char *text) {
+    append(text);
+    append(CLEAR_TO_EOL);
+}
+
+void Renderer::append_line_diff(const uint line, const char *text, const char *shown) {
+    // Skip the prefix the terminal already shows
+    size_t same = 0;
+    while (text[same] != '\0' && text[same] == shown[same]) {
+        same++;
+    }
+    if (text[same] == '\0' && shown[same] == '\0') {
+        return;
+    }
+
+    append_goto(line, static_cast<uint>(same) + 1);
+    append(text + same);
+    // Only clear the tail if the old text was longer
+    if (strlen(shown) > strlen(text)) {
+        append(CLEAR_TO_EOL);
+    }
+}
+
+void Renderer::build_full() {
+    append(CLEAR_SCREEN);
+
+    for (uint r = 0; r < rows; r++) {
+        for (uint c = 0; c < cols; c++) {
+            append_cell(r * cols + c);
+            // Print the vertical separators except for the last column
+            if (c < cols - 1) {
+                append("|");
+            }
+        }
+        append(TEXT_NEWLINE);
+
+        // Print the horizontal separators except for the last row
+        if (r < rows - 1) {
+            for (uint c = 0; c < cols; c++) {
+                append((c < cols - 1) ? "---+" : "---");
+            }
+            append(TEXT_NEWLINE);
+        }
+    }
+
+    append_line(status);
+    append(TEXT_NEWLINE);
+    append_line(message);
+}
+
+void Renderer::build_diff() {
+    for (uint cell = 0; cell < rows * cols; cell++) {
+        // A cell is redrawn if its symbol changed or it gained or lost the highlight
+        bool was_highlighted = (cell == shown_cursor);
+        bool is_highlighted = (cell == cursor);
+        if (cells[cell] != shown_cells[cell] || was_highlighted != is_highlighted) {
+            append_goto(2 * (cell / cols) + 1, 4 * (cell % cols) + 1);
+            append_cell(cell);
+        }
+    }
+
+    append_line_diff(2 * rows, status, shown_status);
+    append_line_diff(2 * rows + 1, message, shown_message);
+}
+
+void Renderer::flush() {
+    uint64_t start = time_us_64();
+    length = 0;
+
+    // Bytes lost in the output ring may have cut any earlier frame
+    if (sink == nullptr && Output::take_overrun()) {
+        is_shown = false;
+    }
+
+    if (!is_shown) {
+        build_full();
+        stats.full_frames++;
+    } else {
+        build_diff();
+    }
+
+    // Nothing changed, nothing to send
+    if (length == 0) {
+        return;
+    }
+
+    if (sink != nullptr) {
+        sink(buffer, length);
+    } else if (!Output::write(buffer, length, true)) {
+        // The terminal is behind: what is shown stays as it was, so the
+        // next frame carries these changes too
+        stats.coalesced++;
+        return;
+    }
+
+    // The terminal now shows the new frame
+    memcpy(shown_cells, cells, sizeof(cells));
+    shown_cursor = cursor;
+    memcpy(shown_status, status, sizeof(status));
+    memcpy(shown_message, message, sizeof(message));
+    is_shown = true;
+
+    stats.frames++;
+    stats.last_bytes = static_cast<uint32_t>(length);
+    stats.total_bytes += static_cast<uint32_t>(length);
+    stats.last_us = static_cast<uint32_t>(time_us_64() - start);
+    if (stats.frames == 1) {
+        // The timer counts from reset, so this is the boot-to-first-frame time
+        stats.first_frame_us = time_us_64();
+    }
+}
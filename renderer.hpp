@@ -0,0 +1,132 @@
+#ifndef __RENDERER_HPP__
+#define __RENDERER_HPP__
+
+#include "pico/stdlib.h"
+#include "text.hpp"
+#include <stddef.h>
+#include <stdint.h>
+
+// Struct for storing the renderer's output statistics
+// @field frames Number of flushes that wrote anything
+// @field full_frames Number of those that repainted the whole screen
+// @field coalesced Frames the output ring had no room for, shown by a later one
+// @field last_bytes Bytes written by the last frame
+// @field total_bytes Bytes written by all frames
+// @field last_us Time taken to build and write the last frame
+// @field first_frame_us Time since boot at which the first frame was written
+typedef struct {
+    uint32_t frames;
+    uint32_t full_frames;
+    uint32_t coalesced;
+    uint32_t last_bytes;
+    uint32_t total_bytes;
+    uint32_t last_us;
+    uint64_t first_frame_us;
+} RenderStats;
+
+// Diff-based terminal renderer
+// Keeps the frame last shown on the terminal and, on flush(), emits
+// cursor-addressed ANSI updates for only the cells, cursor highlight and
+// text lines that changed, batched into a single write
+//
+// Screen layout (1-based lines), e.g. for 3x3:
+//   1   X | O |         <- cell (r, c) at line 2r + 1, column 4c + 1
+//   2  ---+---+---
+//   3     | X |
+//   4  ---+---+---
+//   5     |   | O
+//   6  Player X turn    <- status line
+//   7  Row 1 Col 1      <- message line
+class Renderer {
+    public:
+        static const uint MAX_ROWS = 8;
+        static const uint MAX_COLS = 8;
+        static const uint MAX_CELLS = MAX_ROWS * MAX_COLS;
+        static const size_t MAX_LINE = 80;
+        static const size_t BUFFER_SIZE = 2048;
+
+        // Text of a status or message line
+        typedef TextBuffer<MAX_LINE> Line;
+
+        // Function that writes out a finished frame
+        typedef void (*Sink)(const char *data, size_t length);
+
+        // Constructor
+        // @param rows Number of board rows, at most MAX_ROWS
+        // @param cols Number of board columns, at most MAX_COLS
+        Renderer(const uint rows, const uint cols);
+
+        // Sets the symbol shown in the cell
+        void set_cell(const uint cell, const char symbol);
+
+        // Sets the highlighted (cursor) cell
+        void set_cursor(const uint cell);
+
+        // Sets the status line shown below the board (e.g. whose turn it is)
+        void set_status(const char *text);
+
+        // Sets the message line shown below the status line
+        void set_message(const char *text);
+
+        // Forces the next flush to repaint the whole screen
+        void invalidate();
+
+        // Writes the changes since the last flush to the terminal in one write
+        void flush();
+
+        // Sets where flush() writes the frames, e.g. a null sink for benchmarks
+        // @param sink Function writing a frame, nullptr for stdout through
+        //        the output ring (Output), which core 1 drains
+        void set_sink(Sink sink);
+
+        // Returns the output statistics
+        const RenderStats &get_stats();
+
+    private:
+        uint rows;
+        uint cols;
+
+        // Frame to show, and frame currently shown on the terminal
+        char cells[MAX_CELLS];
+        char shown_cells[MAX_CELLS];
+        uint cursor;
+        uint shown_cursor;
+        char status[MAX_LINE];
+        char shown_status[MAX_LINE];
+        char message[MAX_LINE];
+        char shown_message[MAX_LINE];
+        bool is_shown;
+
+        // Output batched by flush()
+        char buffer[BUFFER_SIZE];
+        size_t length;
+
+        RenderStats stats;
+
+        // Where the frames go, the output ring if nullptr
+        Sink sink;
+
+        // Appends text to the output buffer, truncating if it is full
+        void append(const char *text);
+
+        // Appends a cursor move to the 1-based line and column
+        void append_goto(const uint line, const uint column);
+
+        // Appends the 3-character cell, inverted if it is the cursor
+        void append_cell(const uint cell);
+
+        // Appends a text line starting at the cursor position, clearing its tail
+        void append_line(const char *text);
+
+        // Appends the part of a text line that differs from what is shown
+        // @param line 1-based screen line
+        void append_line_diff(const uint line, const char *text, const char *shown);
+
+        // Builds the whole screen
+        void build_full();
+
+        // Builds updates of only the changed parts
+        void build_diff();
+};
+
+#endif  // __RENDERER_HPP__
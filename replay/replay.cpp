@@ -0,0 +1,200 @@
+#include "game.hpp"
+#include "move_log.hpp"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+// Game record replay
+// Finds the binary game records in captures of the USB serial output and
+// plays every game again through the game logic, pressing btn2 on each
+// recorded cell. The game sends its own record when the replayed game ends,
+// which must match the captured one: same result, same moves. An illegal
+// move, a missed win or a wrong result shows up as a mismatch
+
+namespace {
+
+// Struct for storing the counts of a replay run
+// @field records Records found
+// @field verified Games that replayed to the recorded result
+// @field mismatched Games that didn't
+// @field corrupt Sync bytes followed by a bad record
+// @field skipped Records of another board variant
+typedef struct {
+    uint64_t records;
+    uint64_t verified;
+    uint64_t mismatched;
+    uint64_t corrupt;
+    uint64_t skipped;
+} ReplayStats;
+
+const char *RESULT_NAMES[] = {"tie", "X wins", "O wins", "abandoned"};
+
+// Statically allocated, as on the Pico
+TicTacToe game;
+
+// The record the game sent during the replay
+GameRecord replayed;
+bool is_replayed = false;
+
+void discard_frame(const char *data, size_t length) {
+    (void)data;
+    (void)length;
+}
+
+// Record sink that keeps the game's own record
+void capture_record(const uint8_t *record, size_t length) {
+    size_t used = 0;
+    is_replayed = GameRecords::decode(record, length, &replayed, &used) == 1;
+}
+
+void print_record(const GameRecord &record) {
+    printf("game %u: %s, %u moves:", static_cast<uint>(record.game_number),
+           RESULT_NAMES[record.result], static_cast<uint>(record.count));
+    for (uint i = 0; i < record.count; i++) {
+        printf(" %u", static_cast<uint>(record.cells[i]));
+    }
+    printf("\n");
+}
+
+// Plays the recorded game through the state machine, as btn2 presses
+// @return true if the game sent the same record back
+bool replay(const GameRecord &record) {
+    // A previous mismatched game may still be in progress, drop its record
+    TicTacToe::State state = {};
+    game.dispatch(&state, GAME_EVENT_RESET_CONFIRMED);
+    is_replayed = false;
+
+    for (uint i = 0; i < record.count; i++) {
+        if (state.phase == GAME_PHASE_WON || is_replayed) {
+            // The game ended before the recorded moves did
+            return false;
+        }
+        state.cursor = record.cells[i];
+        game.dispatch(&state, GAME_EVENT_PLACE);
+    }
+    if (record.result == RESULT_ABANDONED && !is_replayed) {
+        // The player pressed reset
+        game.dispatch(&state, GAME_EVENT_RESET_CONFIRMED);
+    }
+
+    return is_replayed && replayed.result == record.result && replayed.count == record.count &&
+           memcmp(replayed.cells, record.cells, record.count) == 0;
+}
+
+// Replays every record in the data
+void replay_all(const std::vector<uint8_t> &data, const bool is_verbose, ReplayStats *stats) {
+    size_t offset = 0;
+    while (offset < data.size()) {
+        GameRecord record;
+        size_t used = 0;
+        int found = GameRecords::decode(data.data() + offset, data.size() - offset, &record, &used);
+        offset += used;
+        if (found == 0) {
+            break;
+        }
+        if (found < 0) {
+            stats->corrupt++;
+            continue;
+        }
+
+        stats->records++;
+        if (record.rows != TicTacToe::ROWS || record.cols != TicTacToe::COLS ||
+            record.win_length != TicTacToe::WIN_LENGTH) {
+            stats->skipped++;
+            continue;
+        }
+        if (is_verbose) {
+            print_record(record);
+        }
+        if (replay(record)) {
+            stats->verified++;
+        } else {
+            stats->mismatched++;
+            printf("Mismatch: ");
+            print_record(record);
+            if (is_replayed) {
+                // Numbered like the recorded game, not by the replay's count
+                replayed.game_number = record.game_number;
+                printf("  replayed: ");
+                print_record(replayed);
+            } else {
+                printf("  replayed: no result\n");
+            }
+        }
+    }
+}
+
+// Appends the contents of the file, "-" for stdin
+// @return false if it can't be read
+bool read_file(const char *path, std::vector<uint8_t> *data) {
+    FILE *file = (strcmp(path, "-") == 0) ? stdin : fopen(path, "rb");
+    if (file == nullptr) {
+        return false;
+    }
+    uint8_t buffer[4096];
+    size_t length = 0;
+    while ((length = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        data->insert(data->end(), buffer, buffer + length);
+    }
+    if (file != stdin) {
+        fclose(file);
+    }
+    return true;
+}
+
+void usage() {
+    fputs("Usage: tictactoe_replay [--verbose] [capture ...]\n"
+          "\n"
+          "Finds the game records in captures of the Pico's USB serial output (or\n"
+          "of tictactoe_host), replays each game through the game logic and checks\n"
+          "that it ends the same way. Reads stdin without captures, or for \"-\".\n"
+          "--verbose prints every game. Exits with 1 on any mismatch or corrupt record.\n",
+          stderr);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    bool is_verbose = false;
+    std::vector<const char *> paths;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--verbose") == 0) {
+            is_verbose = true;
+        } else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+            usage();
+            return 1;
+        } else {
+            paths.push_back(argv[i]);
+        }
+    }
+    if (paths.empty()) {
+        paths.push_back("-");
+    }
+
+    game.set_render_sink(discard_frame);
+    game.set_record_sink(capture_record);
+
+    ReplayStats stats = {0, 0, 0, 0, 0};
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (const char *path : paths) {
+        std::vector<uint8_t> data;
+        if (!read_file(path, &data)) {
+            fprintf(stderr, "Cannot read %s\n", path);
+            return 1;
+        }
+        replay_all(data, is_verbose, &stats);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    printf("%llu records: %llu verified, %llu mismatched, %llu corrupt, %llu other boards "
+           "(%.0f games/s)\n",
+           static_cast<unsigned long long>(stats.records),
+           static_cast<unsigned long long>(stats.verified),
+           static_cast<unsigned long long>(stats.mismatched),
+           static_cast<unsigned long long>(stats.corrupt),
+           static_cast<unsigned long long>(stats.skipped),
+           seconds > 0 ? static_cast<double>(stats.verified + stats.mismatched) / seconds : 0.0);
+    return (stats.mismatched > 0 || stats.corrupt > 0) ? 1 : 0;
+}
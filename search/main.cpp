@@ -0,0 +1,215 @@
+#include "ai.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+
+// Parallel search benchmark
+// Times the engine on 3x3, 4x4 and 5x5 positions searched to a fixed depth,
+// alone and with a helper thread running Engine::help as core 1 does on the
+// Pico (lazy SMP over the shared transposition table). For each it prints
+// the nodes/s and the time to the best move of that depth, and the speedup
+// of the two threads over one
+
+namespace {
+
+// Engine budget, large enough that the fixed depth ends every search
+const uint64_t UNLIMITED_US = 1ull << 40;
+
+// Struct for storing the settings of a run
+// @field positions Number of positions per board, the empty board first
+// @field repeats Number of runs of each search, the fastest counts
+// @field deeper Plies added to every board's default depth
+// @field seed Seed of the random openings
+typedef struct {
+    uint positions;
+    uint repeats;
+    int deeper;
+    uint64_t seed;
+} Settings;
+
+// Struct for storing the measurement of one search
+// @field seconds Wall time to the best move
+// @field nodes Nodes searched, by both threads
+// @field helper_nodes Nodes searched by the helper
+// @field cell Best move
+// @field depth Depth of the best move
+typedef struct {
+    double seconds;
+    uint64_t nodes;
+    uint64_t helper_nodes;
+    int cell;
+    uint depth;
+} Measurement;
+
+uint64_t next_random(uint64_t *state) {
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 0x2545f4914f6cdd1dull;
+}
+
+// Plays random moves from the empty board that neither side wins with
+// @return The side to move
+template <uint Rows, uint Cols, uint K>
+char random_opening(const uint moves, uint64_t *rng, BasicBitboard<Rows * Cols> *board) {
+    typedef BoardGeometry<Rows, Cols, K> Geometry;
+    typedef typename BasicBitboard<Rows * Cols>::Mask Mask;
+    board->x = 0;
+    board->o = 0;
+    char player = 'X';
+    for (uint i = 0; i < moves; i++) {
+        Mask empty = static_cast<Mask>(~(board->x | board->o) & Geometry::FULL_BOARD);
+        uint cell = 0;
+        bool is_win = true;
+        for (uint tries = 0; tries < 64 && is_win; tries++) {
+            cell = static_cast<uint>(next_random(rng) % (Rows * Cols));
+            if (!((empty >> cell) & 1)) {
+                continue;
+            }
+            Mask mask = static_cast<Mask>(((player == 'X') ? board->x : board->o) |
+                                          (static_cast<Mask>(1) << cell));
+            is_win = false;
+            for (uint line = 0; line < Geometry::NUMBER_OF_WIN_MASKS; line++) {
+                is_win |= (mask & Geometry::WIN_MASKS[line]) == Geometry::WIN_MASKS[line];
+            }
+        }
+        if (is_win) {
+            break;
+        }
+        Mask bit = static_cast<Mask>(static_cast<Mask>(1) << cell);
+        if (player == 'X') {
+            board->x |= bit;
+        } else {
+            board->o |= bit;
+        }
+        player = (player == 'X') ? 'O' : 'X';
+    }
+    return player;
+}
+
+// Searches the position from an empty table, with or without the helper
+template <uint Rows, uint Cols, uint K>
+Measurement measure(Engine<Rows, Cols, K> *engine, const BasicBitboard<Rows * Cols> &board,
+                    const char player, const bool is_parallel) {
+    engine->clear_table();
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    Measurement result;
+    if (is_parallel) {
+        // The helper stands in for core 1 answering a MSG_SEARCH_REQUEST
+        uint16_t ticket = engine->open_search();
+        std::thread helper([engine, &board, player, ticket] {
+            engine->help(board, player, UNLIMITED_US, ticket);
+        });
+        result.cell = engine->find_best_move(board, player, UNLIMITED_US);
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                                       start).count();
+        helper.join();
+    } else {
+        result.cell = engine->find_best_move(board, player, UNLIMITED_US);
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                                       start).count();
+    }
+    const SearchStats &stats = engine->get_stats();
+    result.nodes = stats.nodes;
+    result.helper_nodes = stats.helper_nodes;
+    result.depth = stats.depth;
+    return result;
+}
+
+template <uint Rows, uint Cols, uint K>
+Measurement fastest(Engine<Rows, Cols, K> *engine, const BasicBitboard<Rows * Cols> &board,
+                    const char player, const bool is_parallel, const uint repeats) {
+    Measurement best = measure(engine, board, player, is_parallel);
+    for (uint i = 1; i < repeats; i++) {
+        Measurement result = measure(engine, board, player, is_parallel);
+        if (result.seconds < best.seconds) {
+            best = result;
+        }
+    }
+    return best;
+}
+
+double rate(const Measurement &result) {
+    return (result.seconds > 0) ? static_cast<double>(result.nodes) / result.seconds : 0.0;
+}
+
+// Runs the positions of one board variant
+// @param depth Default search depth of the variant
+template <uint Rows, uint Cols, uint K>
+void run_board(const Settings &settings, const uint depth) {
+    static Engine<Rows, Cols, K> engine;
+    const uint limit = static_cast<uint>(std::max(1, static_cast<int>(depth) + settings.deeper));
+    engine.set_depth_limit(limit);
+    printf("%ux%u (%u in a row), depth %u:\n", Rows, Cols, K, limit);
+
+    uint64_t rng = settings.seed * 0x9e3779b97f4a7c15ull + Rows;
+    double log_sum = 0.0;
+    for (uint i = 0; i < settings.positions; i++) {
+        BasicBitboard<Rows * Cols> board;
+        // The empty board, then openings of 2 to 5 moves
+        uint moves = (i == 0) ? 0 : 2 + static_cast<uint>(next_random(&rng) % 4);
+        char player = random_opening<Rows, Cols, K>(moves, &rng, &board);
+
+        Measurement one = fastest(&engine, board, player, false, settings.repeats);
+        Measurement two = fastest(&engine, board, player, true, settings.repeats);
+        double speedup = (two.seconds > 0) ? one.seconds / two.seconds : 0.0;
+        log_sum += std::log(std::max(speedup, 1e-9));
+        printf("  %u moves, %c to move: 1 thread %9.3f ms %10.0f nodes/s (cell %2d) | "
+               "2 threads %9.3f ms %10.0f nodes/s (cell %2d, depth %u, helper %4.1f%%) | "
+               "speedup %.2f, nodes/s x%.2f\n",
+               moves, player, one.seconds * 1e3, rate(one), one.cell, two.seconds * 1e3,
+               rate(two), two.cell, two.depth,
+               two.nodes ? 100.0 * static_cast<double>(two.helper_nodes) / two.nodes : 0.0,
+               speedup, (rate(one) > 0) ? rate(two) / rate(one) : 0.0);
+    }
+    double mean = std::exp(log_sum / settings.positions);
+    printf("  time to move speedup %.2f (geometric mean)\n", mean);
+    engine.set_depth_limit(0);
+}
+
+void usage() {
+    fputs("Usage: tictactoe_search [--positions N] [--repeats N] [--deeper N] [--seed N]\n"
+          "\n"
+          "Searches N positions (default 4: the empty board and random openings)\n"
+          "of the 3x3, 4x4 and 5x5 boards to a fixed depth, with one thread and\n"
+          "with a helper thread sharing the transposition table as core 1 does on\n"
+          "the Pico, and prints the nodes/s and time to the best move of each and\n"
+          "the speedup. Each search runs --repeats times (default 3) from an\n"
+          "empty table and the fastest counts. --deeper adds plies to every\n"
+          "board's default depth (9, 10 and 8). The speedup needs two free CPUs.\n",
+          stderr);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    Settings settings = {4, 3, 0, 1};
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--positions") == 0 && i + 1 < argc) {
+            settings.positions = static_cast<uint>(atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--repeats") == 0 && i + 1 < argc) {
+            settings.repeats = static_cast<uint>(atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--deeper") == 0 && i + 1 < argc) {
+            settings.deeper = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            settings.seed = strtoull(argv[++i], nullptr, 0);
+        } else {
+            usage();
+            return 1;
+        }
+    }
+    if (settings.positions == 0 || settings.repeats == 0) {
+        usage();
+        return 1;
+    }
+
+    printf("%u CPUs\n", std::thread::hardware_concurrency());
+    run_board<3, 3, 3>(settings, 9);
+    run_board<4, 4, 4>(settings, 10);
+    run_board<5, 5, 4>(settings, 8);
+    return 0;
+}
@@ -0,0 +1,136 @@
+#include "session_pool.hpp"
+#include "game.hpp"
+
+template <uint Rows, uint Cols, uint K>
+SessionPool<Rows, Cols, K>::SessionPool() : free_count(CAPACITY) {
+    for (uint i = 0; i < CAPACITY; i++) {
+        x[i] = 0;
+        o[i] = 0;
+        players[i] = 0;
+        cursors[i] = 0;
+        statuses[i] = SESSION_FREE;
+        // Session 0 is opened first
+        free_sessions[i] = static_cast<uint16_t>(CAPACITY - 1 - i);
+    }
+}
+
+template <uint Rows, uint Cols, uint K>
+int SessionPool<Rows, Cols, K>::open() {
+    if (free_count == 0) {
+        return -1;
+    }
+    uint session = free_sessions[--free_count];
+    statuses[session] = SESSION_PLAYING;
+    reset(session);
+    return static_cast<int>(session);
+}
+
+template <uint Rows, uint Cols, uint K>
+void SessionPool<Rows, Cols, K>::close(const uint session) {
+    if (session >= CAPACITY || statuses[session] == SESSION_FREE) {
+        return;
+    }
+    statuses[session] = SESSION_FREE;
+    free_sessions[free_count++] = static_cast<uint16_t>(session);
+}
+
+template <uint Rows, uint Cols, uint K>
+void SessionPool<Rows, Cols, K>::reset(const uint session) {
+    if (session >= CAPACITY || statuses[session] == SESSION_FREE) {
+        return;
+    }
+    x[session] = 0;
+    o[session] = 0;
+    players[session] = 0;
+    cursors[session] = 0;
+    statuses[session] = SESSION_PLAYING;
+}
+
+template <uint Rows, uint Cols, uint K>
+size_t SessionPool<Rows, Cols, K>::apply(const SessionMove *moves, const size_t count,
+                                         uint8_t *outcomes) {
+    size_t placed = 0;
+    for (size_t i = 0; i < count; i++) {
+        uint session = moves[i].session;
+        uint cell = moves[i].cell;
+        if (session >= CAPACITY || cell >= CELLS) {
+            outcomes[i] = MOVE_BAD_CELL;
+            continue;
+        }
+        if (statuses[session] != SESSION_PLAYING) {
+            outcomes[i] = MOVE_NOT_PLAYING;
+            continue;
+        }
+
+        Mask bit = static_cast<Mask>(static_cast<Mask>(1) << cell);
+        Mask occupied = static_cast<Mask>(x[session] | o[session]);
+        if (occupied & bit) {
+            outcomes[i] = MOVE_OCCUPIED;
+            continue;
+        }
+
+        // Only the player's own mask is loaded and stored
+        Mask *marks = (players[session] == 0) ? &x[session] : &o[session];
+        Mask mask = static_cast<Mask>(*marks | bit);
+        *marks = mask;
+        occupied |= bit;
+        placed++;
+
+        // Only the lines through the cell can have been completed by the move
+        const Mask *lines = Geometry::CELL_LINES[cell].data();
+        bool is_win = false;
+        for (uint line = 0; line < Geometry::CELL_LINE_COUNT[cell] && !is_win; line++) {
+            is_win = (mask & lines[line]) == lines[line];
+        }
+
+        if (is_win) {
+            statuses[session] = (players[session] == 0) ? SESSION_X_WON : SESSION_O_WON;
+            cursors[session] = static_cast<uint8_t>(cell);
+            outcomes[i] = MOVE_WON;
+        } else if (occupied == Geometry::FULL_BOARD) {
+            statuses[session] = SESSION_TIE;
+            cursors[session] = static_cast<uint8_t>(cell);
+            outcomes[i] = MOVE_TIED;
+        } else {
+            // Park the cursor on the first empty cell, as the game does
+            Mask empty = static_cast<Mask>(~occupied & Geometry::FULL_BOARD);
+            cursors[session] = static_cast<uint8_t>(__builtin_ctzll(empty));
+            players[session] ^= 1;
+            outcomes[i] = MOVE_PLACED;
+        }
+    }
+    return placed;
+}
+
+template <uint Rows, uint Cols, uint K>
+typename SessionPool<Rows, Cols, K>::Board SessionPool<Rows, Cols, K>::get_board(
+    const uint session) {
+    Board board = {x[session], o[session]};
+    return board;
+}
+
+template <uint Rows, uint Cols, uint K>
+char SessionPool<Rows, Cols, K>::get_player(const uint session) {
+    return (players[session] == 0) ? GameBase::X : GameBase::O;
+}
+
+template <uint Rows, uint Cols, uint K>
+uint SessionPool<Rows, Cols, K>::get_cursor(const uint session) {
+    return cursors[session];
+}
+
+template <uint Rows, uint Cols, uint K>
+SessionStatus SessionPool<Rows, Cols, K>::get_status(const uint session) {
+    return static_cast<SessionStatus>(statuses[session]);
+}
+
+template <uint Rows, uint Cols, uint K>
+uint SessionPool<Rows, Cols, K>::get_open_count() {
+    return CAPACITY - free_count;
+}
+
+// Supported board variants, see game.cpp
+template class SessionPool<3, 3, 3>;
+template class SessionPool<4, 4, 4>;
+template class SessionPool<5, 5, 4>;
+template class SessionPool<7, 7, 5>;
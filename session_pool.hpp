@@ -0,0 +1,112 @@
+#ifndef __SESSION_POOL_HPP__
+#define __SESSION_POOL_HPP__
+
+#include "bitboard.hpp"
+#include "pico/stdlib.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// Number of sessions a SessionPool holds
+// Each takes 2 masks and 3 bytes of state plus 2 bytes in the free list,
+// so the default of 1024 takes 9 KB of SRAM on the 3x3 board
+#ifndef SESSION_POOL_SIZE
+#define SESSION_POOL_SIZE 1024
+#endif
+
+// Status of a session in a SessionPool
+enum SessionStatus : uint8_t {
+    SESSION_FREE = 0,   // Not opened
+    SESSION_PLAYING,
+    SESSION_X_WON,
+    SESSION_O_WON,
+    SESSION_TIE
+};
+
+// Outcome of one move applied to a session
+enum MoveOutcome : uint8_t {
+    MOVE_PLACED = 0,    // The other player moves next
+    MOVE_WON,           // The move completed a line
+    MOVE_TIED,          // The move filled the board
+    MOVE_OCCUPIED,      // The cell is taken, nothing changed
+    MOVE_NOT_PLAYING,   // The session is free or its game is decided
+    MOVE_BAD_CELL       // The cell or the session is out of range
+};
+
+// Struct for storing a move for SessionPool::apply
+// @field session Index of the session
+// @field cell Cell number (row * Cols + col), for the session's player to move
+typedef struct {
+    uint16_t session;
+    uint8_t cell;
+} SessionMove;
+
+// Fixed pool of concurrent Rows x Cols, K-in-a-row games, e.g. for a
+// multi-table setup or a server for serial-connected clients
+// The state is kept as a struct of arrays, one array per field indexed by
+// the session: X masks, O masks, the player to move, the cursor and the
+// status. A pass over many sessions reads only the fields it needs, packed
+// densely, and the whole pool is allocated with its owner, without heap.
+// The rules are those of Game (win by the lines through the moved cell,
+// tie on a full board, cursor parked on the first empty cell), but there is
+// no rendering, LED or record: the caller reports the outcomes.
+// Supported variants are explicitly instantiated in session_pool.cpp
+template <uint Rows, uint Cols, uint K>
+class SessionPool {
+    public:
+        typedef BoardGeometry<Rows, Cols, K> Geometry;
+        typedef BasicBitboard<Rows * Cols> Board;
+        typedef typename Board::Mask Mask;
+        static const uint CELLS = Rows * Cols;
+        static const uint CAPACITY = SESSION_POOL_SIZE;
+
+        static_assert(CAPACITY <= 65536, "Sessions are numbered with 16 bits");
+
+        // Constructor, every session is free
+        SessionPool();
+
+        // Opens a free session with an empty board, X to move
+        // @return Index of the session, -1 if the pool is full
+        int open();
+
+        // Frees the session
+        void close(const uint session);
+
+        // Starts a new game in an open session
+        void reset(const uint session);
+
+        // Applies the moves in one pass, in their order; a session may get
+        // several, which are played in turn
+        // @param moves The moves
+        // @param count Number of moves
+        // @param outcomes Set to the MoveOutcome of each move
+        // @return Number of moves placed (MOVE_PLACED, MOVE_WON or MOVE_TIED)
+        size_t apply(const SessionMove *moves, const size_t count, uint8_t *outcomes);
+
+        // Returns the marks on the session's board
+        Board get_board(const uint session);
+
+        // Returns the character (X or O) of the session's player to move
+        char get_player(const uint session);
+
+        // Returns the cell of the session's cursor
+        uint get_cursor(const uint session);
+
+        // Returns the session's SessionStatus
+        SessionStatus get_status(const uint session);
+
+        // Returns the number of open sessions
+        uint get_open_count();
+
+    private:
+        Mask x[CAPACITY];
+        Mask o[CAPACITY];
+        uint8_t players[CAPACITY];     // 0 for X, 1 for O
+        uint8_t cursors[CAPACITY];
+        uint8_t statuses[CAPACITY];
+
+        // Stack of the free sessions, the next one to open on top
+        uint16_t free_sessions[CAPACITY];
+        uint free_count;
+};
+
+#endif  // __SESSION_POOL_HPP__
@@ -0,0 +1,328 @@
+#include "solved4.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <thread>
+#include <vector>
+
+// Retrograde solver of the 4x4 board with 4 in a row
+// Solves the 3^16 encodings layer by layer, from the full board back to the
+// empty one: the value of a position with n marks follows from those of its
+// children with n + 1, all solved in the layer before. Within a layer the
+// positions are independent, so the threads share them out by X mask, an
+// X mask at a time off an atomic counter. Only the canonical position of
+// each symmetry class is solved and stored; a child is looked up through
+// its canonical encoding. Values take 2 bits (Solved4Code), set with an
+// atomic OR and read with atomic loads, as 4 of them share a byte. The
+// result is written as a database file that Solved4::open maps and probes
+// in place
+
+namespace {
+
+// Struct for storing the counts of one solve
+// @field codes Number of canonical positions of each Solved4Code
+// @field illegal Positions skipped for a line of the side to move
+// @field seconds Wall time of the solve
+typedef struct {
+    uint64_t codes[4];
+    uint64_t illegal;
+    double seconds;
+} SolveStats;
+
+// Struct for storing the state shared by the threads while solving a layer
+// @field masks X masks of the layer
+// @field next Index of the next X mask to take
+// @field marks Number of marks of the layer's positions
+typedef struct {
+    std::vector<uint16_t> masks;
+    std::atomic<size_t> next;
+    uint marks;
+} Layer;
+
+typedef BoardGeometry<4, 4, 4> Geometry;
+
+bool has_line(const uint16_t mask) {
+    for (uint i = 0; i < Geometry::NUMBER_OF_WIN_MASKS; i++) {
+        if ((mask & Geometry::WIN_MASKS[i]) == Geometry::WIN_MASKS[i]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void store(uint8_t *data, const uint32_t index, const uint8_t code) {
+    __atomic_fetch_or(&data[index / 4], static_cast<uint8_t>(code << (2 * (index % 4))),
+                      __ATOMIC_RELAXED);
+}
+
+// Returns the code stored for the encoding, read atomically as other
+// threads OR the codes of the current layer into the same bytes
+uint8_t load(const uint8_t *data, const uint32_t index) {
+    uint8_t byte = __atomic_load_n(&data[index / 4], __ATOMIC_RELAXED);
+    return (byte >> (2 * (index % 4))) & 3;
+}
+
+// Returns the Solved4Code of the position from its children
+uint8_t solve_position(const uint8_t *data, const uint16_t x, const uint16_t o,
+                       const uint marks) {
+    const bool x_to_move = (marks % 2) == 0;
+    const uint16_t me = x_to_move ? x : o;
+    const uint16_t opp = x_to_move ? o : x;
+    if (has_line(me)) {
+        // Play stops at the first line, so the side to move can't have one
+        return SOLVED4_NONE;
+    }
+    if (has_line(opp)) {
+        return SOLVED4_LOSS;
+    }
+    const uint16_t occupied = x | o;
+    if (occupied == Geometry::FULL_BOARD) {
+        return SOLVED4_DRAW;
+    }
+
+    uint8_t best = SOLVED4_LOSS;
+    for (uint cell = 0; cell < Solved4::CELLS && best != SOLVED4_WIN; cell++) {
+        const uint16_t bit = static_cast<uint16_t>(1u << cell);
+        if (occupied & bit) {
+            continue;
+        }
+        uint32_t child = x_to_move ? Solved4::get_canonical_index(x | bit, o)
+                                   : Solved4::get_canonical_index(x, o | bit);
+        uint8_t code = load(data, child);
+        if (code == SOLVED4_LOSS) {
+            best = SOLVED4_WIN;
+        } else if (code == SOLVED4_DRAW) {
+            best = SOLVED4_DRAW;
+        }
+    }
+    return best;
+}
+
+// Solves the layer's positions of the X masks it takes
+void solve_layer(Layer *layer, uint8_t *data, SolveStats *stats) {
+    const uint o_marks = layer->marks / 2;
+    while (true) {
+        size_t i = layer->next.fetch_add(1, std::memory_order_relaxed);
+        if (i >= layer->masks.size()) {
+            return;
+        }
+        const uint16_t x = layer->masks[i];
+        const uint16_t free = static_cast<uint16_t>(~x & Geometry::FULL_BOARD);
+
+        // Every subset of the free cells with the layer's number of O marks
+        uint16_t o = free;
+        while (true) {
+            if (static_cast<uint>(__builtin_popcount(o)) == o_marks) {
+                uint32_t index = Solved4::get_index(x, o);
+                if (Solved4::get_canonical_index(x, o) == index) {
+                    uint8_t code = solve_position(data, x, o, layer->marks);
+                    if (code == SOLVED4_NONE) {
+                        stats->illegal++;
+                    } else {
+                        store(data, index, code);
+                        stats->codes[code]++;
+                    }
+                }
+            }
+            if (o == 0) {
+                break;
+            }
+            o = static_cast<uint16_t>((o - 1) & free);
+        }
+    }
+}
+
+// Solves every position on the threads
+SolveStats solve(uint8_t *data, const uint threads) {
+    memset(data, 0, Solved4::DATA_SIZE);
+    std::vector<SolveStats> thread_stats(threads);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    for (int marks = static_cast<int>(Solved4::CELLS); marks >= 0; marks--) {
+        Layer layer;
+        layer.marks = static_cast<uint>(marks);
+        layer.next.store(0);
+        for (uint mask = 0; mask <= Geometry::FULL_BOARD; mask++) {
+            if (static_cast<uint>(__builtin_popcount(mask)) == (layer.marks + 1) / 2) {
+                layer.masks.push_back(static_cast<uint16_t>(mask));
+            }
+        }
+
+        std::vector<std::thread> pool;
+        for (uint i = 1; i < threads; i++) {
+            pool.emplace_back(solve_layer, &layer, data, &thread_stats[i]);
+        }
+        solve_layer(&layer, data, &thread_stats[0]);
+        for (std::thread &thread : pool) {
+            thread.join();
+        }
+    }
+
+    SolveStats total = {};
+    total.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                                  start).count();
+    for (const SolveStats &stats : thread_stats) {
+        for (uint code = 0; code < 4; code++) {
+            total.codes[code] += stats.codes[code];
+        }
+        total.illegal += stats.illegal;
+    }
+    return total;
+}
+
+uint64_t get_canonical_count(const SolveStats &stats) {
+    return stats.codes[SOLVED4_LOSS] + stats.codes[SOLVED4_DRAW] + stats.codes[SOLVED4_WIN];
+}
+
+// Returns the peak resident memory of the process in KB
+long get_peak_kb() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+bool write_database(const char *path, const uint8_t *data, const SolveStats &stats) {
+    Solved4Header header;
+    Solved4::init_header(&header, data, get_canonical_count(stats));
+    FILE *file = fopen(path, "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    bool is_written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                      fwrite(data, 1, Solved4::DATA_SIZE, file) == Solved4::DATA_SIZE;
+    return (fclose(file) == 0) && is_written;
+}
+
+const char *get_value_name(const int value) {
+    return (value == Solved4::WIN) ? "win" : (value == Solved4::LOSS) ? "loss" : "draw";
+}
+
+// Plays the moves on the attached database and prints the value and best
+// move of the position reached
+// @return 1 if a move is illegal
+int probe(const std::vector<uint> &moves) {
+    BasicBitboard<16> board = {0, 0};
+    for (size_t i = 0; i < moves.size(); i++) {
+        uint16_t bit = static_cast<uint16_t>(1u << moves[i]);
+        if (moves[i] >= Solved4::CELLS || ((board.x | board.o) & bit)) {
+            fprintf(stderr, "Move %zu: cell %u is not free\n", i + 1, moves[i]);
+            return 1;
+        }
+        if (i % 2 == 0) {
+            board.x |= bit;
+        } else {
+            board.o |= bit;
+        }
+    }
+    for (uint row = 0; row < 4; row++) {
+        printf("  ");
+        for (uint col = 0; col < 4; col++) {
+            uint16_t bit = static_cast<uint16_t>(1u << (row * 4 + col));
+            putchar((board.x & bit) ? 'X' : (board.o & bit) ? 'O' : '.');
+        }
+        putchar('\n');
+    }
+    int value = Solved4::DRAW;
+    int cell = -1;
+    if (!Solved4::probe(board, &value, &cell)) {
+        printf("Decided or illegal position\n");
+        return 0;
+    }
+    printf("%c to move: %s, best move cell %d\n", (moves.size() % 2 == 0) ? 'X' : 'O',
+           get_value_name(value), cell);
+    return 0;
+}
+
+void print_stats(const SolveStats &stats, const uint threads) {
+    printf("Solved on %u threads in %.3f s: %llu canonical positions (%llu won, %llu drawn, "
+           "%llu lost for the side to move), %llu illegal\n", threads, stats.seconds,
+           static_cast<unsigned long long>(get_canonical_count(stats)),
+           static_cast<unsigned long long>(stats.codes[SOLVED4_WIN]),
+           static_cast<unsigned long long>(stats.codes[SOLVED4_DRAW]),
+           static_cast<unsigned long long>(stats.codes[SOLVED4_LOSS]),
+           static_cast<unsigned long long>(stats.illegal));
+}
+
+void usage() {
+    fputs("Usage: tictactoe_solve4 [--output FILE] [--threads N] [--scaling]\n"
+          "       tictactoe_solve4 --database FILE [--verify] [cell ...]\n"
+          "\n"
+          "Solves the 4x4 board with 4 in a row by retrograde analysis and writes\n"
+          "the database (default solved4.db, 10.8 MB) that tictactoe_host --database\n"
+          "and the game's Solved4::probe read. The threads default to every core;\n"
+          "--scaling solves on 1, 2, 4, ... threads and prints the speedup. The\n"
+          "peak memory is printed at the end. With --database, plays the cells\n"
+          "from the empty board, X first, and prints the value and best move of\n"
+          "the position; --verify checks the database's checksum first.\n", stderr);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    const char *output = "solved4.db";
+    const char *database = nullptr;
+    uint threads = std::max(1u, std::thread::hardware_concurrency());
+    bool is_scaling = false;
+    bool is_verify = false;
+    std::vector<uint> moves;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            output = argv[++i];
+        } else if (strcmp(argv[i], "--database") == 0 && i + 1 < argc) {
+            database = argv[++i];
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = std::max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--scaling") == 0) {
+            is_scaling = true;
+        } else if (strcmp(argv[i], "--verify") == 0) {
+            is_verify = true;
+        } else if (argv[i][0] != '-' && database != nullptr) {
+            moves.push_back(static_cast<uint>(atoi(argv[i])));
+        } else {
+            usage();
+            return 1;
+        }
+    }
+
+    if (database != nullptr) {
+        if (!Solved4::open(database)) {
+            fprintf(stderr, "Cannot map %s as a solved 4x4 database\n", database);
+            return 1;
+        }
+        if (is_verify && !Solved4::verify()) {
+            fprintf(stderr, "%s: checksum mismatch\n", database);
+            return 1;
+        }
+        return probe(moves);
+    }
+
+    std::vector<uint8_t> data(Solved4::DATA_SIZE);
+    SolveStats stats = {};
+    if (is_scaling) {
+        double base = 0.0;
+        for (uint n = 1; ; n = std::min(2 * n, threads)) {
+            stats = solve(data.data(), n);
+            base = (n == 1) ? stats.seconds : base;
+            printf("%3u threads: %8.3f s, speedup %5.2f, efficiency %5.1f%%\n", n, stats.seconds,
+                   base / stats.seconds, 100.0 * base / stats.seconds / n);
+            if (n == threads) {
+                break;
+            }
+        }
+    } else {
+        stats = solve(data.data(), threads);
+    }
+    print_stats(stats, threads);
+
+    if (!write_database(output, data.data(), stats)) {
+        fprintf(stderr, "Cannot write %s\n", output);
+        return 1;
+    }
+    printf("Wrote %s: %llu bytes of values, peak memory %ld KB\n", output,
+           static_cast<unsigned long long>(Solved4::DATA_SIZE), get_peak_kb());
+    return 0;
+}
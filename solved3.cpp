@@ -0,0 +1,222 @@
+#include "solved3.hpp"
+#include <array>
+#include <cstdint>
+
+// Positions are encoded in base 3, digit i being the content of cell i:
+// 0 = EMPTY, 1 = X, 2 = O
+static constexpr int CELLS = 9;
+static constexpr int ENCODINGS = 19683;     // 3^9
+static constexpr int NUMBER_OF_SYMMETRIES = 8;
+
+// Packed table entry: value + 1 (0 = LOSS, 1 = DRAW, 2 = WIN) in bits 4-5,
+// best move in bits 0-3
+static constexpr uint8_t VALUE_SHIFT = 4;
+static constexpr uint8_t MOVE_MASK = 0x0F;
+
+static constexpr std::array<int, CELLS> POW3 = {1, 3, 9, 27, 81, 243, 729, 2187, 6561};
+
+// Returns the cell that cell moves to under symmetry s: identity,
+// 3 rotations, 2 mirrors and 2 diagonal reflections
+static constexpr int map_cell(int s, int cell) {
+    int r = cell / 3;
+    int c = cell % 3;
+    int nr = r;
+    int nc = c;
+    switch (s) {
+        case 1: nr = c;     nc = 2 - r; break;      // Rotate 90
+        case 2: nr = 2 - r; nc = 2 - c; break;      // Rotate 180
+        case 3: nr = 2 - c; nc = r;     break;      // Rotate 270
+        case 4: nr = r;     nc = 2 - c; break;      // Mirror left-right
+        case 5: nr = 2 - r; nc = c;     break;      // Mirror top-bottom
+        case 6: nr = c;     nc = r;     break;      // Transpose
+        case 7: nr = 2 - c; nc = 2 - r; break;      // Anti-transpose
+        default: break;
+    }
+    return nr * 3 + nc;
+}
+
+typedef std::array<std::array<uint8_t, CELLS>, NUMBER_OF_SYMMETRIES> SymmetryTable;
+
+// SYMMETRY[s][cell] is the image of cell under symmetry s,
+// INVERSE_SYMMETRY[s][cell] the cell whose image is cell
+static constexpr SymmetryTable make_symmetries(bool inverse) {
+    SymmetryTable table = {};
+    for (int s = 0; s < NUMBER_OF_SYMMETRIES; s++) {
+        for (int cell = 0; cell < CELLS; cell++) {
+            if (inverse) {
+                table[s][map_cell(s, cell)] = static_cast<uint8_t>(cell);
+            } else {
+                table[s][cell] = static_cast<uint8_t>(map_cell(s, cell));
+            }
+        }
+    }
+    return table;
+}
+
+static constexpr SymmetryTable SYMMETRY = make_symmetries(false);
+static constexpr SymmetryTable INVERSE_SYMMETRY = make_symmetries(true);
+
+typedef BoardGeometry<3, 3, 3> Geometry;
+
+// Returns the smallest encoding among the 8 symmetric images of the position
+// @param symmetry Set to the symmetry producing that image
+static constexpr int canonical(uint16_t x, uint16_t o, int *symmetry) {
+    int best = -1;
+    for (int s = 0; s < NUMBER_OF_SYMMETRIES; s++) {
+        int image = 0;
+        for (int cell = 0; cell < CELLS; cell++) {
+            int d = ((x >> cell) & 1) ? 1 : ((o >> cell) & 1) ? 2 : 0;
+            image += d * POW3[SYMMETRY[s][cell]];
+        }
+        if (best < 0 || image < best) {
+            best = image;
+            *symmetry = s;
+        }
+    }
+    return best;
+}
+
+// Returns true if the move at cell completed a line in mask
+static constexpr bool is_win_at(uint16_t mask, int cell) {
+    for (int i = 0; i < Geometry::CELL_LINE_COUNT[cell]; i++) {
+        if ((mask & Geometry::CELL_LINES[cell][i]) == Geometry::CELL_LINES[cell][i]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Struct for storing the result of the compile-time solve, indexed by encoding
+// @field score Minimax score for the side to move, +/-(10 - marks at the end)
+//              for wins and losses, 0 for draws
+// @field best Best move of every undecided position
+// @field state 0 = not reached, 1 = reached and decided, 2 = reached,
+//              undecided and not canonical, 3 = reached, undecided and canonical
+// @field count Number of reachable, undecided, canonical positions
+struct Solution {
+    int8_t score[ENCODINGS];
+    int8_t best[ENCODINGS];
+    uint8_t state[ENCODINGS];
+    int count;
+};
+
+// Memoized negamax over the positions reachable from the empty board
+// Every position is solved once, after all of its children (retrograde order)
+static constexpr int search(Solution &solution, uint16_t x, uint16_t o, int code,
+                            int marks, int last_cell) {
+    if (solution.state[code] != 0) {
+        return solution.score[code];
+    }
+
+    // X moves when both players have the same number of marks
+    const bool x_to_move = (marks % 2) == 0;
+    if (last_cell >= 0 && is_win_at(x_to_move ? o : x, last_cell)) {
+        // The previous move won the game
+        solution.state[code] = 1;
+        solution.score[code] = static_cast<int8_t>(-(10 - marks));
+        return solution.score[code];
+    }
+    if (marks == CELLS) {
+        solution.state[code] = 1;
+        solution.score[code] = 0;
+        return 0;
+    }
+
+    int best_score = -100;
+    for (int cell = 0; cell < CELLS; cell++) {
+        uint16_t bit = static_cast<uint16_t>(1u << cell);
+        if ((x | o) & bit) {
+            continue;
+        }
+        int score = x_to_move
+            ? -search(solution, x | bit, o, code + POW3[cell], marks + 1, cell)
+            : -search(solution, x, o | bit, code + 2 * POW3[cell], marks + 1, cell);
+        if (score > best_score) {
+            best_score = score;
+            solution.best[code] = static_cast<int8_t>(cell);
+        }
+    }
+    solution.score[code] = static_cast<int8_t>(best_score);
+
+    int symmetry = 0;
+    if (canonical(x, o, &symmetry) == code) {
+        solution.state[code] = 3;
+        solution.count++;
+    } else {
+        solution.state[code] = 2;
+    }
+    return best_score;
+}
+
+static constexpr Solution solve() {
+    Solution solution = {};
+    search(solution, 0, 0, 0, 0, -1);
+    return solution;
+}
+
+static constexpr int ENTRY_COUNT = solve().count;
+
+// Struct for storing the packed table: sorted canonical encodings and,
+// at the same index, the packed value and best move
+struct PackedTable {
+    uint16_t keys[ENTRY_COUNT];
+    uint8_t entries[ENTRY_COUNT];
+};
+
+static constexpr PackedTable pack() {
+    // The full solution is a temporary of the compiler only, so it never
+    // reaches the binary, not even in unoptimized builds
+    const Solution solution = solve();
+    PackedTable table = {};
+    int n = 0;
+    for (int code = 0; code < ENCODINGS; code++) {
+        if (solution.state[code] == 3) {
+            int score = solution.score[code];
+            int value = (score > 0) ? Solved3::WIN : (score < 0) ? Solved3::LOSS : Solved3::DRAW;
+            table.keys[n] = static_cast<uint16_t>(code);
+            table.entries[n] = static_cast<uint8_t>(((value + 1) << VALUE_SHIFT) |
+                                                    solution.best[code]);
+            n++;
+        }
+    }
+    return table;
+}
+
+// The solved table, computed by the compiler and placed in flash (.rodata)
+static constexpr PackedTable SOLVED3_TABLE = pack();
+
+// Keep the flash footprint in check, 765 canonical positions exist in total
+static_assert(sizeof(SOLVED3_TABLE) <= 3 * 765, "Solved 3x3 table exceeds its flash budget");
+
+bool Solved3::probe(const Bitboard &board, int *value, int *best_cell) {
+    // Encode each of the 8 symmetric images and keep the smallest
+    int symmetry = 0;
+    int code = canonical(board.x, board.o, &symmetry);
+
+    // Binary search of the sorted keys, at most 10 steps
+    int lo = 0;
+    int hi = ENTRY_COUNT - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        if (SOLVED3_TABLE.keys[mid] == code) {
+            uint8_t entry = SOLVED3_TABLE.entries[mid];
+            *value = static_cast<int>(entry >> VALUE_SHIFT) - 1;
+            // Map the best move from the canonical image back onto the board
+            *best_cell = INVERSE_SYMMETRY[symmetry][entry & MOVE_MASK];
+            return true;
+        } else if (SOLVED3_TABLE.keys[mid] < code) {
+            lo = mid + 1;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    return false;
+}
+
+size_t Solved3::get_entry_count() {
+    return ENTRY_COUNT;
+}
+
+size_t Solved3::get_table_size() {
+    return sizeof(SOLVED3_TABLE);
+}
@@ -0,0 +1,34 @@
+#ifndef __SOLVED3_HPP__
+#define __SOLVED3_HPP__
+
+#include "bitboard.hpp"
+#include <stddef.h>
+#include <stdint.h>
+
+// Classic 3x3 game solved at compile time
+// Every reachable position that is not yet decided is reduced to its
+// canonical form under the 8 board symmetries (4 rotations x mirror) and
+// stored in a flash-resident table of game-theoretic value and best move
+class Solved3 {
+    public:
+        // Game-theoretic values from the side to move's point of view
+        static const int LOSS = -1;
+        static const int DRAW = 0;
+        static const int WIN = 1;
+
+        // Looks up the value and best move of the position, with X to move if
+        // both players have the same number of marks and O to move otherwise
+        // @param board The current state of the board
+        // @param value Set to LOSS, DRAW or WIN for the side to move
+        // @param best_cell Set to the cell number (0 to 8) of the best move
+        // @return false if the position is over, unreachable or illegal
+        static bool probe(const Bitboard &board, int *value, int *best_cell);
+
+        // Returns the number of canonical positions in the table
+        static size_t get_entry_count();
+
+        // Returns the flash footprint of the table in bytes
+        static size_t get_table_size();
+};
+
+#endif  // __SOLVED3_HPP__
@@ -0,0 +1,233 @@
+#include "solved4.hpp"
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+#if !PICO_ON_DEVICE
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static constexpr char MAGIC[8] = {'T', 'T', 'T', '4', 'S', 'O', 'L', 'V'};
+static constexpr int SIDE = 4;
+static constexpr uint32_t POW3_8 = 6561;
+
+typedef BoardGeometry<4, 4, 4> Geometry;
+
+// Returns the cell that cell moves to under symmetry s: identity,
+// 3 rotations, 2 mirrors and 2 diagonal reflections
+static constexpr int map_cell(int s, int cell) {
+    int r = cell / SIDE;
+    int c = cell % SIDE;
+    int nr = r;
+    int nc = c;
+    switch (s) {
+        case 1: nr = c;            nc = SIDE - 1 - r; break;   // Rotate 90
+        case 2: nr = SIDE - 1 - r; nc = SIDE - 1 - c; break;   // Rotate 180
+        case 3: nr = SIDE - 1 - c; nc = r;            break;   // Rotate 270
+        case 4: nr = r;            nc = SIDE - 1 - c; break;   // Mirror left-right
+        case 5: nr = SIDE - 1 - r; nc = c;            break;   // Mirror top-bottom
+        case 6: nr = c;            nc = r;            break;   // Transpose
+        case 7: nr = SIDE - 1 - c; nc = SIDE - 1 - r; break;   // Anti-transpose
+        default: break;
+    }
+    return nr * SIDE + nc;
+}
+
+// TRANSFORM[s][half][byte] is the image under symmetry s of the cells of
+// byte, the low (half 0) or high (half 1) 8 cells of a mask
+typedef std::array<std::array<std::array<uint16_t, 256>, 2>, Solved4::NUMBER_OF_SYMMETRIES>
+    TransformTable;
+
+static constexpr TransformTable make_transforms() {
+    TransformTable table = {};
+    for (uint s = 0; s < Solved4::NUMBER_OF_SYMMETRIES; s++) {
+        for (uint half = 0; half < 2; half++) {
+            for (uint byte = 0; byte < 256; byte++) {
+                uint16_t image = 0;
+                for (uint bit = 0; bit < 8; bit++) {
+                    if ((byte >> bit) & 1) {
+                        image |= static_cast<uint16_t>(1u << map_cell(s, half * 8 + bit));
+                    }
+                }
+                table[s][half][byte] = image;
+            }
+        }
+    }
+    return table;
+}
+
+// TRITS[byte] is the base 3 value with digit i set to bit i of byte
+static constexpr std::array<uint16_t, 256> make_trits() {
+    std::array<uint16_t, 256> table = {};
+    for (uint byte = 0; byte < 256; byte++) {
+        uint16_t value = 0;
+        for (int bit = 7; bit >= 0; bit--) {
+            value = static_cast<uint16_t>(value * 3 + ((byte >> bit) & 1));
+        }
+        table[byte] = value;
+    }
+    return table;
+}
+
+static constexpr TransformTable TRANSFORM = make_transforms();
+static constexpr std::array<uint16_t, 256> TRITS = make_trits();
+
+const Solved4Header *Solved4::header = nullptr;
+const uint8_t *Solved4::data = nullptr;
+
+static inline uint16_t transform(const uint16_t mask, const uint s) {
+    return TRANSFORM[s][0][mask & 0xFF] | TRANSFORM[s][1][mask >> 8];
+}
+
+static bool has_line(const uint16_t mask) {
+    for (uint i = 0; i < Geometry::NUMBER_OF_WIN_MASKS; i++) {
+        if ((mask & Geometry::WIN_MASKS[i]) == Geometry::WIN_MASKS[i]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+uint32_t Solved4::get_index(const uint16_t x, const uint16_t o) {
+    uint32_t xs = TRITS[x & 0xFF] + POW3_8 * TRITS[x >> 8];
+    uint32_t os = TRITS[o & 0xFF] + POW3_8 * TRITS[o >> 8];
+    return xs + 2 * os;
+}
+
+uint32_t Solved4::get_canonical_index(const uint16_t x, const uint16_t o) {
+    uint32_t best = get_index(x, o);
+    for (uint s = 1; s < NUMBER_OF_SYMMETRIES; s++) {
+        uint32_t image = get_index(transform(x, s), transform(o, s));
+        if (image < best) {
+            best = image;
+        }
+    }
+    return best;
+}
+
+uint8_t Solved4::get_code(const uint8_t *data, const uint32_t index) {
+    return (data[index / 4] >> (2 * (index % 4))) & 3;
+}
+
+uint32_t Solved4::checksum(const uint8_t *data, const size_t size) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ data[i]) * 16777619u;
+    }
+    return hash;
+}
+
+void Solved4::init_header(Solved4Header *header, const uint8_t *data, const uint64_t canonical) {
+    memset(header, 0, sizeof(*header));
+    memcpy(header->magic, MAGIC, sizeof(MAGIC));
+    header->version = VERSION;
+    header->header_size = sizeof(Solved4Header);
+    header->rows = SIDE;
+    header->cols = SIDE;
+    header->win_length = SIDE;
+    header->bits_per_position = 2;
+    header->symmetries = NUMBER_OF_SYMMETRIES;
+    header->positions = POSITIONS;
+    header->data_size = DATA_SIZE;
+    header->canonical = canonical;
+    header->checksum = checksum(data, DATA_SIZE);
+}
+
+bool Solved4::attach(const uint8_t *image, const size_t size) {
+    if (size < sizeof(Solved4Header)) {
+        return false;
+    }
+    const Solved4Header *candidate = reinterpret_cast<const Solved4Header *>(image);
+    if (memcmp(candidate->magic, MAGIC, sizeof(MAGIC)) != 0 || candidate->version != VERSION ||
+        candidate->header_size != sizeof(Solved4Header) || candidate->rows != SIDE ||
+        candidate->cols != SIDE || candidate->win_length != SIDE ||
+        candidate->bits_per_position != 2 || candidate->symmetries != NUMBER_OF_SYMMETRIES ||
+        candidate->positions != POSITIONS || candidate->data_size != DATA_SIZE ||
+        size < sizeof(Solved4Header) + DATA_SIZE) {
+        return false;
+    }
+    header = candidate;
+    data = image + sizeof(Solved4Header);
+    return true;
+}
+
+bool Solved4::open(const char *path) {
+#if PICO_ON_DEVICE
+    // No file system, and the database is larger than the flash
+    (void)path;
+    return false;
+#else
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat status;
+    if (fstat(fd, &status) != 0 || status.st_size < static_cast<off_t>(sizeof(Solved4Header))) {
+        close(fd);
+        return false;
+    }
+    size_t size = static_cast<size_t>(status.st_size);
+    void *image = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    // The mapping outlives the descriptor
+    close(fd);
+    if (image == MAP_FAILED) {
+        return false;
+    }
+    if (!attach(static_cast<const uint8_t *>(image), size)) {
+        munmap(image, size);
+        return false;
+    }
+    return true;
+#endif
+}
+
+bool Solved4::is_attached() {
+    return data != nullptr;
+}
+
+const Solved4Header *Solved4::get_header() {
+    return header;
+}
+
+bool Solved4::verify() {
+    return data != nullptr && checksum(data, DATA_SIZE) == header->checksum;
+}
+
+bool Solved4::probe(const BasicBitboard<16> &board, int *value, int *best_cell) {
+    if (data == nullptr) {
+        return false;
+    }
+    // Illegal positions are not stored, and decided ones have no move
+    const uint16_t occupied = board.x | board.o;
+    uint8_t code = get_code(data, get_canonical_index(board.x, board.o));
+    if (code == SOLVED4_NONE || occupied == Geometry::FULL_BOARD || has_line(board.x) ||
+        has_line(board.o)) {
+        return false;
+    }
+
+    // The best child is the one worst for the opponent, who moves next
+    const bool x_to_move = __builtin_popcount(board.x) == __builtin_popcount(board.o);
+    uint8_t best_code = SOLVED4_NONE;
+    for (uint cell = 0; cell < CELLS; cell++) {
+        const uint16_t bit = static_cast<uint16_t>(1u << cell);
+        if (occupied & bit) {
+            continue;
+        }
+        uint16_t x = x_to_move ? (board.x | bit) : board.x;
+        uint16_t o = x_to_move ? board.o : (board.o | bit);
+        uint8_t child = get_code(data, get_canonical_index(x, o));
+        // Children lost for the opponent first, then drawn, then won
+        uint8_t mine = (child == SOLVED4_LOSS) ? SOLVED4_WIN
+                       : (child == SOLVED4_DRAW) ? SOLVED4_DRAW
+                       : (child == SOLVED4_WIN) ? SOLVED4_LOSS : SOLVED4_NONE;
+        if (mine > best_code) {
+            best_code = mine;
+            *best_cell = static_cast<int>(cell);
+        }
+    }
+    *value = static_cast<int>(code) - static_cast<int>(SOLVED4_DRAW);
+    return best_code != SOLVED4_NONE;
+}
@@ -0,0 +1,118 @@
+#ifndef __SOLVED4_HPP__
+#define __SOLVED4_HPP__
+
+#include "bitboard.hpp"
+#include "pico/stdlib.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// Value of a position in the solved 4x4 database, 2 bits each, from the
+// side to move's point of view
+enum Solved4Code : uint8_t {
+    SOLVED4_NONE = 0,   // Illegal, or not canonical so not stored
+    SOLVED4_LOSS,
+    SOLVED4_DRAW,
+    SOLVED4_WIN
+};
+
+// Struct for storing the header of the database file (64 bytes, little-endian)
+// The packed values follow it: position i in bits 2 * (i % 4) of byte i / 4
+// @field magic "TTT4SOLV"
+// @field version Solved4::VERSION of the layout
+// @field header_size Offset of the values, sizeof(Solved4Header)
+// @field rows, cols, win_length Board variant, 4, 4 and 4
+// @field bits_per_position Bits of each value, 2
+// @field symmetries Number of board symmetries reduced, only the smallest
+//        encoding among the images of a position holds its value
+// @field positions Number of encodings, 3^16
+// @field data_size Number of bytes of values
+// @field canonical Number of legal canonical positions stored
+// @field checksum FNV-1a hash of the values
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint8_t rows;
+    uint8_t cols;
+    uint8_t win_length;
+    uint8_t bits_per_position;
+    uint32_t symmetries;
+    uint64_t positions;
+    uint64_t data_size;
+    uint64_t canonical;
+    uint32_t checksum;
+    uint8_t reserved[12];
+} Solved4Header;
+
+static_assert(sizeof(Solved4Header) == 64, "The values start 64 bytes into the file");
+
+// 4x4 game with 4 in a row, solved on the host by tictactoe_solve4
+// The database holds the value of every canonical encoding under the 8
+// board symmetries, indexed by its base 3 encoding (digit i being the
+// content of cell i: 0 = EMPTY, 1 = X, 2 = O), so a probe reads it in place
+// with no copy and no search. The best move is the child with the best value
+class Solved4 {
+    public:
+        // Game-theoretic values from the side to move's point of view, as in Solved3
+        static const int LOSS = -1;
+        static const int DRAW = 0;
+        static const int WIN = 1;
+
+        static const uint CELLS = 16;
+        static const uint NUMBER_OF_SYMMETRIES = 8;
+        static const uint32_t VERSION = 1;
+        static const uint64_t POSITIONS = 43046721;     // 3^16
+        static const uint64_t DATA_SIZE = (POSITIONS + 3) / 4;
+
+        // Uses the database image (header and values) in place, e.g. a mapped file
+        // @param image Start of the header
+        // @param size Bytes of the image
+        // @return false if the header doesn't describe this layout or the
+        //         image is too short; the previous database stays attached
+        static bool attach(const uint8_t *image, const size_t size);
+
+        // Maps the database file into memory and attaches it (host only)
+        // @return false if it can't be read or attached
+        static bool open(const char *path);
+
+        // Returns true if a database is attached
+        static bool is_attached();
+
+        // Looks up the value and best move of the position, with X to move if
+        // both players have the same number of marks and O to move otherwise
+        // @param board The current state of the board
+        // @param value Set to LOSS, DRAW or WIN for the side to move
+        // @param best_cell Set to the cell number (0 to 15) of the best move
+        // @return false if no database is attached, or the position is over
+        //         or illegal
+        static bool probe(const BasicBitboard<16> &board, int *value, int *best_cell);
+
+        // Returns the base 3 encoding of the position
+        static uint32_t get_index(const uint16_t x, const uint16_t o);
+
+        // Returns the smallest encoding among the 8 symmetric images of the position
+        static uint32_t get_canonical_index(const uint16_t x, const uint16_t o);
+
+        // Returns the Solved4Code stored for the encoding in the values
+        static uint8_t get_code(const uint8_t *data, const uint32_t index);
+
+        // Fills the header of a database with the values
+        static void init_header(Solved4Header *header, const uint8_t *data,
+                                const uint64_t canonical);
+
+        // Returns the FNV-1a hash of the bytes
+        static uint32_t checksum(const uint8_t *data, const size_t size);
+
+        // Recomputes the attached values' checksum, a pass over all of them
+        // @return true if it matches the header
+        static bool verify();
+
+        // Returns the header of the attached database, nullptr if none
+        static const Solved4Header *get_header();
+
+    private:
+        static const Solved4Header *header;
+        static const uint8_t *data;
+};
+
+#endif  // __SOLVED4_HPP__
@@ -0,0 +1,68 @@
+#ifndef __SPSC_QUEUE_HPP__
+#define __SPSC_QUEUE_HPP__
+
+#include <atomic>
+#include <stdint.h>
+
+// Lock-free single-producer, single-consumer ring buffer
+// One context (e.g. an IRQ handler or core) pushes, one other context pops.
+// Neither side ever blocks: a push into a full queue fails and is counted.
+// @tparam T Element type, copied in and out
+// @tparam N Capacity, must be a power of two
+template <typename T, uint32_t N>
+class SpscQueue {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "Capacity must be a power of two");
+
+    public:
+        // Appends item, returns false and counts a drop if the queue is full
+        // Must only be called by the producer
+        bool try_push(const T &item) {
+            uint32_t head = head_index.load(std::memory_order_relaxed);
+            if (head - tail_index.load(std::memory_order_acquire) == N) {
+                dropped++;
+                return false;
+            }
+            items[head & (N - 1)] = item;
+            // Publish the item before the new head becomes visible
+            head_index.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Removes the oldest item into item, returns false if the queue is empty
+        // Must only be called by the consumer
+        bool try_pop(T *item) {
+            uint32_t tail = tail_index.load(std::memory_order_relaxed);
+            if (head_index.load(std::memory_order_acquire) == tail) {
+                return false;
+            }
+            *item = items[tail & (N - 1)];
+            // Release the slot only after the item has been copied out
+            tail_index.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Returns true if there is nothing to pop
+        bool is_empty() const {
+            return head_index.load(std::memory_order_acquire) ==
+                   tail_index.load(std::memory_order_acquire);
+        }
+
+        // Returns the number of items currently queued
+        uint32_t get_size() const {
+            return head_index.load(std::memory_order_acquire) -
+                   tail_index.load(std::memory_order_acquire);
+        }
+
+        // Returns the number of pushes rejected because the queue was full
+        uint32_t get_dropped() const {
+            return dropped;
+        }
+
+    private:
+        T items[N];
+        std::atomic<uint32_t> head_index{0};     // Next slot to write, owned by the producer
+        std::atomic<uint32_t> tail_index{0};     // Next slot to read, owned by the consumer
+        volatile uint32_t dropped = 0;           // Written by the producer only
+};
+
+#endif  // __SPSC_QUEUE_HPP__
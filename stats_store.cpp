@@ -0,0 +1,191 @@
+#include "stats_store.hpp"
+#include "channel.hpp"
+#include "hardware/sync.h"
+#include <stddef.h>
+#include <string.h>
+
+GameStats StatsStore::stats;
+StoreStats StatsStore::store_stats;
+uint32_t StatsStore::sequence = 0;
+bool StatsStore::is_dirty = false;
+absolute_time_t StatsStore::due;
+std::atomic<uint8_t> StatsStore::park_state(PARK_NONE);
+
+const StatsStore::Snapshot *StatsStore::read_slot(const uint32_t slot) {
+    return reinterpret_cast<const Snapshot *>(XIP_BASE + REGION_OFFSET + slot * SLOT_SIZE);
+}
+
+bool StatsStore::is_erased(const uint32_t offset, const uint32_t length) {
+    const uint32_t *words = reinterpret_cast<const uint32_t *>(XIP_BASE + REGION_OFFSET + offset);
+    for (uint32_t i = 0; i < length / sizeof(uint32_t); i++) {
+        if (words[i] != 0xffffffff) {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint32_t StatsStore::crc32(const uint8_t *data, const size_t length) {
+    uint32_t crc = 0xffffffff;
+    for (size_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (uint bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xedb88320 & (0u - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+void StatsStore::init() {
+    memset(&stats, 0, sizeof(stats));
+    memset(&store_stats, 0, sizeof(store_stats));
+    sequence = 0;
+    is_dirty = false;
+
+    // The valid snapshot with the highest sequence number is the latest
+    bool is_found = false;
+    uint32_t latest = 0;
+    for (uint32_t slot = 0; slot < SLOTS; slot++) {
+        const Snapshot *snapshot = read_slot(slot);
+        if (snapshot->magic != MAGIC ||
+            crc32(reinterpret_cast<const uint8_t *>(snapshot), offsetof(Snapshot, crc)) !=
+                snapshot->crc) {
+            continue;
+        }
+        if (!is_found || snapshot->sequence > sequence) {
+            is_found = true;
+            latest = slot;
+            sequence = snapshot->sequence;
+        }
+    }
+
+    if (is_found) {
+        memcpy(&stats, &read_slot(latest)->stats, sizeof(stats));
+        store_stats.slot = (latest + 1) % SLOTS;
+    }
+}
+
+void StatsStore::record_game(const GameResult result, const uint moves) {
+    if (result == RESULT_ABANDONED) {
+        return;
+    }
+
+    for (uint player = 0; player < 2; player++) {
+        PlayerStats &results = stats.players[player];
+        if (result == RESULT_TIE) {
+            results.draws++;
+            results.streak = 0;
+        } else if ((result == RESULT_X_WIN) == (player == 0)) {
+            results.wins++;
+            results.streak++;
+            if (results.streak > results.best_streak) {
+                results.best_streak = results.streak;
+            }
+        } else {
+            results.losses++;
+            results.streak = 0;
+        }
+    }
+    stats.games++;
+    stats.total_moves += moves;
+
+    // Save once the player is likely done with the board, not in the middle
+    // of the next move
+    is_dirty = true;
+    due = make_timeout_time_ms(SAVE_DELAY_MS);
+}
+
+absolute_time_t StatsStore::save_if_due(const absolute_time_t deadline) {
+    if (!is_dirty) {
+        return deadline;
+    }
+    if (time_reached(due)) {
+        if (save()) {
+            is_dirty = false;
+            return deadline;
+        }
+        due = make_timeout_time_ms(RETRY_DELAY_MS);
+    }
+    return (absolute_time_diff_us(due, deadline) > 0) ? due : deadline;
+}
+
+bool StatsStore::save() {
+    Snapshot snapshot;
+    memset(&snapshot, 0xff, sizeof(snapshot));
+    snapshot.magic = MAGIC;
+    snapshot.sequence = sequence + 1;
+    snapshot.stats = stats;
+    snapshot.crc = crc32(reinterpret_cast<const uint8_t *>(&snapshot), offsetof(Snapshot, crc));
+
+    // A page with the snapshot in its slot and all ones elsewhere, which
+    // leaves the other slots of the page as they are
+    uint32_t slot = store_stats.slot;
+    uint8_t page[FLASH_PAGE_SIZE];
+    memset(page, 0xff, sizeof(page));
+
+    // Core 1 answers from its WFE, so it parks within microseconds
+    park_state.store(PARK_REQUESTED);
+    Message request = {};
+    request.type = MSG_FLASH_PARK;
+    bool is_sent = Channel::send(request);
+    uint64_t start = time_us_64();
+    while (is_sent && park_state.load() != PARK_PARKED) {
+        if (time_us_64() - start > PARK_TIMEOUT_US) {
+            is_sent = false;
+        }
+        tight_loop_contents();
+    }
+    if (!is_sent) {
+        // Core 1 may still park later, it leaves as soon as it sees PARK_NONE
+        park_state.store(PARK_NONE);
+        store_stats.failed_parks++;
+        return false;
+    }
+
+    uint32_t status = save_and_disable_interrupts();
+    // Skip slots torn by a power loss, and erase a sector when the log moves
+    // into it. The search ends at the next sector start at the latest
+    while (true) {
+        if (slot % SLOTS_PER_SECTOR == 0 && !is_erased(slot * SLOT_SIZE, FLASH_SECTOR_SIZE)) {
+            flash_range_erase(REGION_OFFSET + slot * SLOT_SIZE, FLASH_SECTOR_SIZE);
+            store_stats.erases++;
+        }
+        if (is_erased(slot * SLOT_SIZE, SLOT_SIZE)) {
+            break;
+        }
+        slot = (slot + 1) % SLOTS;
+    }
+    memcpy(page + (slot % SLOTS_PER_PAGE) * SLOT_SIZE, &snapshot, sizeof(snapshot));
+    flash_range_program(REGION_OFFSET + (slot - slot % SLOTS_PER_PAGE) * SLOT_SIZE, page,
+                        FLASH_PAGE_SIZE);
+    restore_interrupts(status);
+
+    park_state.store(PARK_NONE);
+
+    sequence = snapshot.sequence;
+    store_stats.saves++;
+    store_stats.slot = (slot + 1) % SLOTS;
+    return true;
+}
+
+const GameStats &StatsStore::get_stats() {
+    return stats;
+}
+
+const StoreStats &StatsStore::get_store_stats() {
+    return store_stats;
+}
+
+// In RAM, as is everything it calls while the flash is busy
+__not_in_flash("stats_store") void StatsStore::park() {
+    uint32_t status = save_and_disable_interrupts();
+    // Only core 0 can have asked, and it waits for the answer. If it gave up
+    // already, the next request or its release ends the wait
+    if (park_state.load() == PARK_REQUESTED) {
+        park_state.store(PARK_PARKED);
+        while (park_state.load() == PARK_PARKED) {
+            tight_loop_contents();
+        }
+    }
+    restore_interrupts(status);
+}
@@ -0,0 +1,143 @@
+#ifndef __STATS_STORE_HPP__
+#define __STATS_STORE_HPP__
+
+#include "move_log.hpp"
+#include "pico/stdlib.h"
+#include "pico/time.h"
+#include "hardware/flash.h"
+#include <atomic>
+#include <stdint.h>
+
+// Struct for storing one player's results
+// @field wins Games won
+// @field losses Games lost
+// @field draws Games tied
+// @field streak Wins in a row up to the last game
+// @field best_streak Longest run of wins
+typedef struct {
+    uint32_t wins;
+    uint32_t losses;
+    uint32_t draws;
+    uint16_t streak;
+    uint16_t best_streak;
+} PlayerStats;
+
+// Struct for storing the statistics kept across power cycles
+// @field players Results of X (0) and O (1)
+// @field games Decided games, abandoned ones don't count
+// @field total_moves Moves of the decided games, for the average length
+typedef struct {
+    PlayerStats players[2];
+    uint32_t games;
+    uint32_t total_moves;
+} GameStats;
+
+// Struct for storing what the store did to the flash since power-up
+// @field saves Snapshots written
+// @field erases Sectors erased
+// @field slot Slot of the next snapshot
+// @field failed_parks Saves put off because core 1 didn't park in time
+typedef struct {
+    uint32_t saves;
+    uint32_t erases;
+    uint32_t slot;
+    uint32_t failed_parks;
+} StoreStats;
+
+// Persistent game statistics in the last sectors of the on-board flash
+// The region is a log of fixed-size slots, each holding a complete snapshot
+// with a sequence number and a CRC-32. A save programs the next free slot
+// (NOR flash only clears bits, so an erased slot is all ones) and the one
+// with the highest valid sequence number wins at boot. A sector is erased
+// only when the log moves into it, which spreads the erases evenly over the
+// region: with 4 sectors of 64 slots each sector is erased once every 256
+// saves. The latest snapshot is always in another sector than the one being
+// erased, so losing power mid-save loses at most that save, and a torn slot
+// fails its CRC and is skipped.
+//
+// Programming and erasing stop the XIP flash interface, so nothing may run
+// from flash meanwhile: core 0 disables its interrupts and core 1 waits in a
+// RAM function, parked through the Channel. The save takes up to ~50 ms for
+// an erase, so it never runs in the move path: a game end only updates the
+// RAM copy, and the main loop saves SAVE_DELAY_MS later
+class StatsStore {
+    public:
+        static const uint SECTORS = 4;
+        static const uint32_t REGION_SIZE = SECTORS * FLASH_SECTOR_SIZE;
+        static const uint32_t REGION_OFFSET = PICO_FLASH_SIZE_BYTES - REGION_SIZE;
+        static const uint32_t SLOT_SIZE = 64;
+        static const uint32_t SLOTS_PER_PAGE = FLASH_PAGE_SIZE / SLOT_SIZE;
+        static const uint32_t SLOTS_PER_SECTOR = FLASH_SECTOR_SIZE / SLOT_SIZE;
+        static const uint32_t SLOTS = REGION_SIZE / SLOT_SIZE;
+        static const uint32_t MAGIC = 0x54545331;   // "TTS1"
+        static const uint32_t SAVE_DELAY_MS = 3000;
+        static const uint32_t RETRY_DELAY_MS = 1000;
+        static const uint64_t PARK_TIMEOUT_US = 100000;
+
+        static_assert(SECTORS >= 2, "The latest snapshot must survive an erase");
+
+        // Loads the latest snapshot, or starts from zero on a blank region
+        // Must be called before core 1 is launched
+        static void init();
+
+        // Counts a decided game in the RAM copy and schedules a save
+        // Cheap, called at the end of a game on the move path
+        // @param result How the game ended, abandoned games are ignored
+        // @param moves Number of moves of the game
+        static void record_game(const GameResult result, const uint moves);
+
+        // Core 0 main loop: writes the snapshot once a save is due
+        // @param deadline The loop's next wake-up time
+        // @return The earlier of deadline and the pending save
+        static absolute_time_t save_if_due(const absolute_time_t deadline);
+
+        // Returns the statistics
+        static const GameStats &get_stats();
+
+        // Returns the flash statistics
+        static const StoreStats &get_store_stats();
+
+        // Core 1: runs from RAM with interrupts disabled until core 0 has
+        // finished with the flash, answering a MSG_FLASH_PARK request
+        static void park();
+
+    private:
+        // Struct for storing a snapshot as laid out in a slot
+        typedef struct {
+            uint32_t magic;
+            uint32_t sequence;
+            GameStats stats;
+            uint32_t crc;
+        } Snapshot;
+
+        static_assert(sizeof(Snapshot) <= SLOT_SIZE, "A snapshot must fit in a slot");
+
+        // Handshake with core 1 while the flash is busy
+        enum ParkState : uint8_t {
+            PARK_NONE = 0,
+            PARK_REQUESTED,     // Core 0 sent MSG_FLASH_PARK
+            PARK_PARKED,        // Core 1 runs from RAM until released
+        };
+
+        static GameStats stats;
+        static StoreStats store_stats;
+        static uint32_t sequence;
+        static bool is_dirty;
+        static absolute_time_t due;
+        static std::atomic<uint8_t> park_state;
+
+        // Returns the slot as mapped by XIP
+        static const Snapshot *read_slot(const uint32_t slot);
+
+        // Returns true if the bytes read as erased flash
+        static bool is_erased(const uint32_t offset, const uint32_t length);
+
+        // Writes the snapshot to the next free slot, erasing its sector if needed
+        // @return false if core 1 didn't park and nothing was written
+        static bool save();
+
+        // Returns the CRC-32 of the bytes
+        static uint32_t crc32(const uint8_t *data, const size_t length);
+};
+
+#endif  // __STATS_STORE_HPP__
@@ -0,0 +1,91 @@
+// Exchanges a long sequence of messages between the simulated cores: core 0
+// sends numbered messages as fast as the queue takes them, core 1 echoes
+// each one back, and both sides check that every message arrives once and
+// in order. A full queue is retried, so nothing may be lost
+#include "channel.hpp"
+#include "pico/multicore.h"
+#include <atomic>
+#include <cstdio>
+
+namespace {
+
+const uint64_t MESSAGES = 200000;
+
+// Mismatches found by core 1, read by core 0 once the echoes are all back
+std::atomic<uint64_t> core1_failures(0);
+
+// Sends the message, retrying while the other core's queue is full
+void send(const Message &message) {
+    while (!Channel::send(message)) {
+        tight_loop_contents();
+    }
+}
+
+void core1_entry() {
+    uint64_t expected = 0;
+    while (expected < MESSAGES) {
+        Message message;
+        if (!Channel::receive(&message)) {
+            tight_loop_contents();
+            continue;
+        }
+        if (message.type != MSG_SEARCH_REQUEST || message.search.x != expected) {
+            if (core1_failures++ == 0) {
+                printf("core 1: message %llu is %llu\n", static_cast<unsigned long long>(expected),
+                       static_cast<unsigned long long>(message.search.x));
+            }
+        }
+        message.type = MSG_SEARCH_RESULT;
+        send(message);
+        expected++;
+    }
+}
+
+}  // namespace
+
+int main() {
+    multicore_launch_core1(core1_entry);
+
+    uint64_t next = 0;
+    uint64_t echoed = 0;
+    uint64_t failures = 0;
+    while (echoed < MESSAGES) {
+        // Keep both directions busy: send while there is room, then take the echoes
+        while (next < MESSAGES) {
+            Message message = {};
+            message.type = MSG_SEARCH_REQUEST;
+            message.id = static_cast<uint16_t>(next);
+            message.search.x = next;
+            message.search.o = ~next;
+            if (!Channel::send(message)) {
+                break;
+            }
+            next++;
+        }
+        Message reply;
+        while (Channel::receive(&reply)) {
+            if (reply.type != MSG_SEARCH_RESULT || reply.search.x != echoed ||
+                reply.search.o != ~echoed || reply.id != static_cast<uint16_t>(echoed)) {
+                if (failures++ == 0) {
+                    printf("core 0: echo %llu is %llu\n", static_cast<unsigned long long>(echoed),
+                           static_cast<unsigned long long>(reply.search.x));
+                }
+            }
+            echoed++;
+        }
+        tight_loop_contents();
+    }
+
+    failures += core1_failures;
+    for (uint core = 0; core < EventLoop::NUMBER_OF_CORES; core++) {
+        ChannelStats stats = Channel::get_stats(core);
+        printf("to core %u: %u sent, %u received, %u full, %u doorbells skipped\n", core,
+               stats.sent, stats.received, stats.dropped, stats.doorbells_skipped);
+        if (stats.sent != MESSAGES || stats.received != MESSAGES) {
+            failures++;
+        }
+    }
+    printf("%llu messages each way, %llu failures\n", static_cast<unsigned long long>(MESSAGES),
+           static_cast<unsigned long long>(failures));
+    return (failures == 0) ? 0 : 1;
+}
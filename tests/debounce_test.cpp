@@ -0,0 +1,144 @@
+// Runs Input's debounce on the simulator against scripted button edges and
+// checks the events it reports: a bouncing edge is one event, a press and
+// release that both fall in the lockout are dropped, and the button works
+// again once the lockout ends
+#include "input.hpp"
+#include "sim.hpp"
+#include "hardware/gpio.h"
+#include "hardware/sync.h"
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+
+const uint PINS[Input::NUMBER_OF_BUTTONS] = {2, 3, 4};
+const uint DEBOUNCE_MS = 30;
+
+// Time between two bounces of the contacts
+const uint64_t BOUNCE_US = 200;
+
+// Latest time after its edge at which an event may be reported
+const uint64_t SLACK_US = 1000;
+
+// Struct for storing one scripted edge of button 0
+// @field at_us Time of the edge
+// @field is_pressed Level the button settles to
+// @field bounces Number of extra edges before it settles
+typedef struct {
+    uint64_t at_us;
+    bool is_pressed;
+    uint bounces;
+} ScriptedEdge;
+
+const ScriptedEdge SCRIPT[] = {
+    // A press and a release that each bounce 5 times: one event each
+    {10000, true, 5},
+    {100000, false, 5},
+    // A short tap: its release falls in the lockout and is reported as the
+    // lockout ends, a second press and release also in the lockout is lost
+    {200000, true, 0},
+    {205000, false, 0},
+    {210000, true, 0},
+    {215000, false, 0},
+    // A press after the lockout is taken again
+    {300000, true, 0},
+    {400000, false, 0},
+};
+
+const BtnEvent EXPECTED[] = {
+    {0, true, 10000},
+    {0, false, 100000},
+    {0, true, 200000},
+    {0, false, 200000 + DEBOUNCE_MS * 1000},
+    {0, true, 300000},
+    {0, false, 400000},
+};
+
+const size_t NUMBER_OF_EXPECTED = sizeof(EXPECTED) / sizeof(EXPECTED[0]);
+
+BtnEvent events[2 * NUMBER_OF_EXPECTED];
+size_t number_of_events = 0;
+
+int firmware_main() {
+    for (uint pin : PINS) {
+        gpio_init(pin);
+        gpio_set_dir(pin, GPIO_IN);
+        gpio_pull_up(pin);
+    }
+    Input::init(PINS, DEBOUNCE_MS);
+
+    // Sleeps until the next edge or alarm, the simulator ends the run once
+    // none is left
+    while (true) {
+        uint32_t status = save_and_disable_interrupts();
+        if (!Input::has_events()) {
+            __wfi();
+        }
+        restore_interrupts(status);
+
+        BtnEvent event;
+        while (Input::pop_event(&event)) {
+            if (number_of_events < sizeof(events) / sizeof(events[0])) {
+                events[number_of_events] = event;
+            }
+            number_of_events++;
+        }
+    }
+}
+
+void check() {
+    int failures = 0;
+    for (size_t i = 0; i < number_of_events || i < NUMBER_OF_EXPECTED; i++) {
+        if (i >= NUMBER_OF_EXPECTED) {
+            printf("unexpected event %zu\n", i);
+            failures++;
+            continue;
+        }
+        const BtnEvent &expected = EXPECTED[i];
+        if (i >= number_of_events) {
+            printf("event %zu missing: %s at %llu us\n", i,
+                   expected.is_pressed ? "press" : "release",
+                   static_cast<unsigned long long>(expected.edge_us));
+            failures++;
+            continue;
+        }
+        const BtnEvent &event = events[i];
+        bool is_on_time = event.edge_us >= expected.edge_us &&
+                          event.edge_us <= expected.edge_us + SLACK_US;
+        printf("event %zu: button %u %s at %llu us\n", i, event.button,
+               event.is_pressed ? "press" : "release",
+               static_cast<unsigned long long>(event.edge_us));
+        if (event.button != expected.button || event.is_pressed != expected.is_pressed ||
+            !is_on_time) {
+            printf("  expected button %u %s at %llu us\n", expected.button,
+                   expected.is_pressed ? "press" : "release",
+                   static_cast<unsigned long long>(expected.edge_us));
+            failures++;
+        }
+    }
+    printf("%zu events, %d failures\n", number_of_events, failures);
+    fflush(stdout);
+    if (failures != 0) {
+        _Exit(1);
+    }
+}
+
+}  // namespace
+
+int main() {
+    uint64_t end_us = 0;
+    for (const ScriptedEdge &edge : SCRIPT) {
+        // Active-low buttons: pressed reads LOW
+        bool level = !edge.is_pressed;
+        for (uint i = 0; i < edge.bounces; i++) {
+            Sim::drive_at(edge.at_us + 2 * i * BOUNCE_US, PINS[0], level);
+            Sim::drive_at(edge.at_us + (2 * i + 1) * BOUNCE_US, PINS[0], !level);
+        }
+        Sim::drive_at(edge.at_us + 2 * edge.bounces * BOUNCE_US, PINS[0], level);
+        end_us = edge.at_us + 2 * edge.bounces * BOUNCE_US;
+    }
+    Sim::set_end_time(end_us + 2 * DEBOUNCE_MS * 1000);
+    Sim::on_finish(check);
+    Sim::run(firmware_main);
+    return 0;
+}
@@ -0,0 +1,145 @@
+// Overflows the output ring with numbered frames while a second thread, as
+// core 1, drains it, under OUTPUT_DROP_OLDEST. Frames may be lost, and the
+// first one after an overrun may be cut, but every frame the sink receives
+// after a line start must be intact: a byte torn from a newer frame shows
+// as a bad payload. Built with a small ring, so that core 0 laps core 1
+#include "output.hpp"
+#include "pico/multicore.h"
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+const uint32_t FRAMES = 2000000;
+
+// Payload bytes of a frame: 1 to MAX_PAYLOAD, so frames don't line up with the ring
+const uint32_t MAX_PAYLOAD = 61;
+
+std::atomic<bool> is_written(false);
+std::atomic<bool> is_drained(false);
+
+// Struct for storing what the sink has seen, touched by core 1 only
+// @field line The line being received
+// @field length Bytes of it so far
+// @field is_cut Whether the line started before an overrun, so it is not checked
+// @field overruns Overruns already accounted for
+// @field frames Intact frames received
+// @field skipped Frames lost between two received ones
+// @field cut Lines cut by an overrun
+// @field failures Torn or out of order frames
+// @field next Number of the next frame expected
+typedef struct {
+    char line[16 + MAX_PAYLOAD];
+    uint32_t length;
+    bool is_cut;
+    uint32_t overruns;
+    uint32_t frames;
+    uint32_t skipped;
+    uint32_t cut;
+    uint32_t failures;
+    uint32_t next;
+} Received;
+
+Received received = {};
+
+char payload_byte(const uint32_t frame, const uint32_t i) {
+    return static_cast<char>('a' + (frame + i) % 26);
+}
+
+// Writes frame number n as "nnnnnnnn:payload\n"
+uint32_t format_frame(const uint32_t n, char *frame) {
+    uint32_t length = static_cast<uint32_t>(snprintf(frame, 10, "%08x:", n));
+    uint32_t payload = 1 + n % MAX_PAYLOAD;
+    for (uint32_t i = 0; i < payload; i++) {
+        frame[length++] = payload_byte(n, i);
+    }
+    frame[length++] = '\n';
+    return length;
+}
+
+void check_line(Received *state) {
+    char expected[sizeof(state->line)];
+    uint32_t n = static_cast<uint32_t>(strtoul(state->line, nullptr, 16));
+    uint32_t length = format_frame(n, expected);
+    if (length != state->length || memcmp(expected, state->line, length) != 0 ||
+        n < state->next) {
+        if (state->failures++ < 5) {
+            printf("torn or out of order frame after %08x: %.*s", state->next,
+                   static_cast<int>(state->length), state->line);
+        }
+        return;
+    }
+    state->skipped += n - state->next;
+    state->next = n + 1;
+    state->frames++;
+}
+
+void sink(const char *data, size_t length) {
+    Received *state = &received;
+    // Bytes were skipped since the last call: the line in progress is cut
+    uint32_t overruns = Output::get_stats().overruns;
+    if (overruns != state->overruns) {
+        state->overruns = overruns;
+        state->is_cut = true;
+    }
+
+    for (size_t i = 0; i < length; i++) {
+        if (state->length == sizeof(state->line)) {
+            // No frame is that long
+            if (!state->is_cut) {
+                state->failures++;
+            }
+            state->is_cut = true;
+            state->length = 0;
+        }
+        state->line[state->length++] = data[i];
+        if (data[i] != '\n') {
+            continue;
+        }
+        if (state->is_cut) {
+            state->cut++;
+        } else {
+            check_line(state);
+        }
+        state->is_cut = false;
+        state->length = 0;
+    }
+}
+
+void core1_entry() {
+    while (!is_written.load()) {
+        Output::drain();
+        tight_loop_contents();
+    }
+    Output::drain();
+    is_drained.store(true);
+}
+
+}  // namespace
+
+int main() {
+    Output::set_sink(sink);
+    Output::set_policy(OUTPUT_DROP_OLDEST);
+    Output::start_draining();
+    multicore_launch_core1(core1_entry);
+
+    char frame[sizeof(received.line)];
+    for (uint32_t n = 0; n < FRAMES; n++) {
+        Output::write(frame, format_frame(n, frame), true);
+    }
+    is_written.store(true);
+    while (!is_drained.load()) {
+        tight_loop_contents();
+    }
+
+    OutputStats stats = Output::get_stats();
+    printf("%u frames written: %u intact, %u lost, %u cut by %u overruns, %u torn\n", FRAMES,
+           received.frames, received.skipped, received.cut, stats.overruns, received.failures);
+    // The last frame is never overwritten
+    bool is_complete = received.next == FRAMES;
+    if (!is_complete) {
+        printf("the last frame received is %08x\n", received.next - 1);
+    }
+    return (received.failures == 0 && is_complete && received.frames > 0) ? 0 : 1;
+}
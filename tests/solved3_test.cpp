@@ -0,0 +1,122 @@
+// Checks Solved3 against an independent solve: every position reachable from
+// the empty board is solved again with plain negamax (no memo, no
+// symmetries) and must get the value that Solved3::probe returns, and the
+// probed best move must keep that value
+#include "solved3.hpp"
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+typedef BoardGeometry<3, 3, 3> Geometry;
+
+// Struct for storing the test's tallies
+// @field positions Undecided positions probed
+// @field finished Decided positions, which the table must not hold
+// @field failures Mismatches found
+// @field seen Positions already checked, indexed by x << 9 | o
+typedef struct {
+    int positions;
+    int finished;
+    int failures;
+    std::vector<bool> seen;
+} Tally;
+
+bool is_win(const uint16_t mask) {
+    for (uint16_t line : Geometry::WIN_MASKS) {
+        if ((mask & line) == line) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Returns the value of the position for the side to move, whose marks are
+// mine: WIN, DRAW or LOSS, the previous move must not have won
+int negamax(const uint16_t mine, const uint16_t theirs) {
+    if ((mine | theirs) == Geometry::FULL_BOARD) {
+        return Solved3::DRAW;
+    }
+    int best = Solved3::LOSS;
+    for (unsigned int cell = 0; cell < Geometry::CELLS && best != Solved3::WIN; cell++) {
+        uint16_t bit = static_cast<uint16_t>(1u << cell);
+        if ((mine | theirs) & bit) {
+            continue;
+        }
+        int value = is_win(mine | bit) ? Solved3::WIN : -negamax(theirs, mine | bit);
+        if (value > best) {
+            best = value;
+        }
+    }
+    return best;
+}
+
+// Checks the position, then every position reachable from it
+void visit(const Bitboard &board, const bool is_x_to_move, Tally *tally) {
+    const unsigned int index = (static_cast<unsigned int>(board.x) << Geometry::CELLS) | board.o;
+    if (tally->seen[index]) {
+        return;
+    }
+    tally->seen[index] = true;
+
+    const uint16_t mine = is_x_to_move ? board.x : board.o;
+    const uint16_t theirs = is_x_to_move ? board.o : board.x;
+    int value = 0;
+    int best_cell = 0;
+    bool is_found = Solved3::probe(board, &value, &best_cell);
+
+    if (is_win(theirs) || (mine | theirs) == Geometry::FULL_BOARD) {
+        tally->finished++;
+        if (is_found) {
+            printf("x %03x o %03x: finished, but probed\n", board.x, board.o);
+            tally->failures++;
+        }
+        return;
+    }
+
+    tally->positions++;
+    int expected = negamax(mine, theirs);
+    uint16_t bit = static_cast<uint16_t>(1u << best_cell);
+    if (!is_found) {
+        printf("x %03x o %03x: not found\n", board.x, board.o);
+        tally->failures++;
+    } else if (value != expected) {
+        printf("x %03x o %03x: value %d, negamax %d\n", board.x, board.o, value, expected);
+        tally->failures++;
+    } else if (best_cell < 0 || best_cell >= static_cast<int>(Geometry::CELLS) ||
+               ((mine | theirs) & bit)) {
+        printf("x %03x o %03x: best cell %d is not free\n", board.x, board.o, best_cell);
+        tally->failures++;
+    } else {
+        int move_value = is_win(mine | bit) ? Solved3::WIN : -negamax(theirs, mine | bit);
+        if (move_value != value) {
+            printf("x %03x o %03x: best cell %d has value %d, not %d\n", board.x, board.o,
+                   best_cell, move_value, value);
+            tally->failures++;
+        }
+    }
+
+    for (unsigned int cell = 0; cell < Geometry::CELLS; cell++) {
+        uint16_t free_bit = static_cast<uint16_t>(1u << cell);
+        if ((mine | theirs) & free_bit) {
+            continue;
+        }
+        Bitboard child = board;
+        if (is_x_to_move) {
+            child.x |= free_bit;
+        } else {
+            child.o |= free_bit;
+        }
+        visit(child, !is_x_to_move, tally);
+    }
+}
+
+}  // namespace
+
+int main() {
+    Tally tally = {0, 0, 0, std::vector<bool>(1u << (2 * Geometry::CELLS))};
+    visit(Bitboard{0, 0}, true, &tally);
+    printf("%d undecided and %d finished positions, %d failures\n",
+           tally.positions, tally.finished, tally.failures);
+    return (tally.failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,134 @@
+// Checks a database written by tictactoe_solve4 against an independent
+// solve: random positions reachable from the empty board are solved again
+// with plain negamax (no memo, no symmetries) and must get the value that
+// Solved4::probe returns, and the probed best move must keep that value.
+// The positions have at least MIN_MARKS marks, so that the plain search
+// stays small
+#include "solved4.hpp"
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+
+typedef BoardGeometry<4, 4, 4> Geometry;
+
+const unsigned int SAMPLES = 10000;
+const unsigned int MIN_MARKS = 8;
+
+bool is_win(const uint16_t mask) {
+    for (uint16_t line : Geometry::WIN_MASKS) {
+        if ((mask & line) == line) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Returns the value of the position for the side to move, whose marks are
+// mine: WIN, DRAW or LOSS, the previous move must not have won
+int negamax(const uint16_t mine, const uint16_t theirs) {
+    if ((mine | theirs) == Geometry::FULL_BOARD) {
+        return Solved4::DRAW;
+    }
+    int best = Solved4::LOSS;
+    for (unsigned int cell = 0; cell < Geometry::CELLS && best != Solved4::WIN; cell++) {
+        uint16_t bit = static_cast<uint16_t>(1u << cell);
+        if ((mine | theirs) & bit) {
+            continue;
+        }
+        int value = is_win(mine | bit) ? Solved4::WIN : -negamax(theirs, mine | bit);
+        if (value > best) {
+            best = value;
+        }
+    }
+    return best;
+}
+
+uint32_t next_random(uint32_t *state) {
+    // xorshift32
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return *state;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    if (argc != 2) {
+        fprintf(stderr, "Usage: solved4_test DATABASE\n");
+        return 2;
+    }
+    if (!Solved4::open(argv[1]) || !Solved4::verify()) {
+        fprintf(stderr, "Cannot use %s as a solved 4x4 database\n", argv[1]);
+        return 2;
+    }
+
+    int failures = 0;
+    int value = 0;
+    int best_cell = 0;
+    // The empty board is a known draw
+    if (!Solved4::probe(BasicBitboard<16>{0, 0}, &value, &best_cell) || value != Solved4::DRAW) {
+        printf("empty board: not a draw\n");
+        failures++;
+    }
+
+    uint32_t random = 0x5eed4444;
+    unsigned int samples = 0;
+    while (samples < SAMPLES) {
+        // A random game of MIN_MARKS to CELLS - 1 marks, unless a line ends it first
+        BasicBitboard<16> board = {0, 0};
+        unsigned int marks = MIN_MARKS + next_random(&random) % (Geometry::CELLS - MIN_MARKS);
+        bool is_over = false;
+        for (unsigned int mark = 0; mark < marks && !is_over; mark++) {
+            uint16_t free = static_cast<uint16_t>(~(board.x | board.o) & Geometry::FULL_BOARD);
+            unsigned int skip = next_random(&random) % __builtin_popcount(free);
+            while (skip-- > 0) {
+                free &= static_cast<uint16_t>(free - 1);
+            }
+            uint16_t bit = static_cast<uint16_t>(free & -free);
+            uint16_t *mask = (mark % 2 == 0) ? &board.x : &board.o;
+            *mask |= bit;
+            is_over = is_win(*mask);
+        }
+        if (is_over) {
+            // Decided positions are not probed
+            if (Solved4::probe(board, &value, &best_cell)) {
+                printf("x %04x o %04x: finished, but probed\n", board.x, board.o);
+                failures++;
+            }
+            continue;
+        }
+
+        samples++;
+        const bool is_x_to_move = (marks % 2) == 0;
+        const uint16_t mine = is_x_to_move ? board.x : board.o;
+        const uint16_t theirs = is_x_to_move ? board.o : board.x;
+        int expected = negamax(mine, theirs);
+        if (!Solved4::probe(board, &value, &best_cell)) {
+            printf("x %04x o %04x: not found\n", board.x, board.o);
+            failures++;
+            continue;
+        }
+        uint16_t bit = static_cast<uint16_t>(1u << (best_cell & 15));
+        if (value != expected) {
+            printf("x %04x o %04x: value %d, negamax %d\n", board.x, board.o, value, expected);
+            failures++;
+        } else if (best_cell < 0 || best_cell >= static_cast<int>(Geometry::CELLS) ||
+                   ((mine | theirs) & bit)) {
+            printf("x %04x o %04x: best cell %d is not free\n", board.x, board.o, best_cell);
+            failures++;
+        } else {
+            int move_value = is_win(mine | bit) ? Solved4::WIN : -negamax(theirs, mine | bit);
+            if (move_value != value) {
+                printf("x %04x o %04x: best cell %d has value %d, not %d\n", board.x, board.o,
+                       best_cell, move_value, value);
+                failures++;
+            }
+        }
+    }
+
+    printf("%u positions with %u to %u marks, %d failures\n", samples, MIN_MARKS,
+           Geometry::CELLS - 1, failures);
+    return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,167 @@
+// Saves the statistics on the simulator's flash until the log has wrapped
+// around its region twice, with core 1 parking through the Channel as in
+// the firmware. Every sector must be erased only when the log moves into it,
+// and init() must find the latest snapshot again, or the one before it once
+// the latest is torn by a save cut short or lost to an erase without its
+// program
+#include "stats_store.hpp"
+#include "channel.hpp"
+#include "sim.hpp"
+#include "hardware/flash.h"
+#include "hardware/sync.h"
+#include "pico/multicore.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+// Enough saves to wrap twice, the last one opens sector 0 again
+const uint32_t SAVES = 2 * StatsStore::SLOTS + 1;
+
+int failures = 0;
+
+// The result and length of game i
+GameResult get_result(const uint32_t game) {
+    const GameResult RESULTS[] = {RESULT_X_WIN, RESULT_O_WIN, RESULT_TIE};
+    return RESULTS[game % 3];
+}
+
+uint get_moves(const uint32_t game) {
+    return 5 + game % 5;
+}
+
+void expect(const bool is_true, const char *what) {
+    if (!is_true) {
+        printf("failed: %s\n", what);
+        failures++;
+    }
+}
+
+// Checks the statistics loaded by init() against the first games played
+void expect_games(const uint32_t games, const char *what) {
+    uint32_t wins = 0;
+    uint32_t total_moves = 0;
+    for (uint32_t game = 0; game < games; game++) {
+        wins += (get_result(game) == RESULT_X_WIN) ? 1 : 0;
+        total_moves += get_moves(game);
+    }
+    const GameStats &stats = StatsStore::get_stats();
+    printf("%s: %u games, %u X wins, %u moves\n", what, static_cast<unsigned>(stats.games),
+           static_cast<unsigned>(stats.players[0].wins),
+           static_cast<unsigned>(stats.total_moves));
+    expect(stats.games == games && stats.players[0].wins == wins &&
+           stats.total_moves == total_moves, what);
+}
+
+// Plays game i and waits for its save, retrying if core 1 was late to park
+void play_and_save(const uint32_t game) {
+    uint32_t saves = StatsStore::get_store_stats().saves;
+    StatsStore::record_game(get_result(game), get_moves(game));
+    while (StatsStore::get_store_stats().saves == saves) {
+        sleep_ms(StatsStore::SAVE_DELAY_MS);
+        StatsStore::save_if_due(at_the_end_of_time);
+    }
+}
+
+// Programs a page that clears a word in the middle of the slot, as a save
+// cut short leaves it
+void tear_slot(const uint32_t slot) {
+    uint8_t page[FLASH_PAGE_SIZE];
+    memset(page, 0xff, sizeof(page));
+    memset(page + (slot % StatsStore::SLOTS_PER_PAGE) * StatsStore::SLOT_SIZE +
+           StatsStore::SLOT_SIZE / 2, 0, sizeof(uint32_t));
+    uint32_t status = save_and_disable_interrupts();
+    flash_range_program(StatsStore::REGION_OFFSET +
+                        (slot - slot % StatsStore::SLOTS_PER_PAGE) * StatsStore::SLOT_SIZE,
+                        page, FLASH_PAGE_SIZE);
+    restore_interrupts(status);
+}
+
+// Erases the sector, as a save cut short after its erase leaves it
+void erase_sector(const uint32_t sector) {
+    uint32_t status = save_and_disable_interrupts();
+    flash_range_erase(StatsStore::REGION_OFFSET + sector * FLASH_SECTOR_SIZE, FLASH_SECTOR_SIZE);
+    restore_interrupts(status);
+}
+
+// Answers the park requests as the firmware's core 1 does
+void core1_entry() {
+    while (true) {
+        Message message;
+        while (Channel::receive(&message)) {
+            if (message.type == MSG_FLASH_PARK) {
+                StatsStore::park();
+            }
+        }
+        __wfe();
+    }
+}
+
+int firmware_main() {
+    // A blank region starts from zero
+    StatsStore::init();
+    expect_games(0, "blank region");
+    multicore_launch_core1(core1_entry);
+
+    // Nothing is erased on the first pass, then each sector once per pass
+    // as the log enters it
+    uint32_t erases = 0;
+    for (uint32_t game = 0; game < SAVES; game++) {
+        if (game >= StatsStore::SLOTS && game % StatsStore::SLOTS_PER_SECTOR == 0) {
+            erases++;
+        }
+        play_and_save(game);
+    }
+    const StoreStats &store_stats = StatsStore::get_store_stats();
+    printf("%u saves, %u erases, %u failed parks\n", static_cast<unsigned>(store_stats.saves),
+           static_cast<unsigned>(store_stats.erases),
+           static_cast<unsigned>(store_stats.failed_parks));
+    expect(store_stats.saves == SAVES, "one save per game");
+    expect(store_stats.erases == erases, "erases when the log enters a sector");
+    expect(Sim::get_stats().flash_erases == erases, "flash erases match the store's");
+    expect(store_stats.slot == SAVES % StatsStore::SLOTS, "next slot");
+
+    StatsStore::init();
+    expect_games(SAVES, "latest snapshot");
+    expect(StatsStore::get_store_stats().slot == SAVES % StatsStore::SLOTS, "next slot at boot");
+
+    // The latest snapshot is the first of sector 0, the one before it is
+    // the last of sector 3
+    uint32_t latest = (SAVES - 1) % StatsStore::SLOTS;
+    tear_slot(latest);
+    StatsStore::init();
+    expect_games(SAVES - 1, "torn latest snapshot");
+
+    // The next save erases the sector of the torn slot again and takes it
+    play_and_save(SAVES - 1);
+    expect(StatsStore::get_store_stats().erases == 1, "torn sector erased");
+    expect(StatsStore::get_store_stats().slot == (latest + 1) % StatsStore::SLOTS,
+           "torn slot reused");
+    StatsStore::init();
+    expect_games(SAVES, "saved after a torn snapshot");
+
+    // A save that erased its sector and lost power before programming
+    erase_sector(latest / StatsStore::SLOTS_PER_SECTOR);
+    StatsStore::init();
+    expect_games(SAVES - 1, "blank latest sector");
+    expect(StatsStore::get_store_stats().slot == latest, "next slot in the blank sector");
+
+    return 0;
+}
+
+void check() {
+    printf("%d failures\n", failures);
+    fflush(stdout);
+    if (failures != 0) {
+        _Exit(1);
+    }
+}
+
+}  // namespace
+
+int main() {
+    Sim::on_finish(check);
+    Sim::run(firmware_main);
+    return 0;
+}
@@ -0,0 +1,98 @@
+#ifndef __TEXT_HPP__
+#define __TEXT_HPP__
+
+#include "output.hpp"
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+
+// End of a line of text. The firmware's stdio sends bytes as they are, so
+// that the binary records and frames keep their 0x0a bytes, and a serial
+// terminal needs the carriage return spelled out
+#define TEXT_NEWLINE "\r\n"
+
+// Checks the arguments against the printf-style format at compile time
+// (-Wformat), the indexes count the implicit this pointer as 1
+#define TEXT_FORMAT_CHECK(format_index, first_arg) \
+    __attribute__((format(printf, format_index, first_arg)))
+
+// Fixed-size text buffer formatted in place
+// Replaces iostreams: no heap, no locale and no static initialization, the
+// text always fits in Size bytes and is cut off (and flagged) if longer
+template <size_t Size>
+class TextBuffer {
+    public:
+        // Constructor, starts out empty
+        TextBuffer() : length(0), is_cut(false) {
+            text[0] = '\0';
+        }
+
+        // Replaces the contents with the formatted text
+        // @return The buffer, for chaining
+        TextBuffer &format(const char *fmt, ...) TEXT_FORMAT_CHECK(2, 3) {
+            clear();
+            va_list args;
+            va_start(args, fmt);
+            append_args(fmt, args);
+            va_end(args);
+            return *this;
+        }
+
+        // Appends the formatted text
+        // @return The buffer, for chaining
+        TextBuffer &append(const char *fmt, ...) TEXT_FORMAT_CHECK(2, 3) {
+            va_list args;
+            va_start(args, fmt);
+            append_args(fmt, args);
+            va_end(args);
+            return *this;
+        }
+
+        // Empties the buffer
+        void clear() {
+            length = 0;
+            is_cut = false;
+            text[0] = '\0';
+        }
+
+        // Queues the text for stdout in one write (see Output)
+        void write() const {
+            Output::write(text, length);
+        }
+
+        // Returns the NUL-terminated text
+        const char *c_str() const {
+            return text;
+        }
+
+        // Returns the length of the text
+        size_t size() const {
+            return length;
+        }
+
+        // Returns true if some text didn't fit and was cut off
+        bool is_truncated() const {
+            return is_cut;
+        }
+
+    private:
+        char text[Size];
+        size_t length;
+        bool is_cut;
+
+        void append_args(const char *fmt, va_list args) {
+            int n = vsnprintf(text + length, Size - length, fmt, args);
+            if (n < 0) {
+                text[length] = '\0';
+                return;
+            }
+            if (static_cast<size_t>(n) >= Size - length) {
+                length = Size - 1;
+                is_cut = true;
+            } else {
+                length += static_cast<size_t>(n);
+            }
+        }
+};
+
+#endif  // __TEXT_HPP__
@@ -0,0 +1,474 @@
+#include "game.hpp"
+#include "solved3.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Self-play tournament runner
+// Plays large numbers of games between two player policies with the game's
+// own rules (is_win, is_tie, get_new_player), sharded over every CPU core.
+// The games are cut into chunks, dealt out to the threads up front, and a
+// thread that runs out steals half of the remaining chunks of another. Each
+// chunk seeds the RNG of the thread that plays it from the tournament seed
+// and the chunk number, so the results only depend on the seed, not on the
+// number of threads or on who stole what. Every thread counts into its own
+// statistics, which are merged once the threads are done
+
+namespace {
+
+// Games per chunk, the unit of work stealing
+const uint64_t CHUNK_GAMES = 1024;
+
+// Maximum number of threads
+const uint MAX_THREADS = 256;
+
+typedef TicTacToe::Board Board;
+typedef TicTacToe::Mask Mask;
+
+// How a player chooses its moves
+enum Policy {
+    POLICY_RANDOM,      // Any empty cell
+    POLICY_HEURISTIC,   // Win if possible, else block, else the most central cell
+    POLICY_PERFECT      // The solved table's best move (3x3 only)
+};
+
+// xorshift64* generator, one per thread so drawing numbers never contends
+// @field state Non-zero generator state
+typedef struct {
+    uint64_t state;
+} Rng;
+
+// Struct for storing the results counted by one thread
+// @field x_wins Games won by X
+// @field o_wins Games won by O
+// @field draws Games tied
+// @field lengths Number of games that ended after the given number of moves
+// @field games Games played by the thread
+// @field steals Number of times the thread stole work from another
+// @field busy_ns Time the thread spent working
+typedef struct {
+    uint64_t x_wins;
+    uint64_t o_wins;
+    uint64_t draws;
+    uint64_t lengths[TicTacToe::CELLS + 1];
+    uint64_t games;
+    uint64_t steals;
+    uint64_t busy_ns;
+} TournamentStats;
+
+// Struct for storing the state of one worker thread, a cache line apart from
+// the others so counting never bounces lines between cores
+// @field range Chunks left to the worker: first in the low, end in the high 32 bits
+// @field stats The worker's results
+typedef struct alignas(64) {
+    std::atomic<uint64_t> range;
+    TournamentStats stats;
+} Worker;
+
+// Struct for storing the settings of a tournament
+// @field x_policy Policy of player X
+// @field o_policy Policy of player O
+// @field games Number of games to play
+// @field seed Seed of the chunks' RNGs
+typedef struct {
+    Policy x_policy;
+    Policy o_policy;
+    uint64_t games;
+    uint64_t seed;
+} Tournament;
+
+// Only the game's pure rule functions are called, so all threads share it
+TicTacToe game;
+Worker workers[MAX_THREADS];
+
+const char *POLICY_NAMES[] = {"random", "heuristic", "perfect"};
+
+// splitmix64 finalizer, turns the seed and chunk number into an RNG state
+uint64_t mix(uint64_t value) {
+    value += 0x9e3779b97f4a7c15ull;
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+    return value ^ (value >> 31);
+}
+
+uint64_t next_random(Rng *rng) {
+    rng->state ^= rng->state >> 12;
+    rng->state ^= rng->state << 25;
+    rng->state ^= rng->state >> 27;
+    return rng->state * 0x2545f4914f6cdd1dull;
+}
+
+uint64_t pack_range(const uint64_t first, const uint64_t end) {
+    return (end << 32) | first;
+}
+
+// Takes the next chunk of the worker's own range
+// @return false if the range is empty
+bool take_chunk(Worker *worker, uint64_t *chunk) {
+    uint64_t range = worker->range.load(std::memory_order_relaxed);
+    while (true) {
+        uint64_t first = range & 0xffffffffu;
+        uint64_t end = range >> 32;
+        if (first >= end) {
+            return false;
+        }
+        if (worker->range.compare_exchange_weak(range, pack_range(first + 1, end),
+                                                std::memory_order_acq_rel)) {
+            *chunk = first;
+            return true;
+        }
+    }
+}
+
+// Moves the upper half of a victim's chunks into the thief's own, empty range
+// @return false if the victim has nothing left
+bool steal_chunks(Worker *thief, Worker *victim) {
+    uint64_t range = victim->range.load(std::memory_order_relaxed);
+    while (true) {
+        uint64_t first = range & 0xffffffffu;
+        uint64_t end = range >> 32;
+        if (first >= end) {
+            return false;
+        }
+        uint64_t middle = end - (end - first + 1) / 2;
+        if (victim->range.compare_exchange_weak(range, pack_range(first, middle),
+                                                std::memory_order_acq_rel)) {
+            thief->range.store(pack_range(middle, end), std::memory_order_release);
+            thief->stats.steals++;
+            return true;
+        }
+    }
+}
+
+// Places the player's mark at cell
+void place(Board *board, const char player, const uint cell) {
+    Mask mask = static_cast<Mask>(static_cast<Mask>(1) << cell);
+    if (player == TicTacToe::X) {
+        board->x |= mask;
+    } else {
+        board->o |= mask;
+    }
+}
+
+// Fills cells with the empty cells of the board
+// @return Number of empty cells
+uint find_empty_cells(const Board &board, uint8_t *cells) {
+    Mask occupied = static_cast<Mask>(board.x | board.o);
+    uint count = 0;
+    for (uint cell = 0; cell < TicTacToe::CELLS; cell++) {
+        if (!(occupied & (static_cast<Mask>(1) << cell))) {
+            cells[count++] = static_cast<uint8_t>(cell);
+        }
+    }
+    return count;
+}
+
+// Returns the first of the empty cells at which the player would win, -1 if none
+int find_winning_cell(const Board &board, const char player, const uint8_t *cells,
+                      const uint count) {
+    for (uint i = 0; i < count; i++) {
+        Board next = board;
+        place(&next, player, cells[i]);
+        if (game.is_win(player, next)) {
+            return cells[i];
+        }
+    }
+    return -1;
+}
+
+// Returns twice the Manhattan distance of cell from the centre of the board
+uint distance_from_centre(const uint cell) {
+    int row = static_cast<int>(cell / TicTacToe::COLS);
+    int col = static_cast<int>(cell % TicTacToe::COLS);
+    return static_cast<uint>(abs(2 * row - (TicTacToe::ROWS - 1)) +
+                             abs(2 * col - (TicTacToe::COLS - 1)));
+}
+
+// Returns the heuristic's move: win, block the opponent's win, or take the
+// most central empty cell (at random among equally central ones)
+uint choose_heuristic(const Board &board, const char player, const uint8_t *cells,
+                      const uint count, Rng *rng) {
+    int cell = find_winning_cell(board, player, cells, count);
+    if (cell < 0) {
+        cell = find_winning_cell(board, game.get_new_player(player), cells, count);
+    }
+    if (cell >= 0) {
+        return static_cast<uint>(cell);
+    }
+
+    uint8_t central[TicTacToe::CELLS];
+    uint number_of_central = 0;
+    uint best = ~0u;
+    for (uint i = 0; i < count; i++) {
+        uint distance = distance_from_centre(cells[i]);
+        if (distance < best) {
+            best = distance;
+            number_of_central = 0;
+        }
+        if (distance == best) {
+            central[number_of_central++] = cells[i];
+        }
+    }
+    return central[next_random(rng) % number_of_central];
+}
+
+// Looks up the solved table's best move, only the classic board has one
+template <typename AnyBoard>
+bool find_perfect_move(const AnyBoard &board, int *cell) {
+    if constexpr (std::is_same<AnyBoard, Bitboard>::value) {
+        int value = Solved3::DRAW;
+        return Solved3::probe(board, &value, cell);
+    } else {
+        (void)board;
+        (void)cell;
+        return false;
+    }
+}
+
+// Returns the move of the policy for the player, the board must not be full
+uint choose_move(const Policy policy, const Board &board, const char player, Rng *rng) {
+    uint8_t cells[TicTacToe::CELLS];
+    uint count = find_empty_cells(board, cells);
+
+    int cell = -1;
+    if (policy == POLICY_PERFECT && find_perfect_move(board, &cell)) {
+        return static_cast<uint>(cell);
+    }
+    if (policy == POLICY_RANDOM) {
+        return cells[next_random(rng) % count];
+    }
+    return choose_heuristic(board, player, cells, count, rng);
+}
+
+// Plays one game and counts its result
+void play_game(const Tournament &tournament, Rng *rng, TournamentStats *stats) {
+    Board board = {0, 0};
+    char player = TicTacToe::X;
+    for (uint moves = 1; moves <= TicTacToe::CELLS; moves++) {
+        Policy policy = (player == TicTacToe::X) ? tournament.x_policy : tournament.o_policy;
+        place(&board, player, choose_move(policy, board, player, rng));
+        if (game.is_win(player, board)) {
+            if (player == TicTacToe::X) {
+                stats->x_wins++;
+            } else {
+                stats->o_wins++;
+            }
+            stats->lengths[moves]++;
+            break;
+        }
+        if (game.is_tie(board)) {
+            stats->draws++;
+            stats->lengths[moves]++;
+            break;
+        }
+        player = game.get_new_player(player);
+    }
+    stats->games++;
+}
+
+// Worker thread: plays its own chunks, then steals from the others until
+// no thread has any left
+void run_worker(const Tournament &tournament, const uint index, const uint threads) {
+    Worker *worker = &workers[index];
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    Rng rng = {1};
+    uint64_t chunk = 0;
+
+    while (true) {
+        while (take_chunk(worker, &chunk)) {
+            rng.state = mix(tournament.seed ^ mix(chunk)) | 1;
+            uint64_t first = chunk * CHUNK_GAMES;
+            uint64_t last = std::min(first + CHUNK_GAMES, tournament.games);
+            for (uint64_t i = first; i < last; i++) {
+                play_game(tournament, &rng, &worker->stats);
+            }
+        }
+
+        // Look for work at the others, starting at a random one
+        bool is_stolen = false;
+        uint offset = static_cast<uint>(next_random(&rng) % threads);
+        for (uint i = 0; i < threads && !is_stolen; i++) {
+            uint victim = (offset + i) % threads;
+            is_stolen = (victim != index) && steal_chunks(worker, &workers[victim]);
+        }
+        if (!is_stolen) {
+            break;
+        }
+    }
+
+    worker->stats.busy_ns = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count());
+}
+
+// Plays the tournament on the given number of threads
+// @param total Set to the merged results of every thread
+// @return Wall time in seconds
+double run_tournament(const Tournament &tournament, const uint threads, TournamentStats *total) {
+    uint64_t chunks = (tournament.games + CHUNK_GAMES - 1) / CHUNK_GAMES;
+    for (uint i = 0; i < threads; i++) {
+        // Deal the chunks out in contiguous ranges
+        workers[i].range.store(pack_range(chunks * i / threads, chunks * (i + 1) / threads));
+        memset(&workers[i].stats, 0, sizeof(workers[i].stats));
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::vector<std::thread> pool;
+    for (uint i = 1; i < threads; i++) {
+        pool.emplace_back(run_worker, std::cref(tournament), i, threads);
+    }
+    run_worker(tournament, 0, threads);
+    for (std::thread &thread : pool) {
+        thread.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    memset(total, 0, sizeof(*total));
+    for (uint i = 0; i < threads; i++) {
+        const TournamentStats &stats = workers[i].stats;
+        total->x_wins += stats.x_wins;
+        total->o_wins += stats.o_wins;
+        total->draws += stats.draws;
+        for (uint moves = 0; moves <= TicTacToe::CELLS; moves++) {
+            total->lengths[moves] += stats.lengths[moves];
+        }
+        total->games += stats.games;
+        total->steals += stats.steals;
+    }
+    return seconds;
+}
+
+double percent(const uint64_t part, const uint64_t whole) {
+    return whole ? 100.0 * static_cast<double>(part) / static_cast<double>(whole) : 0.0;
+}
+
+void print_results(const Tournament &tournament, const uint threads, const TournamentStats &total,
+                   const double seconds) {
+    printf("X %s vs O %s on %ux%u (%u in a row): %llu games on %u threads, seed %llu\n",
+           POLICY_NAMES[tournament.x_policy], POLICY_NAMES[tournament.o_policy],
+           static_cast<uint>(TicTacToe::ROWS), static_cast<uint>(TicTacToe::COLS),
+           static_cast<uint>(TicTacToe::WIN_LENGTH), static_cast<unsigned long long>(total.games),
+           threads, static_cast<unsigned long long>(tournament.seed));
+    printf("X wins %llu (%.2f%%), O wins %llu (%.2f%%), draws %llu (%.2f%%)\n",
+           static_cast<unsigned long long>(total.x_wins), percent(total.x_wins, total.games),
+           static_cast<unsigned long long>(total.o_wins), percent(total.o_wins, total.games),
+           static_cast<unsigned long long>(total.draws), percent(total.draws, total.games));
+
+    printf("Game length:\n");
+    for (uint moves = 0; moves <= TicTacToe::CELLS; moves++) {
+        if (total.lengths[moves] > 0) {
+            printf("  %2u moves %12llu (%6.2f%%)\n", moves,
+                   static_cast<unsigned long long>(total.lengths[moves]),
+                   percent(total.lengths[moves], total.games));
+        }
+    }
+
+    for (uint i = 0; i < threads; i++) {
+        const TournamentStats &stats = workers[i].stats;
+        double busy = static_cast<double>(stats.busy_ns) / 1e9;
+        printf("Thread %3u: %10llu games, %3llu steals, %12.0f games/s\n", i,
+               static_cast<unsigned long long>(stats.games),
+               static_cast<unsigned long long>(stats.steals),
+               busy > 0 ? static_cast<double>(stats.games) / busy : 0.0);
+    }
+    printf("Total: %.0f games/s in %.3f s (%llu steals)\n",
+           static_cast<double>(total.games) / seconds, seconds,
+           static_cast<unsigned long long>(total.steals));
+}
+
+// Plays the tournament on 1, 2, 4, ... threads and prints the speedup
+void run_scaling(const Tournament &tournament, const uint max_threads) {
+    double base = 0.0;
+    for (uint threads = 1; ; threads = std::min(2 * threads, max_threads)) {
+        TournamentStats total;
+        double seconds = run_tournament(tournament, threads, &total);
+        double rate = static_cast<double>(total.games) / seconds;
+        base = (threads == 1) ? rate : base;
+        printf("%3u threads: %12.0f games/s, speedup %5.2f, efficiency %5.1f%%\n", threads, rate,
+               rate / base, 100.0 * rate / base / threads);
+        if (threads == max_threads) {
+            break;
+        }
+    }
+}
+
+bool parse_policy(const char *name, Policy *policy) {
+    for (uint i = 0; i < sizeof(POLICY_NAMES) / sizeof(POLICY_NAMES[0]); i++) {
+        if (strcmp(name, POLICY_NAMES[i]) == 0) {
+            *policy = static_cast<Policy>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+void usage() {
+    fputs("Usage: tictactoe_tournament [--x POLICY] [--o POLICY] [--games N]\n"
+          "                            [--threads N] [--seed N] [--scaling]\n"
+          "\n"
+          "Plays N games (default 1000000) of X against O on every core and prints\n"
+          "the win, draw and loss counts, the game lengths and the games/s of each\n"
+          "thread. POLICY is random (default), heuristic (win, block, centre) or\n"
+          "perfect (3x3 only). The results depend only on the seed. --scaling plays\n"
+          "the tournament on 1, 2, 4, ... threads and prints the speedup.\n", stderr);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    Tournament tournament = {POLICY_RANDOM, POLICY_RANDOM, 1000000, 1};
+    uint threads = std::max(1u, std::thread::hardware_concurrency());
+    bool is_scaling = false;
+
+    for (int i = 1; i < argc; i++) {
+        bool is_valid = true;
+        if (strcmp(argv[i], "--x") == 0 && i + 1 < argc) {
+            is_valid = parse_policy(argv[++i], &tournament.x_policy);
+        } else if (strcmp(argv[i], "--o") == 0 && i + 1 < argc) {
+            is_valid = parse_policy(argv[++i], &tournament.o_policy);
+        } else if (strcmp(argv[i], "--games") == 0 && i + 1 < argc) {
+            tournament.games = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = static_cast<uint>(atoi(argv[++i]));
+            is_valid = threads >= 1 && threads <= MAX_THREADS;
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            tournament.seed = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--scaling") == 0) {
+            is_scaling = true;
+        } else {
+            is_valid = false;
+        }
+        if (!is_valid) {
+            usage();
+            return 1;
+        }
+    }
+
+    bool is_classic = TicTacToe::ROWS == 3 && TicTacToe::COLS == 3 && TicTacToe::WIN_LENGTH == 3;
+    if (!is_classic && (tournament.x_policy == POLICY_PERFECT ||
+                        tournament.o_policy == POLICY_PERFECT)) {
+        fputs("Perfect play is only tabled for the 3x3 board\n", stderr);
+        return 1;
+    }
+    if (tournament.games / CHUNK_GAMES >= 0xffffffffu) {
+        fputs("Too many games\n", stderr);
+        return 1;
+    }
+
+    threads = std::min(threads, MAX_THREADS);
+    if (is_scaling) {
+        run_scaling(tournament, threads);
+        return 0;
+    }
+
+    TournamentStats total;
+    double seconds = run_tournament(tournament, threads, &total);
+    print_results(tournament, threads, total, seconds);
+    return 0;
+}
@@ -0,0 +1,319 @@
+#include "trace.hpp"
+#include "move_log.hpp"
+#include "hardware/sync.h"
+#include "pico/platform.h"
+#include "pico/time.h"
+#include <string.h>
+
+#if PICO_ON_DEVICE
+#include "hardware/clocks.h"
+#include "hardware/structs/systick.h"
+#else
+#include <time.h>
+#endif
+
+const uint8_t Trace::MAGIC[3] = {'T', 'R', 'C'};
+
+static const char *POINT_NAMES[NUMBER_OF_TRACE_POINTS] = {
+    "debounce",
+    "handle_btn1",
+    "handle_btn2",
+    "is_win",
+    "print_board",
+    "channel_send",
+    "channel_receive",
+};
+
+// Size of the fixed part of a histogram in the dump, before its buckets
+static const size_t HISTOGRAM_HEADER_SIZE = 22;
+static const size_t EVENT_SIZE = 9;
+static const size_t HEADER_SIZE = 9;
+
+const char *Trace::get_point_name(const uint point) {
+    return (point < NUMBER_OF_TRACE_POINTS) ? POINT_NAMES[point] : "?";
+}
+
+// Returns the little-endian value of the bytes at data
+static uint64_t read_le(const uint8_t *data, const uint bytes) {
+    uint64_t value = 0;
+    for (uint i = 0; i < bytes; i++) {
+        value |= static_cast<uint64_t>(data[i]) << (8 * i);
+    }
+    return value;
+}
+
+int Trace::decode(const uint8_t *data, const size_t length, Dump *dump, size_t *used) {
+    // Find the magic
+    size_t start = 0;
+    while (start + sizeof(MAGIC) <= length && memcmp(data + start, MAGIC, sizeof(MAGIC)) != 0) {
+        start++;
+    }
+    if (start + HEADER_SIZE > length) {
+        // Keep what may be the start of a dump
+        *used = start;
+        return 0;
+    }
+
+    const uint8_t *header = data + start;
+    if (header[3] != VERSION || header[6] != NUMBER_OF_CORES ||
+        header[7] != NUMBER_OF_TRACE_POINTS || header[8] != RING_SIZE) {
+        *used = start + sizeof(MAGIC);
+        return -1;
+    }
+    memset(dump, 0, sizeof(*dump));
+    dump->cycles_per_us = static_cast<uint16_t>(read_le(header + 4, 2));
+
+    // Walk the variable-length parts, checking each fits
+    size_t at = start + HEADER_SIZE;
+    for (uint core = 0; core < NUMBER_OF_CORES; core++) {
+        for (uint point = 0; point < NUMBER_OF_TRACE_POINTS; point++) {
+            if (at + HISTOGRAM_HEADER_SIZE > length) {
+                *used = start;
+                return 0;
+            }
+            TraceHistogram &histogram = dump->histograms[core][point];
+            histogram.count = static_cast<uint32_t>(read_le(data + at, 4));
+            histogram.min = static_cast<uint32_t>(read_le(data + at + 4, 4));
+            histogram.max = static_cast<uint32_t>(read_le(data + at + 8, 4));
+            histogram.total = read_le(data + at + 12, 8);
+            uint first = data[at + 20];
+            uint count = data[at + 21];
+            at += HISTOGRAM_HEADER_SIZE;
+            if (first + count > NUMBER_OF_BUCKETS) {
+                *used = start + sizeof(MAGIC);
+                return -1;
+            }
+            if (at + 4 * count > length) {
+                *used = start;
+                return 0;
+            }
+            for (uint i = 0; i < count; i++) {
+                histogram.buckets[first + i] = static_cast<uint32_t>(read_le(data + at + 4 * i, 4));
+            }
+            at += 4 * count;
+        }
+    }
+    for (uint core = 0; core < NUMBER_OF_CORES; core++) {
+        if (at + 2 > length) {
+            *used = start;
+            return 0;
+        }
+        uint count = static_cast<uint>(read_le(data + at, 2));
+        at += 2;
+        if (count > RING_SIZE) {
+            *used = start + sizeof(MAGIC);
+            return -1;
+        }
+        if (at + count * EVENT_SIZE > length) {
+            *used = start;
+            return 0;
+        }
+        for (uint i = 0; i < count; i++) {
+            TraceEvent &event = dump->events[core][i];
+            event.start_us = static_cast<uint32_t>(read_le(data + at, 4));
+            event.cycles = static_cast<uint32_t>(read_le(data + at + 4, 4));
+            event.point = data[at + 8];
+            at += EVENT_SIZE;
+        }
+        dump->event_counts[core] = static_cast<uint16_t>(count);
+    }
+    if (at + 1 > length) {
+        *used = start;
+        return 0;
+    }
+
+    const size_t covered = at - (start + sizeof(MAGIC));
+    if (GameRecords::crc8(data + start + sizeof(MAGIC), covered) != data[at]) {
+        *used = start + sizeof(MAGIC);
+        return -1;
+    }
+    *used = at + 1;
+    return 1;
+}
+
+#ifdef TRACE
+
+TraceHistogram Trace::histograms[NUMBER_OF_CORES][NUMBER_OF_TRACE_POINTS];
+TraceEvent Trace::rings[NUMBER_OF_CORES][RING_SIZE];
+uint32_t Trace::heads[NUMBER_OF_CORES];
+
+#if PICO_ON_DEVICE
+static uint32_t cycles_per_us = 125;
+#else
+static const uint32_t cycles_per_us = 1000;
+#endif
+
+// Bytes of the dump collected before they go to the sink, and their CRC
+static uint8_t chunk[64];
+static size_t chunk_length = 0;
+static uint8_t dump_crc = 0;
+
+// Appends the little-endian value to the dump, passing full chunks on
+static void put(Trace::Sink sink, const uint64_t value, const uint bytes) {
+    for (uint i = 0; i < bytes; i++) {
+        if (chunk_length == sizeof(chunk)) {
+            sink(chunk, chunk_length);
+            chunk_length = 0;
+        }
+        uint8_t byte = static_cast<uint8_t>(value >> (8 * i));
+        dump_crc = GameRecords::crc8(&byte, 1, dump_crc);
+        chunk[chunk_length++] = byte;
+    }
+}
+
+void Trace::init_core() {
+#if PICO_ON_DEVICE
+    // Count down from 2^24 - 1 with the core clock, no interrupt
+    systick_hw->rvr = 0x00ffffff;
+    systick_hw->cvr = 0;
+    systick_hw->csr = 0x5;
+    cycles_per_us = clock_get_hz(clk_sys) / 1000000;
+#endif
+    reset();
+}
+
+TraceStamp Trace::now() {
+#if PICO_ON_DEVICE
+    TraceStamp stamp = {time_us_32(), systick_hw->cvr};
+#else
+    // Wall time, as reading the simulator's clock would move it on
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    uint64_t ns = static_cast<uint64_t>(now.tv_sec) * 1000000000 + static_cast<uint64_t>(now.tv_nsec);
+    TraceStamp stamp = {static_cast<uint32_t>(ns / 1000), static_cast<uint32_t>(ns)};
+#endif
+    return stamp;
+}
+
+void Trace::record(const TracePoint point, const TraceStamp &start) {
+    TraceStamp end = now();
+    uint32_t us = end.us - start.us;
+
+    // The cycle counter only covers short sections, beyond half its range
+    // the microseconds count
+    uint32_t cycles = (us < UINT32_MAX / cycles_per_us) ? us * cycles_per_us : UINT32_MAX;
+#if PICO_ON_DEVICE
+    if (us < (1u << 23) / cycles_per_us) {
+        // SysTick counts down
+        cycles = (start.cycles - end.cycles) & 0x00ffffff;
+    }
+#else
+    if (us < 1000000) {
+        cycles = end.cycles - start.cycles;
+    }
+#endif
+
+    uint core = get_core_num();
+    uint32_t status = save_and_disable_interrupts();
+    TraceHistogram &histogram = histograms[core][point];
+    if (histogram.count == 0 || cycles < histogram.min) {
+        histogram.min = cycles;
+    }
+    if (cycles > histogram.max) {
+        histogram.max = cycles;
+    }
+    histogram.count++;
+    histogram.total += cycles;
+    uint bucket = (cycles == 0) ? 0 : 32 - __builtin_clz(cycles);
+    histogram.buckets[(bucket < NUMBER_OF_BUCKETS) ? bucket : NUMBER_OF_BUCKETS - 1]++;
+
+    TraceEvent &event = rings[core][heads[core] % RING_SIZE];
+    event.start_us = start.us;
+    event.cycles = cycles;
+    event.point = point;
+    heads[core]++;
+    restore_interrupts(status);
+}
+
+void Trace::reset() {
+    uint core = get_core_num();
+    uint32_t status = save_and_disable_interrupts();
+    memset(histograms[core], 0, sizeof(histograms[core]));
+    heads[core] = 0;
+    restore_interrupts(status);
+}
+
+void Trace::dump(Sink sink) {
+    chunk_length = 0;
+    for (uint i = 0; i < sizeof(MAGIC); i++) {
+        chunk[chunk_length++] = MAGIC[i];
+    }
+    dump_crc = 0;
+    put(sink, VERSION, 1);
+    put(sink, cycles_per_us, 2);
+    put(sink, NUMBER_OF_CORES, 1);
+    put(sink, NUMBER_OF_TRACE_POINTS, 1);
+    put(sink, RING_SIZE, 1);
+
+    // Copied one histogram or event at a time, so the stack stays small.
+    // Core 0's trace points in IRQ handlers can't tear a copy, core 1's
+    // statistics may be one sample apart from each other
+    for (uint core = 0; core < NUMBER_OF_CORES; core++) {
+        for (uint point = 0; point < NUMBER_OF_TRACE_POINTS; point++) {
+            uint32_t status = save_and_disable_interrupts();
+            TraceHistogram histogram = histograms[core][point];
+            restore_interrupts(status);
+
+            // Only the buckets from the first to the last used one
+            uint first = 0;
+            uint last = 0;
+            for (uint bucket = 0; bucket < NUMBER_OF_BUCKETS; bucket++) {
+                if (histogram.buckets[bucket] != 0) {
+                    first = (last == 0) ? bucket : first;
+                    last = bucket + 1;
+                }
+            }
+            put(sink, histogram.count, 4);
+            put(sink, histogram.min, 4);
+            put(sink, histogram.max, 4);
+            put(sink, histogram.total, 8);
+            put(sink, first, 1);
+            put(sink, last - first, 1);
+            for (uint bucket = first; bucket < last; bucket++) {
+                put(sink, histogram.buckets[bucket], 4);
+            }
+        }
+    }
+
+    for (uint core = 0; core < NUMBER_OF_CORES; core++) {
+        uint32_t head = heads[core];
+        uint32_t count = (head < RING_SIZE) ? head : RING_SIZE;
+        put(sink, count, 2);
+        for (uint32_t i = head - count; i != head; i++) {
+            uint32_t status = save_and_disable_interrupts();
+            TraceEvent event = rings[core][i % RING_SIZE];
+            restore_interrupts(status);
+            put(sink, event.start_us, 4);
+            put(sink, event.cycles, 4);
+            put(sink, event.point, 1);
+        }
+    }
+
+    // The CRC itself isn't covered
+    uint8_t crc = dump_crc;
+    put(sink, crc, 1);
+    sink(chunk, chunk_length);
+    chunk_length = 0;
+}
+
+#else
+
+void Trace::init_core() {}
+
+TraceStamp Trace::now() {
+    TraceStamp stamp = {0, 0};
+    return stamp;
+}
+
+void Trace::record(const TracePoint point, const TraceStamp &start) {
+    (void)point;
+    (void)start;
+}
+
+void Trace::reset() {}
+
+void Trace::dump(Sink sink) {
+    (void)sink;
+}
+
+#endif
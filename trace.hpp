@@ -0,0 +1,156 @@
+#ifndef __TRACE_HPP__
+#define __TRACE_HPP__
+
+#include "pico/stdlib.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// Code sections timed by the trace points
+enum TracePoint : uint8_t {
+    TRACE_DEBOUNCE = 0,     // Input's edge and lockout interrupt handlers
+    TRACE_BTN1,             // Game::dispatch of a cursor event, with the frame
+    TRACE_BTN2,             // Game::dispatch of a place event, with the engine's reply
+    TRACE_IS_WIN,           // Game::is_win and Game::is_win_at
+    TRACE_PRINT_BOARD,      // Game::print_board
+    TRACE_CHANNEL_SEND,     // Channel::send, queue and FIFO push
+    TRACE_CHANNEL_RECEIVE,  // Channel::receive of a message, FIFO drain and pop
+    NUMBER_OF_TRACE_POINTS
+};
+
+// Struct for storing the start of a traced section
+// @field us Low 32 bits of the microsecond clock
+// @field cycles Cycle counter (SysTick on the Pico, nanoseconds on the host)
+typedef struct {
+    uint32_t us;
+    uint32_t cycles;
+} TraceStamp;
+
+// Struct for storing a latency histogram
+// @field count Number of samples
+// @field min Fewest cycles
+// @field max Most cycles
+// @field total Sum of the cycles, for the average
+// @field buckets Samples by bit length of their cycles: bucket b holds
+//        [2^(b-1), 2^b), bucket 0 holds 0
+typedef struct {
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t total;
+    uint32_t buckets[32];
+} TraceHistogram;
+
+// Struct for storing one traced section in the event ring
+// @field start_us Low 32 bits of the microsecond clock at the start
+// @field cycles Duration in cycles
+// @field point TracePoint
+typedef struct {
+    uint32_t start_us;
+    uint32_t cycles;
+    uint8_t point;
+} TraceEvent;
+
+// Hot-path latency tracing
+// Trace points record the cycles a section took into a per-core histogram
+// per point and a per-core ring of the latest events, in RAM. Short
+// sections are timed with SysTick, which counts core cycles but wraps after
+// 2^24 of them (134 ms at 125 MHz), longer ones with the microsecond timer.
+// Interrupts are disabled while a sample is added, so an IRQ handler's
+// trace point can't tear it; each core only writes its own data.
+//
+// Tracing is built with the TICTACTOE_TRACE CMake option (defining TRACE).
+// Without it the TRACE_* macros expand to nothing and no RAM is reserved;
+// only the dump format and its decoder remain, for the host tools.
+//
+// Dump format, little-endian:
+//   'T' 'R' 'C' version | cycles per us (16) | cores | points | ring size
+//   per core, per point: count (32), min (32), max (32), total (64),
+//     first bucket, number of buckets, the bucket counts (32 each)
+//   per core: number of events (16), events oldest first:
+//     start us (32), cycles (32), point
+//   CRC-8 of everything after the magic
+class Trace {
+    public:
+        static const uint8_t MAGIC[3];
+        static const uint8_t VERSION = 1;
+        static const uint NUMBER_OF_CORES = 2;
+        static const uint NUMBER_OF_BUCKETS = 32;
+        static const uint RING_SIZE = 64;
+        static const char COMMAND = 't';   // Character that asks for a dump over USB
+
+        // Function that writes a part of the dump
+        typedef void (*Sink)(const uint8_t *data, size_t length);
+
+        // Struct for storing a decoded dump
+        // @field cycles_per_us Clock of the cycle counts
+        // @field histograms Histograms per core and point
+        // @field events Events per core, oldest first
+        // @field event_counts Number of events per core
+        typedef struct {
+            uint16_t cycles_per_us;
+            TraceHistogram histograms[NUMBER_OF_CORES][NUMBER_OF_TRACE_POINTS];
+            TraceEvent events[NUMBER_OF_CORES][RING_SIZE];
+            uint16_t event_counts[NUMBER_OF_CORES];
+        } Dump;
+
+        // Starts the cycle counter of the calling core, call once on each
+        static void init_core();
+
+        // Returns the current time
+        static TraceStamp now();
+
+        // Adds the section from start until now to the point's statistics
+        static void record(const TracePoint point, const TraceStamp &start);
+
+        // Writes the dump of both cores' data
+        static void dump(Sink sink);
+
+        // Forgets the recorded data of the calling core
+        static void reset();
+
+        // Decodes the first dump in data, skipping anything before its magic
+        // @param used Set to the number of bytes up to the end of the dump, or
+        //        up to where the search stopped
+        // @return 1 if a dump was decoded, 0 if there is none (or only the
+        //         start of one), -1 if one was found but failed its CRC or checks
+        static int decode(const uint8_t *data, const size_t length, Dump *dump, size_t *used);
+
+        // Returns the name of the trace point
+        static const char *get_point_name(const uint point);
+
+#ifdef TRACE
+    private:
+        static TraceHistogram histograms[NUMBER_OF_CORES][NUMBER_OF_TRACE_POINTS];
+        static TraceEvent rings[NUMBER_OF_CORES][RING_SIZE];
+        static uint32_t heads[NUMBER_OF_CORES];
+#endif
+};
+
+#ifdef TRACE
+
+// Times the rest of the enclosing scope
+class TraceScope {
+    public:
+        explicit TraceScope(const TracePoint point) : point(point), start(Trace::now()) {}
+        ~TraceScope() {
+            Trace::record(point, start);
+        }
+
+    private:
+        TracePoint point;
+        TraceStamp start;
+};
+
+#define TRACE_SCOPE(point) TraceScope trace_scope(point)
+#define TRACE_BEGIN(stamp) const TraceStamp stamp = Trace::now()
+#define TRACE_END(point, stamp) Trace::record(point, stamp)
+
+#else
+
+#define TRACE_SCOPE(point) do {} while (0)
+#define TRACE_BEGIN(stamp) do {} while (0)
+#define TRACE_END(point, stamp) do {} while (0)
+
+#endif
+
+#endif  // __TRACE_HPP__
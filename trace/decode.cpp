@@ -0,0 +1,157 @@
+#include "trace.hpp"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+// Trace dump decoder
+// Finds the trace dumps in captures of the USB serial output and prints,
+// per core and trace point, the number of samples, their minimum, average
+// and maximum in microseconds and a bar per histogram bucket, followed by
+// the latest events. Everything else in the capture is skipped
+
+namespace {
+
+// Width of the longest histogram bar
+const uint BAR_WIDTH = 40;
+
+double to_us(const uint64_t cycles, const uint cycles_per_us) {
+    return static_cast<double>(cycles) / cycles_per_us;
+}
+
+void print_histogram(const TraceHistogram &histogram, const uint cycles_per_us) {
+    uint32_t most = 0;
+    for (uint bucket = 0; bucket < Trace::NUMBER_OF_BUCKETS; bucket++) {
+        if (histogram.buckets[bucket] > most) {
+            most = histogram.buckets[bucket];
+        }
+    }
+    for (uint bucket = 0; bucket < Trace::NUMBER_OF_BUCKETS; bucket++) {
+        uint32_t count = histogram.buckets[bucket];
+        if (count == 0) {
+            continue;
+        }
+        // Bucket b holds [2^(b-1), 2^b) cycles
+        uint64_t low = (bucket == 0) ? 0 : 1ull << (bucket - 1);
+        uint64_t high = 1ull << bucket;
+        uint length = static_cast<uint>((static_cast<uint64_t>(count) * BAR_WIDTH + most - 1) / most);
+        printf("    %10.3f - %10.3f us %8u |", to_us(low, cycles_per_us),
+               to_us(high, cycles_per_us), static_cast<uint>(count));
+        for (uint i = 0; i < length; i++) {
+            putchar('#');
+        }
+        putchar('\n');
+    }
+}
+
+void print_dump(const Trace::Dump &dump, const uint number, const bool is_verbose) {
+    const uint cycles_per_us = (dump.cycles_per_us != 0) ? dump.cycles_per_us : 1;
+    printf("Dump %u (%u cycles/us)\n", number, cycles_per_us);
+
+    for (uint core = 0; core < Trace::NUMBER_OF_CORES; core++) {
+        for (uint point = 0; point < NUMBER_OF_TRACE_POINTS; point++) {
+            const TraceHistogram &histogram = dump.histograms[core][point];
+            if (histogram.count == 0) {
+                continue;
+            }
+            printf("  core %u %-16s %8u samples, min %10.3f, avg %10.3f, max %10.3f us\n", core,
+                   Trace::get_point_name(point), static_cast<uint>(histogram.count),
+                   to_us(histogram.min, cycles_per_us),
+                   to_us(histogram.total, cycles_per_us) / histogram.count,
+                   to_us(histogram.max, cycles_per_us));
+            if (is_verbose) {
+                print_histogram(histogram, cycles_per_us);
+            }
+        }
+    }
+
+    for (uint core = 0; core < Trace::NUMBER_OF_CORES; core++) {
+        if (dump.event_counts[core] == 0) {
+            continue;
+        }
+        printf("  core %u, latest %u events:\n", core, static_cast<uint>(dump.event_counts[core]));
+        for (uint i = 0; i < dump.event_counts[core]; i++) {
+            const TraceEvent &event = dump.events[core][i];
+            printf("    %12u us  %-16s %10.3f us\n", static_cast<uint>(event.start_us),
+                   Trace::get_point_name(event.point), to_us(event.cycles, cycles_per_us));
+        }
+    }
+}
+
+// Appends the contents of the file, "-" for stdin
+// @return false if it can't be read
+bool read_file(const char *path, std::vector<uint8_t> *data) {
+    FILE *file = (strcmp(path, "-") == 0) ? stdin : fopen(path, "rb");
+    if (file == nullptr) {
+        return false;
+    }
+    uint8_t buffer[4096];
+    size_t length = 0;
+    while ((length = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        data->insert(data->end(), buffer, buffer + length);
+    }
+    if (file != stdin) {
+        fclose(file);
+    }
+    return true;
+}
+
+void usage() {
+    fputs("Usage: tictactoe_trace [--histograms] [capture ...]\n"
+          "\n"
+          "Finds the trace dumps in captures of the Pico's USB serial output (or of\n"
+          "tictactoe_host) and prints their latency statistics and latest events.\n"
+          "Dumps are sent for a 't' typed into a TICTACTOE_TRACE build. Reads stdin\n"
+          "without captures, or for \"-\". --histograms adds the bucket bars.\n"
+          "Exits with 1 if no dump was found or one is corrupt.\n",
+          stderr);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    bool is_verbose = false;
+    std::vector<const char *> paths;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--histograms") == 0) {
+            is_verbose = true;
+        } else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+            usage();
+            return 1;
+        } else {
+            paths.push_back(argv[i]);
+        }
+    }
+    if (paths.empty()) {
+        paths.push_back("-");
+    }
+
+    // Too big for the stack
+    static Trace::Dump dump;
+    uint dumps = 0;
+    uint corrupt = 0;
+    for (const char *path : paths) {
+        std::vector<uint8_t> data;
+        if (!read_file(path, &data)) {
+            fprintf(stderr, "Cannot read %s\n", path);
+            return 1;
+        }
+        size_t offset = 0;
+        while (offset < data.size()) {
+            size_t used = 0;
+            int found = Trace::decode(data.data() + offset, data.size() - offset, &dump, &used);
+            offset += used;
+            if (found == 0) {
+                break;
+            }
+            if (found < 0) {
+                corrupt++;
+                continue;
+            }
+            print_dump(dump, ++dumps, is_verbose);
+        }
+    }
+
+    printf("%u dumps, %u corrupt\n", dumps, corrupt);
+    return (dumps == 0 || corrupt > 0) ? 1 : 0;
+}